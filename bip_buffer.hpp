@@ -0,0 +1,214 @@
+/**
+ * @file   bip_buffer.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sun Oct 18 00:48:33 2026
+ *
+ * @brief  Single-reader-single-writer bip buffer for contiguous records
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#pragma once
+
+#include <sps/cenv.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+
+namespace sps
+{
+
+//! Bip buffer
+/*!
+  Ring buffer handing out contiguous regions only, see S. Cooke's
+  BipBuffer (BipBuffer.h). A record is never split at the end of the
+  buffer: if it does not fit, it is placed at the beginning and the
+  end of the data is marked by a watermark, which the reader wraps
+  at. Hence the producer writes records of any length in place and
+  the consumer reads them in place.
+
+  One thread may write using @ref reserve / @ref commit and one thread
+  may read using @ref peek / @ref consume concurrently. Positions are
+  64-bit and published using release / acquire.
+
+  \code
+  sps::BipBuffer<unsigned char> buffer(1 << 20);
+  // Producer
+  if (unsigned char* pRecord = buffer.reserve(length))
+  {
+    Encode(pRecord, length);
+    buffer.commit(length);
+  }
+  // Consumer
+  auto block = buffer.peek();
+  size_t nUsed = Decode(block.data, block.size);
+  buffer.consume(nUsed);
+  \endcode
+*/
+template <typename T>
+class BipBuffer
+{
+public:
+  //! Contiguous block of committed elements
+  struct Span
+  {
+    const T* data; ///< First element
+    size_t size;   ///< Number of elements
+  };
+
+  /**
+   * Ctor
+   *
+   * @param capacity Number of elements
+   *
+   * @throws std::invalid_argument if capacity is zero
+   */
+  explicit BipBuffer(const size_t capacity)
+    : m_nSize{ capacity }
+    , m_pBuffer{ capacity > 0 ? new T[capacity]() : nullptr }
+  {
+    if (capacity == 0)
+    {
+      throw std::invalid_argument("Capacity must be positive");
+    }
+  }
+
+  size_t size() const { return m_nSize; }
+
+  /**
+   * Reserve a contiguous region for writing. Only one reservation may
+   * be outstanding.
+   *
+   * @param n Number of elements
+   *
+   * @return Region of n elements or nullptr if not available
+   */
+  T* reserve(const size_t n)
+  {
+    const size_t iWrite = m_iWrite.load(std::memory_order_relaxed);
+    const size_t iRead = m_iRead.load(std::memory_order_acquire);
+    size_t iStart = 0;
+    if (n == 0)
+    {
+      return nullptr;
+    }
+    if (iWrite >= iRead)
+    {
+      if (m_nSize - iWrite >= n)
+      {
+        iStart = iWrite;
+      }
+      else if (iRead > n)
+      {
+        // Wrap, the write position must stay behind the read position
+        iStart = 0;
+      }
+      else
+      {
+        return nullptr;
+      }
+    }
+    else if (iRead - iWrite > n)
+    {
+      iStart = iWrite;
+    }
+    else
+    {
+      return nullptr;
+    }
+    m_iReserved = iStart;
+    m_nReserved = n;
+    return m_pBuffer.get() + iStart;
+  }
+
+  /**
+   * Publish elements written to the region reserved
+   *
+   * @param n Number of elements, at most the number reserved. Zero
+   *          cancels the reservation
+   */
+  void commit(size_t n)
+  {
+    n = n < m_nReserved ? n : m_nReserved;
+    m_nReserved = 0;
+    if (n == 0)
+    {
+      return;
+    }
+    const size_t iWrite = m_iWrite.load(std::memory_order_relaxed);
+    if (m_iReserved < iWrite)
+    {
+      // Wrapped, data ends at the old write position
+      m_iWatermark.store(iWrite, std::memory_order_relaxed);
+    }
+    m_iWrite.store(m_iReserved + n, std::memory_order_release);
+  }
+
+  /**
+   * First contiguous block of committed elements
+   *
+   * @return Block, empty if nothing is committed
+   */
+  Span peek()
+  {
+    size_t iRead = m_iRead.load(std::memory_order_relaxed);
+    const size_t iWrite = m_iWrite.load(std::memory_order_acquire);
+    size_t iEnd = iWrite;
+    if (iWrite < iRead)
+    {
+      const size_t iWatermark = m_iWatermark.load(std::memory_order_relaxed);
+      if (iRead == iWatermark)
+      {
+        iRead = 0;
+      }
+      else
+      {
+        iEnd = iWatermark;
+      }
+    }
+    m_iPeeked = iRead;
+    return Span{ m_pBuffer.get() + iRead, iEnd - iRead };
+  }
+
+  /**
+   * Release elements from the block returned by @ref peek
+   *
+   * @param n Number of elements, at most the size of the block
+   */
+  void consume(const size_t n) { m_iRead.store(m_iPeeked + n, std::memory_order_release); }
+
+  /**
+   * Is the buffer empty
+   *
+   * @return
+   */
+  bool empty() const
+  {
+    return m_iRead.load(std::memory_order_acquire) == m_iWrite.load(std::memory_order_acquire);
+  }
+
+private:
+  BipBuffer(const BipBuffer& rhs) = delete;
+  BipBuffer& operator=(const BipBuffer& rhs) = delete;
+
+  const size_t m_nSize;           ///< Capacity
+  std::unique_ptr<T[]> m_pBuffer; ///< Elements
+
+  SPS_ALIGNAS(64) std::atomic<size_t> m_iWrite{ 0 }; ///< Write position, owned by writer
+  std::atomic<size_t> m_iWatermark{ 0 };             ///< End of data before wrap
+  size_t m_iReserved{ 0 };                           ///< Start of reservation, writer only
+  size_t m_nReserved{ 0 };                           ///< Size of reservation, writer only
+
+  SPS_ALIGNAS(64) std::atomic<size_t> m_iRead{ 0 }; ///< Read position, owned by reader
+  size_t m_iPeeked{ 0 };                            ///< Start of block peeked, reader only
+};
+
+} // namespace sps
+
+/* Local variables: */
+/* indent-tabs-mode: nil */
+/* tab-width: 2 */
+/* c-basic-offset: 2 */
+/* End: */
@@ -0,0 +1,128 @@
+/**
+ * @file   bip_buffer_test.cpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sun Oct 18 01:07:52 2026
+ *
+ * @brief  Tests of sps::BipBuffer
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#include <gtest/gtest.h>
+#include <sps/cenv.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+
+#include <sps/bip_buffer.hpp>
+
+TEST(bip_buffer_test, wrap)
+{
+  EXPECT_THROW(sps::BipBuffer<int>(0), std::invalid_argument);
+
+  sps::BipBuffer<int> buffer(10);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(buffer.peek().size, 0u);
+
+  int* pRecord = buffer.reserve(8);
+  ASSERT_NE(pRecord, nullptr);
+  for (int i = 0; i < 8; i++)
+  {
+    pRecord[i] = i;
+  }
+  buffer.commit(8);
+  auto block = buffer.peek();
+  ASSERT_EQ(block.size, 8u);
+  EXPECT_EQ(block.data[7], 7);
+  buffer.consume(6);
+
+  // Does not fit at the end, placed at the beginning
+  pRecord = buffer.reserve(7);
+  EXPECT_EQ(pRecord, nullptr);
+  pRecord = buffer.reserve(3);
+  ASSERT_NE(pRecord, nullptr);
+  pRecord[0] = 10;
+  pRecord[1] = 11;
+  buffer.commit(2);
+
+  // Remainder before the watermark, then the wrapped record
+  block = buffer.peek();
+  ASSERT_EQ(block.size, 2u);
+  EXPECT_EQ(block.data[0], 6);
+  buffer.consume(2);
+  block = buffer.peek();
+  ASSERT_EQ(block.size, 2u);
+  EXPECT_EQ(block.data[0], 10);
+  EXPECT_EQ(block.data[1], 11);
+
+  // Writing behind the reader
+  EXPECT_EQ(buffer.reserve(8), nullptr);
+  buffer.consume(2);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_NE(buffer.reserve(8), nullptr);
+  buffer.commit(0);
+  EXPECT_TRUE(buffer.empty());
+}
+
+/**
+ * Test streaming variable-length records between two threads. Every
+ * record is contiguous and arrives intact.
+ *
+ */
+TEST(bip_buffer_test, records)
+{
+  sps::BipBuffer<uint32_t> buffer(1000);
+  const uint32_t nRecords = 20000;
+
+  std::thread producer(
+    [&]()
+    {
+      for (uint32_t i = 0; i < nRecords; i++)
+      {
+        const uint32_t length = 1 + i % 97;
+        uint32_t* pRecord = nullptr;
+        while (!(pRecord = buffer.reserve(length + 1)))
+        {
+          std::this_thread::yield();
+        }
+        pRecord[0] = length;
+        for (uint32_t j = 1; j <= length; j++)
+        {
+          pRecord[j] = i;
+        }
+        buffer.commit(length + 1);
+      }
+    });
+
+  bool valid = true;
+  uint32_t iRecord = 0;
+  while (iRecord < nRecords)
+  {
+    auto block = buffer.peek();
+    if (block.size == 0)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    size_t offset = 0;
+    while (offset < block.size)
+    {
+      const uint32_t length = block.data[offset];
+      valid = valid && length == 1 + iRecord % 97 && offset + 1 + length <= block.size &&
+        block.data[offset + length] == iRecord;
+      offset += 1 + length;
+      iRecord++;
+    }
+    buffer.consume(block.size);
+  }
+  producer.join();
+  EXPECT_TRUE(valid);
+  EXPECT_TRUE(buffer.empty());
+}
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,216 @@
+/**
+ * @file   cancellation.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sat Oct 17 22:20:37 2026
+ *
+ * @brief  Cancellation tokens for work submitted to sps::ThreadPool
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#pragma once
+
+#include <sps/cenv.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace sps
+{
+
+//! Exception reported by the future of a cancelled task
+class TaskCancelled : public std::runtime_error
+{
+public:
+  TaskCancelled()
+    : std::runtime_error("Task cancelled")
+  {
+  }
+};
+
+namespace detail
+{
+
+//! Cancellation hook
+/*!
+  Interface of work attached to a cancellation token, e.g. a queued
+  task. Cancelling must be idempotent and thread-safe.
+*/
+class CancellationHook
+{
+public:
+  virtual ~CancellationHook() = default;
+
+  /**
+   * Cancel the work, unless started
+   *
+   * @return True if the work was cancelled before it started
+   */
+  virtual bool cancel() = 0;
+};
+
+//! State shared by a cancellation source and its tokens
+class CancellationState
+{
+public:
+  /**
+   * Attach a hook. Hooks are held weakly, such that completed work is
+   * released.
+   *
+   * @param pHook
+   *
+   * @return False if already cancelled, the hook is not attached
+   */
+  bool attach(const std::shared_ptr<CancellationHook>& pHook)
+  {
+    std::lock_guard<std::mutex> guard{ m_mutex };
+    if (m_cancelled.load(std::memory_order_relaxed))
+    {
+      return false;
+    }
+    if (m_hooks.size() == m_hooks.capacity() && !m_hooks.empty())
+    {
+      // Drop hooks of released work, before the vector grows
+      m_hooks.erase(std::remove_if(m_hooks.begin(), m_hooks.end(),
+                      [](const std::weak_ptr<CancellationHook>& pWeak) { return pWeak.expired(); }),
+        m_hooks.end());
+    }
+    m_hooks.push_back(pHook);
+    return true;
+  }
+
+  /**
+   * Cancel all hooks attached and hooks attached later
+   *
+   * @return Number of hooks cancelled before they started
+   */
+  std::size_t cancel()
+  {
+    std::vector<std::weak_ptr<CancellationHook>> hooks;
+    {
+      std::lock_guard<std::mutex> guard{ m_mutex };
+      m_cancelled.store(true);
+      hooks.swap(m_hooks);
+    }
+    std::size_t nCancelled = 0;
+    for (const auto& pWeak : hooks)
+    {
+      if (const std::shared_ptr<CancellationHook> pHook = pWeak.lock())
+      {
+        nCancelled += pHook->cancel() ? 1 : 0;
+      }
+    }
+    return nCancelled;
+  }
+
+  bool cancelled() const { return m_cancelled.load(); }
+
+private:
+  std::mutex m_mutex;                                  ///< Mutex for locking
+  std::atomic<bool> m_cancelled{ false };              ///< Cancellation requested
+  std::vector<std::weak_ptr<CancellationHook>> m_hooks; ///< Work attached
+};
+
+} // namespace detail
+
+//! Cancellation token
+/*!
+  Token passed to @ref ThreadPool::submit to tie a task to a @ref
+  CancellationSource. A default-constructed token is never cancelled.
+  Running tasks may poll @ref cancelled to stop early.
+*/
+class CancellationToken
+{
+public:
+  CancellationToken() = default;
+
+  /**
+   * Has cancellation been requested
+   *
+   * @return
+   */
+  bool cancelled() const { return m_pState && m_pState->cancelled(); }
+
+  /**
+   * Attach work to the token
+   *
+   * @param pHook
+   *
+   * @return False if cancellation has been requested
+   */
+  bool attach(const std::shared_ptr<detail::CancellationHook>& pHook) const
+  {
+    return !m_pState || m_pState->attach(pHook);
+  }
+
+private:
+  friend class CancellationSource;
+
+  explicit CancellationToken(std::shared_ptr<detail::CancellationState> pState)
+    : m_pState{ std::move(pState) }
+  {
+  }
+
+  std::shared_ptr<detail::CancellationState> m_pState{}; ///< Shared state
+};
+
+//! Cancellation source
+/*!
+  Issues tokens and cancels all tasks submitted with them, which have
+  not started. Their futures report @ref TaskCancelled immediately,
+  the tasks are discarded when dequeued. Tasks submitted with a token
+  after cancellation are cancelled at submission.
+
+  \code
+  sps::CancellationSource frame;
+  auto future = pool.submit(frame.token(), [&]() { Process(data); });
+  // New frame arrived, drop stale work
+  frame.cancel();
+  \endcode
+*/
+class CancellationSource
+{
+public:
+  CancellationSource()
+    : m_pState{ std::make_shared<detail::CancellationState>() }
+  {
+  }
+
+  /**
+   * Token tied to this source
+   *
+   * @return
+   */
+  CancellationToken token() const { return CancellationToken{ m_pState }; }
+
+  /**
+   * Request cancellation
+   *
+   * @return Number of tasks cancelled before they started
+   */
+  std::size_t cancel() { return m_pState->cancel(); }
+
+  /**
+   * Has cancellation been requested
+   *
+   * @return
+   */
+  bool cancelled() const { return m_pState->cancelled(); }
+
+private:
+  std::shared_ptr<detail::CancellationState> m_pState; ///< Shared state
+};
+
+} // namespace sps
+
+/* Local variables: */
+/* indent-tabs-mode: nil */
+/* tab-width: 2 */
+/* c-basic-offset: 2 */
+/* End: */
@@ -118,6 +118,15 @@ MSVC++ 5.0  _MSC_VER == 1100
 #if (__cplusplus >= 201703L)
 #define CXX17 17
 #endif
+#if (__cplusplus >= 202002L)
+#define CXX20 20
+#endif
+// C++20 coroutines (compiler support and <coroutine>)
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define SPS_COROUTINES 1
+#endif
+#endif
 #endif
 
 /*
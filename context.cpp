@@ -10,6 +10,7 @@
  */
 
 #include <cstdio>
+#include <exception>
 #include <mutex>
 
 #include <sps/context.hpp>
@@ -48,6 +49,17 @@ namespace sps
 
 std::mutex g_mutex;
 
+/**
+ * Options of the default thread pool, protected by g_mutex
+ *
+ * @return
+ */
+static ThreadPoolOptions& DefaultThreadPoolOptions()
+{
+  static ThreadPoolOptions options;
+  return options;
+}
+
 std::atomic<ThreadPool*> Context::g_threadpool{ nullptr };
 
 void Context::ThreadPoolInit()
@@ -83,24 +95,55 @@ ThreadPool* Context::DefaultThreadPoolGet()
     pThreadPool = g_threadpool.load(std::memory_order_relaxed);
     if (!pThreadPool)
     {
-      pThreadPool = new ThreadPool(1);
+      pThreadPool = new ThreadPool(DefaultThreadPoolOptions());
       g_threadpool.store(pThreadPool, std::memory_order_release);
     }
   }
   return pThreadPool;
 }
 
+int Context::DefaultThreadPoolOptionsSet(const ThreadPoolOptions& options)
+{
+  std::lock_guard<std::mutex> guard(g_mutex);
+  if (g_threadpool.load(std::memory_order_relaxed))
+  {
+    return -1;
+  }
+  DefaultThreadPoolOptions() = options;
+  return 0;
+}
+
 ThreadPool* Context::ThreadPoolGet()
 {
   return m_threadpool;
 }
 
+TaskPriority Context::TaskPriorityGet() const
+{
+  return m_priority;
+}
+
 int Context::Create(ContextIF** ppContext)
 {
   *ppContext = new Context();
   return 0;
 }
 
+int Context::Create(
+  ContextIF** ppContext, const ThreadPoolOptions& options, const TaskPriority priority)
+{
+  try
+  {
+    *ppContext = new Context(options, priority);
+  }
+  catch (const std::exception&)
+  {
+    *ppContext = nullptr;
+    return -1;
+  }
+  return 0;
+}
+
 int Context::Destroy(ContextIF* pContext)
 {
   if (pContext)
@@ -111,8 +154,20 @@ int Context::Destroy(ContextIF* pContext)
 }
 
 Context::Context()
+  : m_pOwnedThreadpool{}
+  , m_threadpool{ Context::DefaultThreadPoolGet() }
+  , m_priority{ TaskPriority::Normal }
+  , m_id{ Resource::UIDCreate() }
+{
+}
+
+Context::Context(const ThreadPoolOptions& options, const TaskPriority priority)
+  : m_pOwnedThreadpool{ new ThreadPool(options) }
+  , m_threadpool{ m_pOwnedThreadpool.get() }
+  , m_priority{ priority }
+  , m_id{ Resource::UIDCreate() }
 {
-  m_threadpool = Context::DefaultThreadPoolGet();
-  m_id = Resource::UIDCreate();
 }
+
+Context::~Context() = default;
 } // namespace sps
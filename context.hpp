@@ -10,6 +10,8 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
+#include <memory>
 #include <sps/cenv.h>
 #include <sps/contextif.hpp>
 
@@ -20,17 +22,38 @@ namespace sps
 {
 
 class ThreadPool;
+struct ThreadPoolOptions;
+enum class TaskPriority;
 
 class Context : public ContextIF
 {
 public:
+  /**
+   * Create a context using the default thread pool
+   *
+   * @param ppContext
+   *
+   * @return
+   */
   static int Create(ContextIF** ppContext);
+
+  /**
+   * Create a context owning a thread pool
+   *
+   * @param ppContext
+   * @param options Options of thread pool
+   * @param priority Priority of tasks submitted by the context
+   *
+   * @return Zero on success, negative if the pool cannot be created
+   */
+  static int Create(ContextIF** ppContext, const ThreadPoolOptions& options, TaskPriority priority);
   static int Destroy(ContextIF* pContext);
 
   Context(Context&& other) = default;
   Context& operator=(Context&& other) = default;
-  ~Context() SPS_OVERRIDE = default;
+  ~Context() SPS_OVERRIDE;
   Context();
+  Context(const ThreadPoolOptions& options, TaskPriority priority);
 
   /** @name Used by implementation of Event
    *
@@ -39,7 +62,24 @@ public:
 
   static ThreadPool* DefaultThreadPoolGet();
 
+  /**
+   * Set options of the default thread pool. Must be called before
+   * the default pool is first used.
+   *
+   * @param options
+   *
+   * @return Zero on success, negative if the default pool exists
+   */
+  static int DefaultThreadPoolOptionsSet(const ThreadPoolOptions& options);
+
   ThreadPool* ThreadPoolGet();
+
+  /**
+   * Priority of tasks submitted by the context
+   *
+   * @return
+   */
+  TaskPriority TaskPriorityGet() const;
   ///@}
 
 private:
@@ -61,7 +101,9 @@ private:
   Context(const Context& rhs) = delete;
   Context& operator=(const Context& rhs) = delete;
 
-  ThreadPool* m_threadpool;
+  std::unique_ptr<ThreadPool> m_pOwnedThreadpool; ///< Pool owned by context (if any)
+  ThreadPool* m_threadpool;                       ///< Pool used by context
+  TaskPriority m_priority;                        ///< Priority of tasks
   uint32_t m_id;
 };
 } // namespace sps
@@ -9,6 +9,7 @@
  */
 
 #include <sps/context.hpp>
+#include <sps/threadpool.hpp>
 
 int main(int argc, char* argv[])
 {
@@ -17,6 +18,17 @@ int main(int argc, char* argv[])
   sps::ContextIF* pContext = nullptr;
   sps::Context::Create(&pContext);
 
+  // Context owning a pool with a single worker
+  sps::ThreadPoolOptions options;
+  options.nThreads = 1;
+  sps::ContextIF* pOwningContext = nullptr;
+  if (sps::Context::Create(&pOwningContext, options, sps::TaskPriority::High) != 0 ||
+    static_cast<sps::Context*>(pOwningContext)->ThreadPoolGet()->size() != 1)
+  {
+    return 1;
+  }
+  sps::Context::Destroy(pOwningContext);
+
   // Create Event
   // sps::EventIF* pEvent = nullptr;
   // sps::Event::Create(&pEvent, pContext);
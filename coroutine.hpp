@@ -0,0 +1,354 @@
+/**
+ * @file   coroutine.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sat Oct 17 21:14:52 2026
+ *
+ * @brief  C++20 coroutine task type scheduled on sps::ThreadPool
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#pragma once
+
+#include <sps/cenv.h>
+#include <sps/threadpool.hpp>
+
+#if defined(SPS_COROUTINES)
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace sps
+{
+
+template <typename T = void>
+class task;
+
+namespace detail
+{
+
+//! Awaiter of the final suspension of a task
+/*!
+  Transfers control to the coroutine awaiting the task (if any)
+  without growing the stack.
+*/
+template <typename Promise>
+struct TaskFinalAwaiter
+{
+  bool await_ready() const noexcept { return false; }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+  {
+    std::coroutine_handle<> continuation = handle.promise().m_continuation;
+    return continuation ? continuation : std::noop_coroutine();
+  }
+
+  void await_resume() const noexcept {}
+};
+
+//! Awaiter starting a task without taking its result
+template <typename Promise>
+struct TaskStartAwaiter
+{
+  std::coroutine_handle<Promise> m_handle; ///< Task started
+
+  bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+  {
+    m_handle.promise().m_continuation = continuation;
+    return m_handle;
+  }
+
+  void await_resume() const noexcept {}
+};
+
+//! Promise of a task, common part
+class TaskPromiseBase
+{
+public:
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+
+  std::coroutine_handle<> m_continuation{}; ///< Coroutine awaiting the task
+};
+
+//! Promise of a task returning a value
+template <typename T>
+class TaskPromise : public TaskPromiseBase
+{
+public:
+  task<T> get_return_object() noexcept;
+
+  TaskFinalAwaiter<TaskPromise> final_suspend() const noexcept { return {}; }
+
+  template <typename Value>
+  void return_value(Value&& value)
+  {
+    m_result.template emplace<1>(std::forward<Value>(value));
+  }
+
+  void unhandled_exception() noexcept { m_result.template emplace<2>(std::current_exception()); }
+
+  /**
+   * Take the result or rethrow the exception
+   *
+   * @return
+   */
+  T result()
+  {
+    if (m_result.index() == 2)
+    {
+      std::rethrow_exception(std::get<2>(m_result));
+    }
+    return std::move(std::get<1>(m_result));
+  }
+
+private:
+  std::variant<std::monostate, T, std::exception_ptr> m_result; ///< Result or exception
+};
+
+//! Promise of a task returning void
+template <>
+class TaskPromise<void> : public TaskPromiseBase
+{
+public:
+  task<void> get_return_object() noexcept;
+
+  TaskFinalAwaiter<TaskPromise> final_suspend() const noexcept { return {}; }
+
+  void return_void() const noexcept {}
+
+  void unhandled_exception() noexcept { m_exception = std::current_exception(); }
+
+  /**
+   * Rethrow the exception (if any)
+   *
+   */
+  void result()
+  {
+    if (m_exception)
+    {
+      std::rethrow_exception(m_exception);
+    }
+  }
+
+private:
+  std::exception_ptr m_exception{}; ///< Exception thrown
+};
+
+//! Latch used by @ref sync_wait
+struct SyncWaitLatch
+{
+  std::mutex mutex;                  ///< Mutex for locking
+  std::condition_variable condition; ///< Condition for signal done
+  bool done{ false };                ///< Task has completed
+};
+
+//! Coroutine used by @ref sync_wait to await a task
+class SyncWaitTask
+{
+public:
+  struct promise_type
+  {
+    SyncWaitLatch* m_pLatch{ nullptr }; ///< Latch signalled on completion
+
+    SyncWaitTask get_return_object() noexcept
+    {
+      return SyncWaitTask{ std::coroutine_handle<promise_type>::from_promise(*this) };
+    }
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+
+    auto final_suspend() const noexcept
+    {
+      struct Awaiter
+      {
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<promise_type> handle) const noexcept
+        {
+          // Notify under lock, the latch is destroyed once released
+          SyncWaitLatch& latch = *handle.promise().m_pLatch;
+          std::lock_guard<std::mutex> guard{ latch.mutex };
+          latch.done = true;
+          latch.condition.notify_all();
+        }
+
+        void await_resume() const noexcept {}
+      };
+      return Awaiter{};
+    }
+
+    void return_void() const noexcept {}
+
+    // Exceptions are stored by the task awaited
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+
+  explicit SyncWaitTask(std::coroutine_handle<promise_type> handle)
+    : m_handle{ handle }
+  {
+  }
+
+  SyncWaitTask(SyncWaitTask&& other) noexcept
+    : m_handle{ std::exchange(other.m_handle, nullptr) }
+  {
+  }
+
+  ~SyncWaitTask()
+  {
+    if (m_handle)
+    {
+      m_handle.destroy();
+    }
+  }
+
+  /**
+   * Start the coroutine and block until it has completed
+   *
+   */
+  void run()
+  {
+    SyncWaitLatch latch;
+    m_handle.promise().m_pLatch = &latch;
+    m_handle.resume();
+    std::unique_lock<std::mutex> lock{ latch.mutex };
+    latch.condition.wait(lock, [&latch]() { return latch.done; });
+  }
+
+private:
+  SyncWaitTask(const SyncWaitTask& rhs) = delete;
+  SyncWaitTask& operator=(const SyncWaitTask& rhs) = delete;
+
+  std::coroutine_handle<promise_type> m_handle; ///< Coroutine
+};
+
+} // namespace detail
+
+//! Coroutine task
+/*!
+  Lazily started coroutine producing a value of type T. The task
+  starts, when it is awaited, and the awaiting coroutine is resumed
+  on the thread completing the task. Combined with @ref
+  ThreadPool::schedule and awaiting @ref ThreadPool::TaskFuture, work
+  is moved between threads without blocking any of them.
+
+  \code
+  sps::task<int> Handle(sps::ThreadPool& pool, Request request)
+  {
+    Data data = co_await pool.submit([&]() { return Read(request); });
+    co_await pool.schedule(sps::TaskPriority::High);
+    co_return Process(data);
+  }
+  int result = sps::sync_wait(Handle(pool, request));
+  \endcode
+*/
+template <typename T>
+class task
+{
+public:
+  using promise_type = detail::TaskPromise<T>;
+
+  explicit task(std::coroutine_handle<promise_type> handle) noexcept
+    : m_handle{ handle }
+  {
+  }
+
+  task(task&& other) noexcept
+    : m_handle{ std::exchange(other.m_handle, nullptr) }
+  {
+  }
+
+  task& operator=(task&& other) noexcept
+  {
+    if (this != &other)
+    {
+      if (m_handle)
+      {
+        m_handle.destroy();
+      }
+      m_handle = std::exchange(other.m_handle, nullptr);
+    }
+    return *this;
+  }
+
+  ~task()
+  {
+    if (m_handle)
+    {
+      m_handle.destroy();
+    }
+  }
+
+  //! Awaiter of a task
+  struct Awaiter : detail::TaskStartAwaiter<promise_type>
+  {
+    T await_resume() { return this->m_handle.promise().result(); }
+  };
+
+  /**
+   * Start the task and suspend the awaiting coroutine until it has
+   * completed. Exceptions thrown by the task are rethrown.
+   *
+   * @return
+   */
+  Awaiter operator co_await() const& noexcept { return Awaiter{ { m_handle } }; }
+
+private:
+  template <typename U>
+  friend U sync_wait(task<U>&& t);
+
+  task(const task& rhs) = delete;
+  task& operator=(const task& rhs) = delete;
+
+  std::coroutine_handle<promise_type> m_handle; ///< Coroutine
+};
+
+namespace detail
+{
+template <typename T>
+task<T> TaskPromise<T>::get_return_object() noexcept
+{
+  return task<T>{ std::coroutine_handle<TaskPromise>::from_promise(*this) };
+}
+
+inline task<void> TaskPromise<void>::get_return_object() noexcept
+{
+  return task<void>{ std::coroutine_handle<TaskPromise>::from_promise(*this) };
+}
+} // namespace detail
+
+/**
+ * Start a task on the calling thread and block until it has
+ * completed. Must not be called from a worker of a pool, which the
+ * task needs for completion.
+ *
+ * @param t
+ *
+ * @return Result of the task. Exceptions thrown are rethrown.
+ */
+template <typename T>
+T sync_wait(task<T>&& t)
+{
+  using Promise = typename task<T>::promise_type;
+  auto wait = [](std::coroutine_handle<Promise> handle) -> detail::SyncWaitTask
+  { co_await detail::TaskStartAwaiter<Promise>{ handle }; };
+  task<T> owned = std::move(t);
+  wait(owned.m_handle).run();
+  return owned.m_handle.promise().result();
+}
+
+} // namespace sps
+
+#endif
+
+/* Local variables: */
+/* indent-tabs-mode: nil */
+/* tab-width: 2 */
+/* c-basic-offset: 2 */
+/* End: */
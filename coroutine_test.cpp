@@ -0,0 +1,115 @@
+/**
+ * @file   coroutine_test.cpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sat Oct 17 21:48:05 2026
+ *
+ * @brief  Tests of coroutine tasks scheduled on sps::ThreadPool
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#include <gtest/gtest.h>
+#include <sps/cenv.h>
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <sps/coroutine.hpp>
+#include <sps/threadpool.hpp>
+
+#if defined(SPS_COROUTINES)
+
+namespace
+{
+
+sps::task<int> Square(sps::ThreadPool& pool, int value)
+{
+  co_await pool.schedule();
+  co_return value * value;
+}
+
+sps::task<int> SumOfSquares(sps::ThreadPool& pool, int n)
+{
+  int sum = 0;
+  for (int i = 1; i <= n; i++)
+  {
+    sum += co_await Square(pool, i);
+  }
+  co_return sum;
+}
+
+sps::task<void> Fail(sps::ThreadPool& pool)
+{
+  co_await pool.schedule(sps::TaskPriority::High);
+  throw std::runtime_error("failure");
+}
+
+} // namespace
+
+TEST(coroutine_test, schedule)
+{
+  sps::ThreadPool pool(2);
+  const std::thread::id caller = std::this_thread::get_id();
+
+  auto onWorker = [&]() -> sps::task<bool>
+  {
+    co_await pool.schedule();
+    co_return std::this_thread::get_id() != caller;
+  };
+  EXPECT_TRUE(sps::sync_wait(onWorker()));
+  EXPECT_EQ(sps::sync_wait(SumOfSquares(pool, 10)), 385);
+}
+
+TEST(coroutine_test, exception)
+{
+  sps::ThreadPool pool(1);
+  EXPECT_THROW(sps::sync_wait(Fail(pool)), std::runtime_error);
+}
+
+/**
+ * Test awaiting futures. A single worker completes many coroutines
+ * awaiting tasks, since no coroutine blocks it.
+ *
+ */
+TEST(coroutine_test, await_future)
+{
+  sps::ThreadPool pool(1);
+
+  auto handler = [&](int request) -> sps::task<int>
+  {
+    co_await pool.schedule();
+    const int data = co_await pool.submit([request]() -> int { return request + 1; });
+    co_return 2 * data;
+  };
+
+  auto all = [&]() -> sps::task<int>
+  {
+    int sum = 0;
+    for (int i = 0; i < 100; i++)
+    {
+      sum += co_await handler(i);
+    }
+    co_return sum;
+  };
+  EXPECT_EQ(sps::sync_wait(all()), 2 * 5050);
+
+  auto failing = [&]() -> sps::task<void>
+  { co_await pool.submit([]() -> void { throw std::runtime_error("failure"); }); };
+  EXPECT_THROW(sps::sync_wait(failing()), std::runtime_error);
+}
+
+#else
+
+TEST(coroutine_test, unsupported)
+{
+  GTEST_SKIP() << "C++20 coroutines not available";
+}
+
+#endif
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -162,7 +162,8 @@ public:
         // using ResultType =
         //    std::result_of_t<decltype(cb.get()->* &ICallBack::Execute)()>;
         // TODO(JEM): Make threadpool accept std::function
-        m_pContext->ThreadPoolGet()->submit([&]() -> void { cb.get()->Execute(); });
+        m_pContext->ThreadPoolGet()->submit(
+          m_pContext->TaskPriorityGet(), [&]() -> void { cb.get()->Execute(); });
       }
     }
     m_mutex.unlock();
@@ -0,0 +1,194 @@
+/**
+ * @file   eventcount.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sat Oct 17 23:52:06 2026
+ *
+ * @brief  Event count for blocking on lock-free data structures
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#pragma once
+
+#include <sps/cenv.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+// After the system headers, since it includes <sys/prctl.h> inside namespace sps
+#include <sps/sps_threads.hpp>
+
+namespace sps
+{
+
+//! Event count
+/*!
+  Lets a thread sleep until a condition of a lock-free data structure
+  changes, without making the non-blocking path of the other side
+  wait or enter the kernel. A waiter registers, rechecks its condition
+  and then waits:
+
+  \code
+  while (!queue.try_pop(value))
+  {
+    const auto key = event.prepareWait();
+    if (queue.try_pop(value))
+    {
+      event.cancelWait();
+      break;
+    }
+    event.wait(key);
+  }
+  \endcode
+
+  The other side calls @ref notify after publishing. It is a single
+  atomic read-modify-write, unless a waiter is registered. On Linux,
+  waiters sleep on a futex, elsewhere on a condition variable.
+*/
+class EventCount
+{
+public:
+  using Key = std::uint32_t;
+
+  EventCount() = default;
+
+  /**
+   * Register as waiter. The condition must be rechecked afterwards.
+   *
+   * @return Key passed to @ref wait
+   */
+  Key prepareWait()
+  {
+    m_nWaiters.fetch_add(1);
+    return m_epoch.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Unregister, when the condition became true after @ref prepareWait
+   *
+   */
+  void cancelWait() { m_nWaiters.fetch_sub(1); }
+
+  /**
+   * Sleep until notified after @ref prepareWait returned key
+   *
+   * @param key
+   */
+  void wait(const Key key)
+  {
+#if defined(__linux__)
+    while (m_epoch.load(std::memory_order_acquire) == key)
+    {
+      syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&m_epoch), FUTEX_WAIT_PRIVATE, key,
+        nullptr, nullptr, 0);
+    }
+#else
+    std::unique_lock<std::mutex> lock{ m_mutex };
+    m_condition.wait(lock, [&]() { return m_epoch.load(std::memory_order_acquire) != key; });
+#endif
+    m_nWaiters.fetch_sub(1);
+  }
+
+  /**
+   * Retry an attempt, first spinning, then sleeping until notified
+   *
+   * @param attempt Callable returning true on success
+   * @param nSpins Attempts with a pause before sleeping
+   */
+  template <typename Attempt>
+  void await(Attempt&& attempt, const size_t nSpins = 64)
+  {
+    for (size_t i = 0; i < nSpins; i++)
+    {
+      if (attempt())
+      {
+        return;
+      }
+      sps_cpu_relax();
+    }
+    while (!attempt())
+    {
+      const Key key = prepareWait();
+      if (attempt())
+      {
+        cancelWait();
+        return;
+      }
+      wait(key);
+    }
+  }
+
+  /**
+   * Wake one waiter, if any
+   *
+   */
+  void notify() { wake(false); }
+
+  /**
+   * Wake all waiters
+   *
+   */
+  void notifyAll() { wake(true); }
+
+private:
+  EventCount(const EventCount& rhs) = delete;
+  EventCount& operator=(const EventCount& rhs) = delete;
+
+  void wake(const bool all)
+  {
+    // The read-modify-write is ordered with the registration of a
+    // waiter, such that either the waiter sees the change published
+    // before or this sees the waiter
+    if (m_nWaiters.fetch_add(0) == 0)
+    {
+      return;
+    }
+#if defined(__linux__)
+    m_epoch.fetch_add(1, std::memory_order_release);
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&m_epoch), FUTEX_WAKE_PRIVATE,
+      all ? INT_MAX : 1, nullptr, nullptr, 0);
+#else
+    {
+      std::lock_guard<std::mutex> guard{ m_mutex };
+      m_epoch.fetch_add(1, std::memory_order_release);
+    }
+    if (all)
+    {
+      m_condition.notify_all();
+    }
+    else
+    {
+      m_condition.notify_one();
+    }
+#endif
+  }
+
+  static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+    "Futex word must be a plain 32-bit integer");
+
+  std::atomic<std::uint32_t> m_epoch{ 0 };    ///< Incremented by notification
+  std::atomic<std::uint32_t> m_nWaiters{ 0 }; ///< Waiters registered
+#if !defined(__linux__)
+  std::mutex m_mutex;                  ///< Mutex for locking
+  std::condition_variable m_condition; ///< Condition for signal epoch changed
+#endif
+};
+
+} // namespace sps
+
+/* Local variables: */
+/* indent-tabs-mode: nil */
+/* tab-width: 2 */
+/* c-basic-offset: 2 */
+/* End: */
@@ -11,17 +11,87 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <sps/sps_export.h>
 
 namespace sps
 {
 typedef void (*SimpleCallback)(void*);
 
+/// Number of bins of the histograms of @ref ThreadPoolStatistics
+const std::size_t ThreadPoolHistogramBins = 32;
+
+//! Thread pool statistics
+/*!
+  Counters aggregated over all workers. Histogram bin k counts times
+  in [2^k, 2^(k+1)) nanoseconds, the last bin counts all longer
+  times. Wait times of tasks submitted by workers are sampled.
+*/
+struct ThreadPoolStatistics
+{
+  uint64_t nSubmitted;                                  ///< Tasks submitted
+  uint64_t nCompleted;                                  ///< Tasks executed
+  uint64_t queueDepth;                                  ///< Tasks queued, not yet dequeued
+  uint64_t waitHistogram[ThreadPoolHistogramBins];      ///< Time from submission to dequeue
+  uint64_t executionHistogram[ThreadPoolHistogramBins]; ///< Execution time
+};
+
+//! Statistics of a thread pool worker
+struct ThreadPoolWorkerStatistics
+{
+  uint64_t nCompleted; ///< Tasks executed
+  uint64_t busyTime;   ///< Time executing tasks [ns]
+  uint64_t idleTime;   ///< Time waiting for tasks [ns]
+};
+
 class SPS_EXPORT IThreadPool
 {
 public:
   virtual int Initialize() = 0;
   virtual int SubmitJob(SimpleCallback cb, void* pUserData) = 0;
+
+  /**
+   * Submit a batch of jobs using a single queue operation. Job i
+   * calls pCallbacks[i](ppUserData[i]). Like @ref SubmitJob, the call
+   * returns when all jobs have completed.
+   *
+   * @param pCallbacks Callbacks
+   * @param ppUserData User data passed to the callbacks
+   * @param nJobs Number of jobs
+   *
+   * @return Zero on success
+   */
+  virtual int SubmitJobs(SimpleCallback* pCallbacks, void** ppUserData, std::size_t nJobs) = 0;
+
+  /**
+   * Change the number of worker threads. Must not be called from a
+   * job executed by the pool.
+   *
+   * @param nThreads Number of worker threads
+   *
+   * @return Zero on success, negative if nThreads exceeds the
+   *         capacity of the pool or if called from a job
+   */
+  virtual int Resize(std::size_t nThreads) = 0;
+
+  /**
+   * Get statistics aggregated over all workers
+   *
+   * @param pStatistics
+   *
+   * @return Zero on success
+   */
+  virtual int StatisticsGet(ThreadPoolStatistics* pStatistics) = 0;
+
+  /**
+   * Get statistics of a worker
+   *
+   * @param iWorker Index of worker
+   * @param pStatistics
+   *
+   * @return Zero on success, negative if iWorker is invalid
+   */
+  virtual int WorkerStatisticsGet(std::size_t iWorker, ThreadPoolWorkerStatistics* pStatistics) = 0;
   virtual ~IThreadPool() = default;
 
   // If you start to default functions - no longer a pure virtual interface
@@ -39,7 +109,25 @@ private:
   // IThreadPool& operator=(const IThreadPool& other) = delete;
 };
 
+/**
+ * Create a thread pool with one thread less than the hardware
+ * concurrency (at least one)
+ *
+ * @param ppObj
+ *
+ * @return Zero on success
+ */
 SPS_EXPORT int ThreadPoolCreate(IThreadPool** ppObj);
+
+/**
+ * Create a thread pool
+ *
+ * @param ppObj
+ * @param nThreads Number of worker threads
+ *
+ * @return Zero on success
+ */
+SPS_EXPORT int ThreadPoolCreate(IThreadPool** ppObj, std::size_t nThreads);
 SPS_EXPORT int ThreadPoolDestroy(IThreadPool* pObj);
 
 } // namespace sps
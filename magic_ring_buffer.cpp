@@ -0,0 +1,127 @@
+/**
+ * @file   magic_ring_buffer.cpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sun Oct 18 00:12:40 2026
+ *
+ * @brief  Magic ring buffer using a double-mapped memory file (Linux)
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#include <sps/magic_ring_buffer.hpp>
+
+#if defined(__linux__)
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace sps
+{
+
+namespace
+{
+[[noreturn]] void ThrowErrno(const char* what)
+{
+  throw std::system_error(errno, std::generic_category(), what);
+}
+} // namespace
+
+MagicRingBuffer::MagicRingBuffer(size_t size, unsigned int flags)
+  : m_nSize{ 0 }
+  , m_pData{ nullptr }
+{
+  if (size == 0)
+  {
+    throw std::invalid_argument("Size must be positive");
+  }
+  const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  m_nSize = (size + pageSize - 1) / pageSize * pageSize;
+
+  const int fd = memfd_create("sps_magic_ring", MFD_CLOEXEC);
+  if (fd < 0)
+  {
+    ThrowErrno("memfd_create");
+  }
+  if (ftruncate(fd, static_cast<off_t>(m_nSize)) != 0)
+  {
+    const int error = errno;
+    close(fd);
+    throw std::system_error(error, std::generic_category(), "ftruncate");
+  }
+
+  // Reserve address space for both views, then map the file twice
+  // on top of the reservation
+  void* pReserved = mmap(nullptr, 2 * m_nSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (pReserved == MAP_FAILED)
+  {
+    const int error = errno;
+    close(fd);
+    throw std::system_error(error, std::generic_category(), "mmap");
+  }
+  unsigned char* pBase = static_cast<unsigned char*>(pReserved);
+  const int mapFlags = MAP_SHARED | MAP_FIXED | ((flags & Populate) ? MAP_POPULATE : 0);
+  for (size_t iView = 0; iView < 2; iView++)
+  {
+    void* pView = mmap(pBase + iView * m_nSize, m_nSize, PROT_READ | PROT_WRITE, mapFlags, fd, 0);
+    if (pView == MAP_FAILED)
+    {
+      const int error = errno;
+      munmap(pReserved, 2 * m_nSize);
+      close(fd);
+      throw std::system_error(error, std::generic_category(), "mmap");
+    }
+  }
+  // The mappings keep the file alive
+  close(fd);
+
+  if ((flags & Lock) && mlock(pBase, m_nSize) != 0)
+  {
+    const int error = errno;
+    munmap(pReserved, 2 * m_nSize);
+    throw std::system_error(error, std::generic_category(), "mlock");
+  }
+  m_pData = pBase;
+}
+
+MagicRingBuffer::~MagicRingBuffer()
+{
+  munmap(m_pData, 2 * m_nSize);
+}
+
+size_t MagicRingBuffer::write(size_t len, const void* pData)
+{
+  len = std::min(len, writable());
+  if (len > 0)
+  {
+    std::memcpy(reserve(len), pData, len);
+    commit(len);
+  }
+  return len;
+}
+
+size_t MagicRingBuffer::read(size_t len, void* pData)
+{
+  len = std::min(len, readable());
+  if (len > 0)
+  {
+    std::memcpy(pData, peek(len), len);
+    consume(len);
+  }
+  return len;
+}
+
+} // namespace sps
+
+#endif
+
+/* Local variables: */
+/* indent-tabs-mode: nil */
+/* tab-width: 2 */
+/* c-basic-offset: 2 */
+/* End: */
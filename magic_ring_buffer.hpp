@@ -24,20 +24,192 @@
  *  You should have received a copy of the GNU General Public License
  *  along with SOFUS.  If not, see <http://www.gnu.org/licenses/>.
  *
- *  TODO: support NUMA nodes, SHMAT and MMAP
+ *  TODO: support NUMA nodes
  * numa_mem_id() or cpu_to_mem()
  */
 
 #pragma once
 
+#include <sps/cenv.h>
+#include <sps/sps_export.h>
+
+#include <atomic>
+#include <cstddef>
+
 namespace sps
 {
-class IMagicRingBuffer
+
+//! Magic ring buffer interface
+/*!
+  Byte ring buffer for a single reader and a single writer.
+*/
+class SPS_EXPORT IMagicRingBuffer
 {
 public:
   virtual ~IMagicRingBuffer() = default;
-  IMagicRingBuffer(size_t size, unsigned int flags = 0);
-  size_t write(size_t len, void* pData);
-  size_t read(size_t len, void* pData);
+
+  /**
+   * Copy bytes into the buffer
+   *
+   * @param len Number of bytes
+   * @param pData Source
+   *
+   * @return Number of bytes written, less than len if the buffer is full
+   */
+  virtual size_t write(size_t len, const void* pData) = 0;
+
+  /**
+   * Copy bytes out of the buffer
+   *
+   * @param len Number of bytes
+   * @param pData Destination
+   *
+   * @return Number of bytes read, less than len if the buffer runs empty
+   */
+  virtual size_t read(size_t len, void* pData) = 0;
+
+protected:
+  IMagicRingBuffer() = default;
+
+private:
+  IMagicRingBuffer(const IMagicRingBuffer&) = delete;
+  IMagicRingBuffer& operator=(const IMagicRingBuffer&) = delete;
+};
+
+#if defined(__linux__)
+
+//! Magic ring buffer
+/*!
+  The buffer is backed by an anonymous memory file (memfd_create),
+  which is mapped twice at adjacent virtual addresses. Every range of
+  up to @ref size bytes starting inside the buffer is therefore
+  contiguous, also when it wraps. Producers write records in place
+  using @ref reserve / @ref commit and consumers read them in place
+  using @ref peek / @ref consume, without splitting them at the end.
+
+  One thread may write and one thread may read concurrently. The
+  write position is published using release and loaded using acquire
+  by the reader and vice versa.
+*/
+class SPS_EXPORT MagicRingBuffer : public IMagicRingBuffer
+{
+public:
+  /// Flags given at construction
+  enum Flags : unsigned int
+  {
+    None = 0x0U,     ///< No flags
+    Populate = 0x1U, ///< Pre-fault the pages
+    Lock = 0x2U,     ///< Lock the pages in memory (mlock)
+  };
+
+  /**
+   * Ctor
+   *
+   * @param size Minimum capacity in bytes, rounded up to a multiple of the page size
+   * @param flags Combination of @ref Flags
+   *
+   * @throws std::invalid_argument if size is zero
+   * @throws std::system_error if the memory cannot be mapped
+   */
+  explicit MagicRingBuffer(size_t size, unsigned int flags = None);
+
+  ~MagicRingBuffer() override;
+
+  size_t write(size_t len, const void* pData) override;
+
+  size_t read(size_t len, void* pData) override;
+
+  /**
+   * Reserve contiguous space for writing in place
+   *
+   * @param len Number of bytes
+   *
+   * @return Pointer to len writable bytes or nullptr if not available
+   */
+  void* reserve(size_t len)
+  {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (m_nSize - (head - m_tail.load(std::memory_order_acquire)) < len)
+    {
+      return nullptr;
+    }
+    return m_pData + head % m_nSize;
+  }
+
+  /**
+   * Publish bytes written to the space reserved
+   *
+   * @param len Number of bytes, at most the length reserved
+   */
+  void commit(size_t len)
+  {
+    m_head.store(m_head.load(std::memory_order_relaxed) + len, std::memory_order_release);
+  }
+
+  /**
+   * Access contiguous bytes for reading in place
+   *
+   * @param len Number of bytes
+   *
+   * @return Pointer to len readable bytes or nullptr if not available
+   */
+  const void* peek(size_t len) const
+  {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (m_head.load(std::memory_order_acquire) - tail < len)
+    {
+      return nullptr;
+    }
+    return m_pData + tail % m_nSize;
+  }
+
+  /**
+   * Release bytes read
+   *
+   * @param len Number of bytes, at most the length peeked
+   */
+  void consume(size_t len)
+  {
+    m_tail.store(m_tail.load(std::memory_order_relaxed) + len, std::memory_order_release);
+  }
+
+  /**
+   * Number of bytes, which may be read
+   *
+   * @return
+   */
+  size_t readable() const
+  {
+    return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Number of bytes, which may be written
+   *
+   * @return
+   */
+  size_t writable() const { return m_nSize - readable(); }
+
+  /**
+   * Capacity in bytes
+   *
+   * @return
+   */
+  size_t size() const { return m_nSize; }
+
+private:
+  size_t m_nSize;                                  ///< Capacity, multiple of page size
+  unsigned char* m_pData;                          ///< First of two adjacent views
+  SPS_ALIGNAS(64) std::atomic<size_t> m_head{ 0 }; ///< Bytes written, owned by writer
+  SPS_ALIGNAS(64) std::atomic<size_t> m_tail{ 0 }; ///< Bytes read, owned by reader
 };
+
+#endif
+
 } // namespace sps
+
+/* Local variables: */
+/* indent-tabs-mode: nil */
+/* tab-width: 2 */
+/* c-basic-offset: 2 */
+/* End: */
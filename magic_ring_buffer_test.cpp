@@ -0,0 +1,116 @@
+/**
+ * @file   magic_ring_buffer_test.cpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sun Oct 18 00:26:19 2026
+ *
+ * @brief  Tests of sps::MagicRingBuffer
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#include <gtest/gtest.h>
+#include <sps/cenv.h>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <sps/magic_ring_buffer.hpp>
+
+TEST(magic_ring_buffer_test, wrap)
+{
+  EXPECT_THROW(sps::MagicRingBuffer(0), std::invalid_argument);
+
+  sps::MagicRingBuffer buffer(1000);
+  const size_t size = buffer.size();
+  EXPECT_GE(size, 1000u);
+  EXPECT_EQ(buffer.writable(), size);
+
+  // Advance close to the end
+  std::vector<unsigned char> data(size, 0);
+  EXPECT_EQ(buffer.write(size - 10, data.data()), size - 10);
+  EXPECT_EQ(buffer.read(size - 10, data.data()), size - 10);
+
+  // A record across the end is contiguous
+  unsigned char* pRecord = static_cast<unsigned char*>(buffer.reserve(100));
+  ASSERT_NE(pRecord, nullptr);
+  for (size_t i = 0; i < 100; i++)
+  {
+    pRecord[i] = static_cast<unsigned char>(i);
+  }
+  buffer.commit(100);
+  EXPECT_EQ(buffer.readable(), 100u);
+
+  const unsigned char* pRead = static_cast<const unsigned char*>(buffer.peek(100));
+  ASSERT_NE(pRead, nullptr);
+  EXPECT_EQ(pRead, pRecord);
+  EXPECT_EQ(pRead[99], 99);
+  EXPECT_EQ(buffer.peek(101), nullptr);
+  buffer.consume(100);
+
+  // Full
+  EXPECT_EQ(buffer.write(2 * size, data.data()), size);
+  EXPECT_EQ(buffer.reserve(1), nullptr);
+  EXPECT_EQ(buffer.read(2 * size, data.data()), size);
+}
+
+/**
+ * Test streaming variable-length records between two threads. Each
+ * record is a length followed by a payload.
+ *
+ */
+TEST(magic_ring_buffer_test, records)
+{
+  sps::MagicRingBuffer buffer(4096);
+  const uint32_t nRecords = 20000;
+
+  std::thread producer(
+    [&]()
+    {
+      for (uint32_t i = 0; i < nRecords; i++)
+      {
+        const uint32_t length = 1 + i % 300;
+        void* pSpace = nullptr;
+        while (!(pSpace = buffer.reserve(sizeof(length) + length)))
+        {
+          std::this_thread::yield();
+        }
+        std::memcpy(pSpace, &length, sizeof(length));
+        std::memset(static_cast<unsigned char*>(pSpace) + sizeof(length),
+          static_cast<int>(i & 0xFF), length);
+        buffer.commit(sizeof(length) + length);
+      }
+    });
+
+  bool valid = true;
+  for (uint32_t i = 0; i < nRecords; i++)
+  {
+    const void* pHeader = nullptr;
+    while (!(pHeader = buffer.peek(sizeof(uint32_t))))
+    {
+      std::this_thread::yield();
+    }
+    uint32_t length = 0;
+    std::memcpy(&length, pHeader, sizeof(length));
+    valid = valid && length == 1 + i % 300;
+    const unsigned char* pRecord = nullptr;
+    while (!(pRecord = static_cast<const unsigned char*>(buffer.peek(sizeof(length) + length))))
+    {
+      std::this_thread::yield();
+    }
+    valid = valid && pRecord[sizeof(length)] == (i & 0xFF) &&
+      pRecord[sizeof(length) + length - 1] == (i & 0xFF);
+    buffer.consume(sizeof(length) + length);
+  }
+  producer.join();
+  EXPECT_TRUE(valid);
+  EXPECT_EQ(buffer.readable(), 0u);
+}
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -43,8 +43,11 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <queue>
 #include <utility>
 
@@ -223,12 +226,13 @@ public:
    *
    * @param destination
    *
-   * @return True if a value is written to destination, false otherwise
+   * @return True if a value is written to destination, false if the
+   * queue is empty or invalidated
    */
   bool try_pop(T& destination) SPS_OVERRIDE
   {
     std::lock_guard<std::mutex> guard(m_mutex);
-    if (m_queue.empty())
+    if (!m_valid || m_queue.empty())
     {
       return false;
     }
@@ -254,9 +258,7 @@ public:
   bool pop(T& destination) SPS_OVERRIDE
   {
     std::unique_lock<std::mutex> lock{ m_mutex }; // m_mutex.lock()
-    // Equivalent to:
-    // while ( !(!m_queue.empty() || !m_valid) ) {m_condition.wait(lock);}
-    m_condition.wait(lock, [this]() { return !m_queue.empty() || !m_valid; });
+    waitNotEmpty(lock);
     // Lock is reacquired
 
     if (!m_valid)
@@ -273,12 +275,18 @@ public:
    * Push element onto queue
    *
    * @param source
+   *
+   * @return False if the queue is invalidated
    */
   bool push(T&& source) SPS_OVERRIDE
   {
     std::lock_guard<std::mutex> guard(m_mutex);
+    if (!m_valid)
+    {
+      return false;
+    }
     m_queue.push(std::move(source));
-    m_condition.notify_one();
+    notifyReaders(1);
     return true;
   }
 #else
@@ -286,12 +294,86 @@ public:
   {
     // Scoped lock
     std::lock_guard<std::mutex> guard{ m_mutex };
+    if (!m_valid)
+    {
+      return false;
+    }
     m_queue.push(std::move(source));
-    m_condition.notify_one();
+    notifyReaders(1);
     return true;
   }
 #endif
 
+  /**
+   * Push a range of elements onto queue using a single lock and a
+   * single notification. The elements are moved from.
+   *
+   * @param first
+   * @param last
+   *
+   * @return False if the queue is invalidated, then nothing is pushed
+   */
+  template <typename InputIt>
+  bool push_bulk(InputIt first, InputIt last)
+  {
+    std::lock_guard<std::mutex> guard{ m_mutex };
+    if (!m_valid)
+    {
+      return false;
+    }
+    std::size_t n = 0;
+    for (; first != last; ++first, ++n)
+    {
+      m_queue.push(std::move(*first));
+    }
+    notifyReaders(n);
+    return true;
+  }
+
+  /**
+   * Pop up to max elements using a single lock
+   *
+   * @param out Output iterator, to which the elements are moved
+   * @param max Maximum number of elements
+   *
+   * @return Number of elements popped, zero if the queue is invalidated
+   */
+  template <typename OutputIt>
+  std::size_t try_pop_bulk(OutputIt out, std::size_t max)
+  {
+    std::lock_guard<std::mutex> guard{ m_mutex };
+    if (!m_valid)
+    {
+      return 0;
+    }
+    return drain(out, max);
+  }
+
+  /**
+   * Pop up to max elements using a single lock. Blocks until at least
+   * one element is available unless the queue is invalidated.
+   *
+   * @param out Output iterator, to which the elements are moved
+   * @param max Maximum number of elements
+   *
+   * @return Number of elements popped, zero if the queue is invalidated
+   */
+  template <typename OutputIt>
+  std::size_t pop_bulk(OutputIt out, std::size_t max)
+  {
+    if (max == 0)
+    {
+      return 0;
+    }
+    std::unique_lock<std::mutex> lock{ m_mutex };
+    waitNotEmpty(lock);
+    if (!m_valid)
+    {
+      return 0;
+    }
+    return drain(out, max);
+  }
+
   /**
    * Invalidate the queue. This is used to ensure no conditions are
    * being waited on in @ref try_pop when a thread or the
@@ -347,11 +429,67 @@ public:
   }
 
 protected:
+  /**
+   * Wait until the queue is non-empty or invalidated. Waiting readers
+   * are counted, such that writers only notify if needed.
+   *
+   * @param lock Lock holding m_mutex
+   */
+  void waitNotEmpty(std::unique_lock<std::mutex>& lock)
+  {
+    m_nReaders++;
+    m_condition.wait(lock, [this]() { return !m_queue.empty() || !m_valid; });
+    m_nReaders--;
+  }
+
+  /**
+   * Notify waiting readers after pushing n elements. Called with
+   * m_mutex held.
+   *
+   * @param n
+   */
+  void notifyReaders(const std::size_t n)
+  {
+    if (n == 0 || m_nReaders == 0)
+    {
+      return;
+    }
+    if (n == 1 || m_nReaders == 1)
+    {
+      m_condition.notify_one();
+    }
+    else
+    {
+      m_condition.notify_all();
+    }
+  }
+
+  /**
+   * Move up to max elements to out. Called with m_mutex held.
+   *
+   * @param out
+   * @param max
+   *
+   * @return Number of elements moved
+   */
+  template <typename OutputIt>
+  std::size_t drain(OutputIt& out, const std::size_t max)
+  {
+    std::size_t n = 0;
+    for (; n < max && !m_queue.empty(); ++n, ++out)
+    {
+      *out = std::move(m_queue.front());
+      m_queue.pop();
+    }
+    return n;
+  }
+
   std::queue<T> m_queue;      ///< Queue with callables
   mutable std::mutex m_mutex; ///< Mutex for locking
 
   std::atomic<bool> m_valid{ true };   ///< State for invalidation
   std::condition_variable m_condition; ///< Condition for signal not empty
+  std::size_t m_nReaders{ 0 };         ///< Readers waiting, guarded by m_mutex
 };
 
 template <typename T>
@@ -362,12 +500,18 @@ public:
    * Push element onto queue
    *
    * @param source
+   *
+   * @return False if the queue is invalidated
    */
   bool push(const T& source)
   {
     std::lock_guard<std::mutex> guard(this->m_mutex);
+    if (!this->m_valid)
+    {
+      return false;
+    }
     this->m_queue.push(source);
-    this->m_condition.notify_one();
+    this->notifyReaders(1);
     return true;
   }
 };
@@ -498,6 +642,8 @@ protected:
   std::condition_variable m_cond_not_empty;
   std::condition_variable m_cond_not_full;
   std::atomic<bool> m_valid{ true }; ///< State for invalidation
+  size_type m_nReaders{ 0 };         ///< Readers waiting, guarded by m_mutex
+  size_type m_nWriters{ 0 };         ///< Writers waiting, guarded by m_mutex
 
   size_type capacity() const { return m_capacity; }
 
@@ -505,6 +651,79 @@ protected:
 
   bool is_not_full() const { return m_unread < m_capacity; }
 
+  /**
+   * Wait until the buffer is non-empty or invalidated. Waiting
+   * threads are counted, such that the other side only notifies if
+   * needed.
+   *
+   * @param lock Lock holding m_mutex
+   */
+  void waitNotEmpty(std::unique_lock<std::mutex>& lock)
+  {
+    m_nReaders++;
+    m_cond_not_empty.wait(lock, [this]() { return this->is_not_empty() || !m_valid; });
+    m_nReaders--;
+  }
+
+  /**
+   * Wait until the buffer is non-full or invalidated
+   *
+   * @param lock Lock holding m_mutex
+   */
+  void waitNotFull(std::unique_lock<std::mutex>& lock)
+  {
+    m_nWriters++;
+    m_cond_not_full.wait(lock, [this]() { return this->is_not_full() || !m_valid; });
+    m_nWriters--;
+  }
+
+  /**
+   * Notify waiting threads after n elements are pushed or popped.
+   * Called with m_mutex held.
+   *
+   * @param condition Condition waited on
+   * @param nWaiting Number of threads waiting
+   * @param n Number of elements
+   */
+  static void Notify(std::condition_variable& condition, const size_type nWaiting, const size_t n)
+  {
+    if (n == 0 || nWaiting == 0)
+    {
+      return;
+    }
+    if (n == 1 || nWaiting == 1)
+    {
+      condition.notify_one();
+    }
+    else
+    {
+      condition.notify_all();
+    }
+  }
+
+  /**
+   * Move up to max elements to out and notify writers. Called with
+   * m_mutex held.
+   *
+   * @param out
+   * @param max
+   *
+   * @return Number of elements moved
+   */
+  template <typename OutputIt>
+  size_t drain(OutputIt& out, const size_t max)
+  {
+    size_t n = 0;
+    for (; n < max && this->is_not_empty(); ++n, ++out)
+    {
+      *out = std::move(m_container.front());
+      m_container.pop();
+      m_unread--;
+    }
+    Notify(m_cond_not_full, m_nWriters, n);
+    return n;
+  }
+
 public:
   /**
    * Ctor
@@ -527,7 +746,7 @@ public:
   bool push(value_type&& source) override
   {
     std::unique_lock<std::mutex> lock{ m_mutex };
-    m_cond_not_full.wait(lock, [&]() { return this->is_not_full() || !m_valid; });
+    waitNotFull(lock);
 
     if (!m_valid)
     {
@@ -536,7 +755,7 @@ public:
 
     m_container.push(std::move(source));
     m_unread++;
-    m_cond_not_empty.notify_one();
+    Notify(m_cond_not_empty, m_nReaders, 1);
     return true;
   }
 #else
@@ -548,7 +767,7 @@ public:
   bool push(T source)
   {
     std::unique_lock<std::mutex> lock{ m_mutex };
-    m_cond_not_full.wait(lock, [&]() { return this->is_not_full() || !m_valid; });
+    waitNotFull(lock);
 
     if (!m_valid)
     {
@@ -556,7 +775,7 @@ public:
     }
     m_container.push(source);
     m_unread++;
-    m_cond_not_empty.notify_one();
+    Notify(m_cond_not_empty, m_nReaders, 1);
     return true;
   }
 #endif
@@ -571,13 +790,7 @@ public:
   bool pop(T& destination) SPS_OVERRIDE
   {
     std::unique_lock<std::mutex> lock{ m_mutex };
-
-    m_cond_not_empty.wait(lock,
-      [this]()
-      {
-        // Lock is acquired for evaluating predicate
-        return this->is_not_empty() || !m_valid;
-      });
+    waitNotEmpty(lock);
     // Lock is now reacquired
     if (!m_valid)
     {
@@ -586,7 +799,7 @@ public:
     destination = std::move(m_container.front());
     m_container.pop();
     m_unread--;
-    m_cond_not_full.notify_one();
+    Notify(m_cond_not_full, m_nWriters, 1);
     return true;
   }
 
@@ -603,7 +816,7 @@ public:
       destination = std::move(m_container.front());
       m_container.pop();
       m_unread--;
-      m_cond_not_full.notify_one();
+      Notify(m_cond_not_full, m_nWriters, 1);
       return true;
     }
     else
@@ -612,6 +825,83 @@ public:
     }
   }
 
+  /**
+   * Push a range of elements onto ring buffer using a single lock and
+   * a single notification, while there is room. The elements are
+   * moved from. Blocks while the buffer is full.
+   *
+   * @param first
+   * @param last
+   *
+   * @return False if the buffer is invalidated before all elements
+   *         are pushed
+   */
+  template <typename InputIt>
+  bool push_bulk(InputIt first, InputIt last)
+  {
+    std::unique_lock<std::mutex> lock{ m_mutex };
+    while (first != last)
+    {
+      waitNotFull(lock);
+      if (!m_valid)
+      {
+        return false;
+      }
+      size_t n = 0;
+      for (; first != last && this->is_not_full(); ++first, ++n)
+      {
+        m_container.push(std::move(*first));
+        m_unread++;
+      }
+      Notify(m_cond_not_empty, m_nReaders, n);
+    }
+    return true;
+  }
+
+  /**
+   * Pop up to max elements using a single lock
+   *
+   * @param out Output iterator, to which the elements are moved
+   * @param max Maximum number of elements
+   *
+   * @return Number of elements popped
+   */
+  template <typename OutputIt>
+  size_t try_pop_bulk(OutputIt out, size_t max)
+  {
+    std::lock_guard<std::mutex> guard{ m_mutex };
+    if (!m_valid)
+    {
+      return 0;
+    }
+    return drain(out, max);
+  }
+
+  /**
+   * Pop up to max elements using a single lock. Blocks until at least
+   * one element is available unless the buffer is invalidated.
+   *
+   * @param out Output iterator, to which the elements are moved
+   * @param max Maximum number of elements
+   *
+   * @return Number of elements popped, zero if the buffer is invalidated
+   */
+  template <typename OutputIt>
+  size_t pop_bulk(OutputIt out, size_t max)
+  {
+    if (max == 0)
+    {
+      return 0;
+    }
+    std::unique_lock<std::mutex> lock{ m_mutex };
+    waitNotEmpty(lock);
+    if (!m_valid)
+    {
+      return 0;
+    }
+    return drain(out, max);
+  }
+
   /**
    * Destructor. Invalidate and empty queue
    *
@@ -664,7 +954,7 @@ public:
   bool push(const T& source)
   {
     std::unique_lock<std::mutex> lock{ this->m_mutex };
-    this->m_cond_not_full.wait(lock, [&]() { return this->is_not_full() || !this->m_valid; });
+    this->waitNotFull(lock);
 
     if (!this->m_valid)
     {
@@ -672,9 +962,500 @@ public:
     }
     this->m_container.push(source);
     this->m_unread++;
-    this->m_cond_not_empty.notify_one();
+    this->Notify(this->m_cond_not_empty, this->m_nReaders, 1);
+    return true;
+  }
+};
+
+/*! \brief Bounded lock-free Multi-Reader-Multi-Writer Queue
+ *
+ * @tparam T type of objects administered
+ * @tparam Size capacity, must be a power of two
+ *
+ * Bounded queue using a fixed array of cache-line aligned cells,
+ * each with a sequence number telling whether it is ready for the
+ * writer or the reader of a given position (D. Vyukov). Writers and
+ * readers claim positions using a single compare-and-swap and never
+ * allocate or take a lock, unless they block.
+ *
+ * It implements both @ref IMRMWQueue and @ref IMRMWCircularBuffer
+ * (without overwrite), such that it may replace @ref MRMWQueue,
+ * e.g. as ThreadPool::QueueImpl, when the number of elements queued
+ * is bounded. @ref push blocks while the queue is full, @ref pop
+ * blocks while it is empty. Blocked threads wait on a condition
+ * variable, which is only notified if somebody is waiting.
+ *
+ */
+template <typename T, size_t Size, bool = is_copy_constructible<T>::value>
+class MRMWBoundedQueue
+  : public IMRMWQueue<T, is_copy_constructible<T>::value>
+  , public IMRMWCircularBuffer<T, Size, false, is_copy_constructible<T>::value>
+{
+  static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "Size must be a power of two");
+
+public:
+  /**
+   * Ctor
+   *
+   *
+   * @return
+   */
+  MRMWBoundedQueue()
+  {
+    for (size_t i = 0; i < Size; i++)
+    {
+      m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Destructor. Invalidate and empty queue
+   *
+   */
+  ~MRMWBoundedQueue() override
+  {
+    invalidate();
+    clear();
+  }
+
+  /**
+   * Capacity of the queue
+   *
+   * @return
+   */
+  static constexpr size_t capacity() { return Size; }
+
+  /**
+   * Push element onto queue, if not full
+   *
+   * @param source Moved from if pushed
+   *
+   * @return True if pushed, false if full
+   */
+  bool try_push(T&& source)
+  {
+    if (!enqueue(std::move(source)))
+    {
+      return false;
+    }
+    notifyReaders();
     return true;
   }
+
+  /**
+   * Push element onto queue. Will block while the queue is full
+   * unless the queue is invalidated.
+   *
+   * @param source
+   *
+   * @return True if pushed, false if the queue is invalidated
+   */
+  bool push(T&& source) SPS_OVERRIDE
+  {
+    if (!m_valid.load(std::memory_order_relaxed))
+    {
+      return false;
+    }
+    if (try_push(std::move(source)))
+    {
+      return true;
+    }
+    bool pushed = false;
+    {
+      std::unique_lock<std::mutex> lock{ m_mutex };
+      m_nWriters.fetch_add(1);
+      while (m_valid && !(pushed = enqueue(std::move(source))))
+      {
+        m_condNotFull.wait(lock);
+      }
+      m_nWriters.fetch_sub(1);
+    }
+    if (pushed)
+    {
+      notifyReaders();
+    }
+    return pushed;
+  }
+
+  /**
+   * Push a range of elements onto queue. The elements are moved
+   * from. Blocks while the queue is full.
+   *
+   * @param first
+   * @param last
+   *
+   * @return False if the queue is invalidated before all elements
+   *         are pushed
+   */
+  template <typename InputIt>
+  bool push_bulk(InputIt first, InputIt last)
+  {
+    for (; first != last; ++first)
+    {
+      if (!push(std::move(*first)))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Pop first element in the queue.
+   *
+   * @param destination
+   *
+   * @return True if a value is written to destination, false if the
+   * queue is empty or invalidated
+   */
+  bool try_pop(T& destination) SPS_OVERRIDE
+  {
+    if (!m_valid.load(std::memory_order_relaxed) ||
+      !dequeue([&destination](T&& element) { destination = std::move(element); }))
+    {
+      return false;
+    }
+    notifyWriters();
+    return true;
+  }
+
+  /**
+   * Pop first element in queue. Will block until a value is
+   * available unless the queue is invalidated.
+   *
+   * @param destination
+   *
+   * @return True if a value is written to destination, false
+   * otherwise
+   */
+  bool pop(T& destination) SPS_OVERRIDE
+  {
+    if (!m_valid.load(std::memory_order_relaxed))
+    {
+      return false;
+    }
+    if (try_pop(destination))
+    {
+      return true;
+    }
+    bool popped = false;
+    {
+      std::unique_lock<std::mutex> lock{ m_mutex };
+      m_nReaders.fetch_add(1);
+      while (m_valid &&
+        !(popped = dequeue([&destination](T&& element) { destination = std::move(element); })))
+      {
+        m_condNotEmpty.wait(lock);
+      }
+      m_nReaders.fetch_sub(1);
+    }
+    if (popped)
+    {
+      notifyWriters();
+    }
+    return popped;
+  }
+
+  /**
+   * Pop up to max elements
+   *
+   * @param out Output iterator, to which the elements are moved
+   * @param max Maximum number of elements
+   *
+   * @return Number of elements popped, zero if the queue is invalidated
+   */
+  template <typename OutputIt>
+  size_t try_pop_bulk(OutputIt out, size_t max)
+  {
+    if (!m_valid.load(std::memory_order_relaxed))
+    {
+      return 0;
+    }
+    const size_t n = drain(out, max);
+    if (n > 0)
+    {
+      notifyWriters(n);
+    }
+    return n;
+  }
+
+  /**
+   * Pop up to max elements. Blocks until at least one element is
+   * available unless the queue is invalidated.
+   *
+   * @param out Output iterator, to which the elements are moved
+   * @param max Maximum number of elements
+   *
+   * @return Number of elements popped, zero if the queue is invalidated
+   */
+  template <typename OutputIt>
+  size_t pop_bulk(OutputIt out, size_t max)
+  {
+    if (max == 0 || !m_valid.load(std::memory_order_relaxed))
+    {
+      return 0;
+    }
+    size_t n = drain(out, max);
+    if (n == 0)
+    {
+      std::unique_lock<std::mutex> lock{ m_mutex };
+      m_nReaders.fetch_add(1);
+      while (m_valid && (n = drain(out, max)) == 0)
+      {
+        m_condNotEmpty.wait(lock);
+      }
+      m_nReaders.fetch_sub(1);
+    }
+    if (n > 0)
+    {
+      notifyWriters(n);
+    }
+    return n;
+  }
+
+  /**
+   * Invalidate the queue. Blocked readers and writers return false.
+   *
+   */
+  void invalidate() SPS_OVERRIDE
+  {
+    std::lock_guard<std::mutex> guard{ m_mutex };
+    m_valid.store(false);
+    m_condNotEmpty.notify_all();
+    m_condNotFull.notify_all();
+  }
+
+  /**
+   * Is the queue valid
+   *
+   *
+   * @return
+   */
+  bool valid() const SPS_OVERRIDE
+  {
+    return m_valid;
+  }
+
+  /**
+   * Clear the queue. Blocked writers are notified
+   *
+   */
+  void clear() SPS_OVERRIDE
+  {
+    size_t n = 0;
+    while (dequeue([](T&&) {}))
+    {
+      n++;
+    }
+    if (n > 0)
+    {
+      notifyWriters(n);
+    }
+  }
+
+  /**
+   * Is the queue empty. The result is a snapshot, when readers or
+   * writers are active.
+   *
+   *
+   * @return
+   */
+  bool empty() const SPS_OVERRIDE
+  {
+    return m_dequeuePos.load(std::memory_order_acquire) >=
+      m_enqueuePos.load(std::memory_order_acquire);
+  }
+
+protected:
+  //! Cell holding an element and its sequence number
+  struct SPS_ALIGNAS(64) Cell
+  {
+    std::atomic<size_t> m_sequence;                ///< Position ready for
+    alignas(T) unsigned char m_storage[sizeof(T)]; ///< Element storage
+  };
+
+  static constexpr size_t Mask = Size - 1;
+
+  /**
+   * Claim a position for writing and move the element into its cell
+   *
+   * @param source
+   *
+   * @return False if full
+   */
+  template <typename U>
+  bool enqueue(U&& source)
+  {
+    Cell* pCell = nullptr;
+    size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      pCell = &m_cells[pos & Mask];
+      const size_t sequence = pCell->m_sequence.load(std::memory_order_acquire);
+      const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0)
+      {
+        if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        // Cell not yet read one lap ago
+        return false;
+      }
+      else
+      {
+        pos = m_enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+    ::new (static_cast<void*>(pCell->m_storage)) T(std::forward<U>(source));
+    pCell->m_sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Claim a position for reading and move the element out of its cell
+   *
+   * @param consume Callable taking the element as T&&
+   *
+   * @return False if empty
+   */
+  template <typename Consume>
+  bool dequeue(Consume&& consume)
+  {
+    Cell* pCell = nullptr;
+    size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      pCell = &m_cells[pos & Mask];
+      const size_t sequence = pCell->m_sequence.load(std::memory_order_acquire);
+      const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0)
+      {
+        if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        // Cell not yet written
+        return false;
+      }
+      else
+      {
+        pos = m_dequeuePos.load(std::memory_order_relaxed);
+      }
+    }
+    T* pElement = std::launder(reinterpret_cast<T*>(pCell->m_storage));
+    consume(std::move(*pElement));
+    pElement->~T();
+    pCell->m_sequence.store(pos + Mask + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Move up to max elements to an output iterator without notifying
+   * writers
+   *
+   * @param out
+   * @param max
+   *
+   * @return Number of elements moved
+   */
+  template <typename OutputIt>
+  size_t drain(OutputIt out, const size_t max)
+  {
+    size_t n = 0;
+    for (; n < max && dequeue([&out](T&& element) { *out = std::move(element); }); ++n)
+    {
+      ++out;
+    }
+    return n;
+  }
+
+  /**
+   * Notify a blocked reader, if any. The read-modify-write is ordered
+   * with the increment of a reader about to block, such that either
+   * the reader sees the element or the writer sees the reader.
+   *
+   */
+  void notifyReaders()
+  {
+    if (m_nReaders.fetch_add(0) > 0)
+    {
+      std::lock_guard<std::mutex> guard{ m_mutex };
+      m_condNotEmpty.notify_one();
+    }
+  }
+
+  /**
+   * Notify blocked writers, if any, after n elements are popped
+   *
+   * @param n
+   */
+  void notifyWriters(const size_t n = 1)
+  {
+    if (m_nWriters.fetch_add(0) > 0)
+    {
+      std::lock_guard<std::mutex> guard{ m_mutex };
+      if (n > 1)
+      {
+        m_condNotFull.notify_all();
+      }
+      else
+      {
+        m_condNotFull.notify_one();
+      }
+    }
+  }
+
+  Cell m_cells[Size];                                    ///< Cells
+  SPS_ALIGNAS(64) std::atomic<size_t> m_enqueuePos{ 0 }; ///< Next position written
+  SPS_ALIGNAS(64) std::atomic<size_t> m_dequeuePos{ 0 }; ///< Next position read
+  SPS_ALIGNAS(64) std::atomic<bool> m_valid{ true };     ///< State for invalidation
+  std::atomic<size_t> m_nReaders{ 0 };                   ///< Readers blocked
+  std::atomic<size_t> m_nWriters{ 0 };                   ///< Writers blocked
+  std::mutex m_mutex;                                    ///< Mutex for blocking
+  std::condition_variable m_condNotEmpty;                ///< Condition for signal not empty
+  std::condition_variable m_condNotFull;                 ///< Condition for signal not full
+};
+
+template <typename T, size_t Size>
+class MRMWBoundedQueue<T, Size, true> : public MRMWBoundedQueue<T, Size, false>
+{
+public:
+  using MRMWBoundedQueue<T, Size, false>::push;
+  using MRMWBoundedQueue<T, Size, false>::try_push;
+
+  /**
+   * Push copy of element onto queue, if not full
+   *
+   * @param source
+   *
+   * @return True if pushed, false if full
+   */
+  bool try_push(const T& source)
+  {
+    T element{ source };
+    return try_push(std::move(element));
+  }
+
+  /**
+   * Push copy of element onto queue. Will block while the queue is
+   * full unless the queue is invalidated.
+   *
+   * @param source
+   *
+   * @return True if pushed, false if the queue is invalidated
+   */
+  bool push(const T& source)
+  {
+    T element{ source };
+    return push(std::move(element));
+  }
 };
 
 } // namespace sps
@@ -13,11 +13,15 @@
 
 #include <iostream>
 
+#include <atomic>
 #include <chrono>
 #include <cstdio>
+#include <iterator>
+#include <memory>
 #include <mutex>
 #include <random>
 #include <thread>
+#include <vector>
 
 #include <sps/mimo.hpp>
 
@@ -134,6 +138,219 @@ TEST(mimo_test, circular_buffer3)
   EXPECT_EQ(1, 1);
 }
 
+TEST(mimo_test, bounded_queue)
+{
+  sps::MRMWBoundedQueue<int, 4> queue;
+  EXPECT_TRUE(queue.empty());
+  for (int i = 0; i < 4; i++)
+  {
+    EXPECT_TRUE(queue.try_push(int(i)));
+  }
+  EXPECT_FALSE(queue.try_push(4));
+  int val = -1;
+  for (int i = 0; i < 4; i++)
+  {
+    EXPECT_TRUE(queue.try_pop(val));
+    EXPECT_EQ(val, i);
+  }
+  EXPECT_FALSE(queue.try_pop(val));
+
+  // Move-only elements through the queue interface
+  sps::MRMWBoundedQueue<std::unique_ptr<int>, 2> pointers;
+  sps::IMRMWQueue<std::unique_ptr<int>>& iface = pointers;
+  iface.push(std::make_unique<int>(42));
+  std::unique_ptr<int> pointer;
+  EXPECT_TRUE(iface.pop(pointer));
+  EXPECT_EQ(*pointer, 42);
+}
+
+TEST(mimo_test, bounded_queue_without_default_constructor)
+{
+  struct Value
+  {
+    explicit Value(int value)
+      : m_value(value)
+    {
+    }
+    int m_value;
+  };
+  sps::MRMWBoundedQueue<Value, 4> queue;
+  std::vector<Value> values{ Value(1), Value(2), Value(3) };
+  EXPECT_TRUE(queue.push_bulk(values.begin(), values.end()));
+
+  std::vector<Value> popped;
+  EXPECT_EQ(queue.try_pop_bulk(std::back_inserter(popped), 1), 1u);
+  EXPECT_EQ(queue.pop_bulk(std::back_inserter(popped), 4), 2u);
+  ASSERT_EQ(popped.size(), 3u);
+  EXPECT_EQ(popped[2].m_value, 3);
+}
+
+/**
+ * Test blocking push and pop with more elements than the capacity
+ * and several readers and writers.
+ *
+ */
+TEST(mimo_test, bounded_queue_threads)
+{
+  sps::MRMWBoundedQueue<int, 8> queue;
+  const int nElements = 10000;
+  const int nThreads = 3;
+  std::atomic<long long> sum{ 0 };
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nThreads; t++)
+  {
+    threads.emplace_back(
+      [&queue, t]()
+      {
+        for (int i = t; i < nElements; i += nThreads)
+        {
+          queue.push(int(i));
+        }
+      });
+    threads.emplace_back(
+      [&queue, &sum, t]()
+      {
+        int value = 0;
+        for (int i = t; i < nElements; i += nThreads)
+        {
+          if (queue.pop(value))
+          {
+            sum += value;
+          }
+        }
+      });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  EXPECT_EQ(sum.load(), static_cast<long long>(nElements) * (nElements - 1) / 2);
+  EXPECT_TRUE(queue.empty());
+
+  // Invalidation releases a blocked reader
+  std::thread reader(
+    [&queue]()
+    {
+      int value = 0;
+      EXPECT_FALSE(queue.pop(value));
+    });
+  std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+  queue.invalidate();
+  reader.join();
+  EXPECT_FALSE(queue.valid());
+}
+
+/**
+ * Test push_bulk, try_pop_bulk and pop_bulk of a queue with room for
+ * at least 8 elements
+ *
+ */
+template <typename Queue>
+static void TestBulk()
+{
+  Queue queue;
+  std::vector<int> values{ 0, 1, 2, 3, 4 };
+  EXPECT_TRUE(queue.push_bulk(values.begin(), values.end()));
+
+  std::vector<int> popped;
+  EXPECT_EQ(queue.try_pop_bulk(std::back_inserter(popped), 3), 3u);
+  EXPECT_EQ(queue.pop_bulk(std::back_inserter(popped), 10), 2u);
+  EXPECT_EQ(popped, values);
+  EXPECT_EQ(queue.try_pop_bulk(std::back_inserter(popped), 10), 0u);
+  EXPECT_TRUE(queue.empty());
+
+  // Batches larger than the consumers drain at a time
+  const int nBatches = 500;
+  const int nBatch = 16;
+  const int nThreads = 2;
+  std::atomic<long long> sum{ 0 };
+  std::atomic<int> nPopped{ 0 };
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nThreads; t++)
+  {
+    threads.emplace_back(
+      [&queue, t]()
+      {
+        std::vector<int> batch(nBatch);
+        for (int i = t; i < nBatches; i += nThreads)
+        {
+          for (int j = 0; j < nBatch; j++)
+          {
+            batch[j] = i * nBatch + j;
+          }
+          queue.push_bulk(batch.begin(), batch.end());
+        }
+      });
+    threads.emplace_back(
+      [&queue, &sum, &nPopped]()
+      {
+        int elements[8];
+        size_t n = 0;
+        while ((n = queue.pop_bulk(elements, 8)) > 0)
+        {
+          for (size_t i = 0; i < n; i++)
+          {
+            sum += elements[i];
+          }
+          nPopped += static_cast<int>(n);
+        }
+      });
+  }
+  while (nPopped.load() < nBatches * nBatch)
+  {
+    std::this_thread::yield();
+  }
+  // Invalidation releases the blocked readers
+  queue.invalidate();
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  const long long nElements = static_cast<long long>(nBatches) * nBatch;
+  EXPECT_EQ(nPopped.load(), nElements);
+  EXPECT_EQ(sum.load(), nElements * (nElements - 1) / 2);
+}
+
+TEST(mimo_test, bulk)
+{
+  TestBulk<sps::MRMWQueue<int>>();
+  TestBulk<sps::MRMWCircularBuffer<int, 8>>();
+  TestBulk<sps::MRMWBoundedQueue<int, 8>>();
+}
+
+/**
+ * Test that single and bulk operations agree on an invalidated queue
+ * still holding elements. Nothing is pushed or popped.
+ *
+ */
+template <typename Queue>
+static void TestInvalidated()
+{
+  Queue queue;
+  std::vector<int> values{ 0, 1, 2, 3 };
+  EXPECT_TRUE(queue.push_bulk(values.begin(), values.end()));
+  queue.invalidate();
+
+  int value = 0;
+  std::vector<int> popped;
+  EXPECT_FALSE(queue.try_pop(value));
+  EXPECT_FALSE(queue.pop(value));
+  EXPECT_EQ(queue.try_pop_bulk(std::back_inserter(popped), 10), 0u);
+  EXPECT_EQ(queue.pop_bulk(std::back_inserter(popped), 10), 0u);
+  EXPECT_TRUE(popped.empty());
+
+  EXPECT_FALSE(queue.push(4));
+  EXPECT_FALSE(queue.push_bulk(values.begin(), values.end()));
+}
+
+TEST(mimo_test, invalidated)
+{
+  TestInvalidated<sps::MRMWQueue<int>>();
+  TestInvalidated<sps::MRMWCircularBuffer<int, 8>>();
+  TestInvalidated<sps::MRMWBoundedQueue<int, 8>>();
+}
+
 #if 0
 static void thread_pop(void* arg) {
   auto pQueue = (sps::MRMWQueue<float>*) arg;
@@ -54,6 +54,10 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <complex>
 
@@ -65,7 +69,6 @@ std::mutex g_plan_mutex;
 // TODO: Solve order of destruction sequence
 
 #include <cstdio>
-#define DEBUG_PLAN 0
 
 // TODO: Avoid static const members with in-class initializers
 #ifdef _MSC_VER
@@ -87,6 +90,94 @@ namespace sps
 #define SPS_FFTW_FAST FFTW_ESTIMATE
 #define SPS_FFTW_ACCURATE FFTW_PATIENT
 
+// Plans from wisdom of FFTW_MEASURE or more rigorous planning, see fft_plan
+#define SPS_FFTW_WISDOM (FFTW_MEASURE | FFTW_WISDOM_ONLY)
+
+/// Convolutions shorter than this use a power of two
+static const size_t nSmoothLengthMinimum = 64;
+
+/// Number of smooth lengths timed, when choosing a convolution length
+static const size_t nSmoothLengthCandidates = 3;
+
+/**
+ * Plans of a thread indexed by their length. Plans are destroyed when
+ * the thread exits, which happens before the singletons are destroyed.
+ */
+template <typename Plan, void (*Destroy)(Plan)>
+class PlanCache
+{
+public:
+  PlanCache() = default;
+  ~PlanCache()
+  {
+    clear();
+  }
+
+  /// Plan of a given length, nullptr if not created
+  Plan& operator[](size_t size)
+  {
+    return m_plans[size];
+  }
+
+  void destroy(size_t size)
+  {
+    auto it = m_plans.find(size);
+    if (it != m_plans.end() && it->second)
+    {
+      std::lock_guard<std::mutex> guard(g_plan_mutex);
+      Destroy(it->second);
+      it->second = nullptr;
+    }
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> guard(g_plan_mutex);
+    for (auto& plan : m_plans)
+    {
+      if (plan.second)
+      {
+        Destroy(plan.second);
+      }
+    }
+    m_plans.clear();
+  }
+
+private:
+  PlanCache(const PlanCache&) = delete;
+  PlanCache& operator=(const PlanCache&) = delete;
+  std::unordered_map<size_t, Plan> m_plans;
+};
+
+/**
+ * Time of a transform, the fastest of a few rounds of at least 2^16
+ * samples each
+ *
+ * @param size Length of transform
+ * @param transform Callable executing the transform
+ *
+ * @return Seconds per transform
+ */
+template <typename Transform>
+double TransformTime(const size_t size, Transform&& transform)
+{
+  const size_t nRepeat = std::max<size_t>(1, (size_t(1) << 16) / size);
+  transform();
+  double best = 0.0;
+  for (size_t iRound = 0; iRound < 3; iRound++)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < nRepeat; i++)
+    {
+      transform();
+    }
+    const double elapsed =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    best = iRound == 0 ? elapsed : std::min(best, elapsed);
+  }
+  return best / double(nRepeat);
+}
+
 template <typename T>
 class Signal1DPlan
 {
@@ -105,9 +196,10 @@ class Signal1DPlan<float>
 {
 public:
   // TODO: Consider storing plans for non-aligned memory
-  static const size_t nFFTLengths = 31;
-  static __THREAD fftwf_plan forward[Signal1DPlan<float>::nFFTLengths];  // NOLINT
-  static __THREAD fftwf_plan backward[Signal1DPlan<float>::nFFTLengths]; // NOLINT
+
+  // Not __THREAD, which for GCC cannot hold objects with a destructor
+  static thread_local PlanCache<fftwf_plan, fftwf_destroy_plan> forward;  // NOLINT
+  static thread_local PlanCache<fftwf_plan, fftwf_destroy_plan> backward; // NOLINT
 
   static const bool measure = false;
 
@@ -115,19 +207,8 @@ public:
 
   static void DestroyPlans()
   {
-    for (size_t i = 0; i < nFFTLengths; i++)
-    {
-      if (forward[i])
-      {
-        fftwf_destroy_plan(forward[i]);
-        forward[i] = nullptr;
-      }
-      if (backward[i])
-      {
-        fftwf_destroy_plan(backward[i]);
-        backward[i] = nullptr;
-      }
-    }
+    forward.clear();
+    backward.clear();
   }
 
   static Signal1DPlan& Instance()
@@ -139,19 +220,15 @@ public:
 
   fftwf_plan& Forward(size_t size, float* in, std::complex<float>* out)
   {
-    // Check power of two
-    assert(size && ((size & (size - 1))) == 0);
-    size_t index = static_cast<size_t>(log2(size));
-
     if (Signal1DPlan<float>::reuse == false)
     {
-      fftwf_destroy_plan(forward[index]);
-      forward[index] = nullptr;
+      forward.destroy(size);
     }
 
-    if (forward[index])
+    fftwf_plan& plan = forward[size];
+    if (plan)
     {
-      return forward[index];
+      return plan;
     }
     else
     {
@@ -161,34 +238,29 @@ public:
       {
         float* dummy = static_cast<float*>(_mm_malloc(size * sizeof(float), 16));
         memcpy(dummy, in, size * sizeof(float));
-        forward[index] = fftwf_plan_dft_r2c_1d(
+        plan = fftwf_plan_dft_r2c_1d(
           static_cast<int>(size), dummy, reinterpret_cast<fftwf_complex*>(out), SPS_FFTW_ACCURATE);
         _mm_free(dummy);
       }
       else
       {
-        forward[index] = fftwf_plan_dft_r2c_1d(
-          static_cast<int>(size), in, reinterpret_cast<fftwf_complex*>(out), SPS_FFTW_FAST);
+        plan = PlanForward(size, in, reinterpret_cast<fftwf_complex*>(out));
       }
-      return forward[index];
+      return plan;
     }
   }
 
   fftwf_plan& Backward(size_t size, std::complex<float>* in, float* out)
   {
-    // Check power of two
-    assert(size && ((size & (size - 1))) == 0);
-    size_t index = static_cast<size_t>(log2(size));
-
     if (Signal1DPlan<float>::reuse == false)
     {
-      fftwf_destroy_plan(backward[index]);
-      backward[index] = nullptr;
+      backward.destroy(size);
     }
 
-    if (backward[index])
+    fftwf_plan& plan = backward[size];
+    if (plan)
     {
-      return backward[index];
+      return plan;
     }
     else
     {
@@ -201,20 +273,144 @@ public:
         size_t nbytes = 16 * ((nComplex + 1) * sizeof(std::complex<float>) + 15) / 16;
         std::complex<float>* dummy = static_cast<std::complex<float>*>(_mm_malloc(nbytes, 16));
         memcpy(dummy, in, nComplex * sizeof(std::complex<float>));
-        backward[index] = fftwf_plan_dft_c2r_1d(
+        plan = fftwf_plan_dft_c2r_1d(
           static_cast<int>(size), reinterpret_cast<fftwf_complex*>(dummy), out, SPS_FFTW_ACCURATE);
         _mm_free(dummy);
       }
       else
       {
-        backward[index] = fftwf_plan_dft_c2r_1d(
-          static_cast<int>(size), reinterpret_cast<fftwf_complex*>(in), out, SPS_FFTW_FAST);
+        plan = PlanBackward(size, reinterpret_cast<fftwf_complex*>(in), out);
+      }
+      return plan;
+    }
+  }
+
+  /**
+   * Time of a forward and a backward transform. Measured once per
+   * length using the plans created at runtime, so wisdom should be
+   * imported before. Only planning holds the planner mutex, the
+   * timing uses private plans and runs concurrently with other
+   * threads. If two threads time a length, the first cost stored is
+   * kept.
+   *
+   * @param size Length of transform
+   *
+   * @return Seconds
+   */
+  double Cost(size_t size)
+  {
+    {
+      std::lock_guard<std::mutex> guard(g_plan_mutex);
+      auto it = m_costs.find(size);
+      if (it != m_costs.end())
+      {
+        return it->second;
+      }
+    }
+
+    const size_t nComplex = size / 2 + 1;
+    float* in = static_cast<float*>(_mm_malloc(2 * nComplex * sizeof(float), 16));
+    fftwf_complex* out =
+      static_cast<fftwf_complex*>(_mm_malloc(nComplex * sizeof(fftwf_complex), 16));
+    fftwf_plan r2c = nullptr;
+    fftwf_plan c2r = nullptr;
+    {
+      std::lock_guard<std::mutex> guard(g_plan_mutex);
+      r2c = PlanForward(size, in, out);
+      c2r = PlanBackward(size, out, in);
+    }
+    memset(in, 0, 2 * nComplex * sizeof(float));
+
+    // Executing distinct plans is thread-safe
+    const double cost = TransformTime(size,
+      [&]()
+      {
+        fftwf_execute(r2c);
+        fftwf_execute(c2r);
+      });
+
+    _mm_free(in);
+    _mm_free(out);
+    std::lock_guard<std::mutex> guard(g_plan_mutex);
+    fftwf_destroy_plan(r2c);
+    fftwf_destroy_plan(c2r);
+    return m_costs.emplace(size, cost).first->second;
+  }
+
+  /**
+   * Plan forward and backward transforms, such that they are
+   * remembered as wisdom. Arrays allocated for transforms are aligned
+   * to 16 bytes, but may be aligned to 32 bytes, so both are planned.
+   *
+   * @param size Length of transform
+   * @param flags Planner flags, e.g. FFTW_PATIENT
+   * @param seconds Time limit per plan, negative for no limit
+   *
+   * @return False if not planned
+   */
+  bool Plan(size_t size, unsigned flags, double seconds)
+  {
+    const size_t nComplex = size / 2 + 1;
+    float* pReal = static_cast<float*>(_mm_malloc(2 * nComplex * sizeof(float) + 32, 32));
+    fftwf_complex* pComplex =
+      static_cast<fftwf_complex*>(_mm_malloc(nComplex * sizeof(fftwf_complex) + 32, 32));
+    bool retval = true;
+    {
+      std::lock_guard<std::mutex> guard(g_plan_mutex);
+      fftwf_set_timelimit(seconds < 0.0 ? FFTW_NO_TIMELIMIT : seconds);
+      for (size_t offset = 0; offset < 32; offset += 16)
+      {
+        float* in = pReal + offset / sizeof(float);
+        fftwf_complex* out = pComplex + offset / sizeof(fftwf_complex);
+        fftwf_plan r2c = fftwf_plan_dft_r2c_1d(static_cast<int>(size), in, out, flags);
+        fftwf_plan c2r = fftwf_plan_dft_c2r_1d(static_cast<int>(size), out, in, flags);
+        retval = retval && r2c && c2r;
+        if (r2c)
+        {
+          fftwf_destroy_plan(r2c);
+        }
+        if (c2r)
+        {
+          fftwf_destroy_plan(c2r);
+        }
       }
-      return backward[index];
+      fftwf_set_timelimit(FFTW_NO_TIMELIMIT);
     }
+    _mm_free(pReal);
+    _mm_free(pComplex);
+    return retval;
+  }
+
+  static bool WisdomExport(const char* filename)
+  {
+    std::lock_guard<std::mutex> guard(g_plan_mutex);
+    return fftwf_export_wisdom_to_filename(filename) != 0;
+  }
+
+  static bool WisdomImport(const char* filename)
+  {
+    std::lock_guard<std::mutex> guard(g_plan_mutex);
+    return fftwf_import_wisdom_from_filename(filename) != 0;
   }
 
 private:
+  /**
+   * Plan from wisdom if available, otherwise estimate. The planner
+   * mutex must be held.
+   *
+   */
+  static fftwf_plan PlanForward(size_t size, float* in, fftwf_complex* out)
+  {
+    fftwf_plan plan = fftwf_plan_dft_r2c_1d(static_cast<int>(size), in, out, SPS_FFTW_WISDOM);
+    return plan ? plan : fftwf_plan_dft_r2c_1d(static_cast<int>(size), in, out, SPS_FFTW_FAST);
+  }
+
+  static fftwf_plan PlanBackward(size_t size, fftwf_complex* in, float* out)
+  {
+    fftwf_plan plan = fftwf_plan_dft_c2r_1d(static_cast<int>(size), in, out, SPS_FFTW_WISDOM);
+    return plan ? plan : fftwf_plan_dft_c2r_1d(static_cast<int>(size), in, out, SPS_FFTW_FAST);
+  }
+
   Signal1DPlan()
   {
 #if USE_FFTW_THREADS
@@ -224,49 +420,28 @@ private:
   }
   ~Signal1DPlan()
   {
+    // Plans are destroyed with the threads
 #if USE_FFTW_THREADS
     fftw_cleanup_threads();
 #else
     fftw_cleanup();
 #endif
-
-#if DEBUG_PLAN
-    FILE* fp = fopen("out.txt", "w");
-#endif
-    for (size_t i = 0; i < nFFTLengths; i++)
-    {
-      if (forward[i])
-      {
-#if DEBUG_PLAN
-        fftwf_fprint_plan(forward[i], fp);
-#endif
-        fftwf_destroy_plan(forward[i]);
-        forward[i] = nullptr;
-      }
-      if (backward[i])
-      {
-        fftwf_destroy_plan(backward[i]);
-        backward[i] = nullptr;
-      }
-    }
-#if DEBUG_PLAN
-    fclose(fp);
-#endif
   }
   Signal1DPlan(Signal1DPlan const&) = default;
   Signal1DPlan& operator=(Signal1DPlan const&) = default;
+
+  std::unordered_map<size_t, double> m_costs; ///< Cost of lengths, guarded by g_plan_mutex
 };
 
-__THREAD fftwf_plan Signal1DPlan<float>::forward[Signal1DPlan<float>::nFFTLengths] = { NULL };
-__THREAD fftwf_plan Signal1DPlan<float>::backward[Signal1DPlan<float>::nFFTLengths] = { nullptr };
+thread_local PlanCache<fftwf_plan, fftwf_destroy_plan> Signal1DPlan<float>::forward;
+thread_local PlanCache<fftwf_plan, fftwf_destroy_plan> Signal1DPlan<float>::backward;
 
 template <>
 class Signal1DPlan<double>
 {
 public:
-  static const size_t nFFTLengths = 31;
-  static __THREAD fftw_plan forward[Signal1DPlan<double>::nFFTLengths];
-  static __THREAD fftw_plan backward[Signal1DPlan<double>::nFFTLengths];
+  static thread_local PlanCache<fftw_plan, fftw_destroy_plan> forward;
+  static thread_local PlanCache<fftw_plan, fftw_destroy_plan> backward;
 
   static Signal1DPlan& Instance()
   {
@@ -274,80 +449,282 @@ public:
     static Signal1DPlan singleton;
     return singleton;
   }
-  /*
-  void Wisdom(size_t** nFFTSamples, size_t* nFFTs) {
-    *nFFTs = nFFTLengths;
-    size_t* _nFFTSamples = (size_t*) malloc(Signal1DPlan<double>::nFFTLengths * sizeof(size_t));
-
-    for (size_t i = 0 ; i < nFFTLengths ; i++) {
-      if (forward[i] != nullptr) {
-        (*nFFTSamples)[i] = pow(2.0f, (double)i);
-      }
-    }
-    *nFFTSamples = _nFFTSamples;
-  }
-  */
 
   fftw_plan& Forward(size_t size, double* in, std::complex<double>* out)
   {
-    // Check power of two
-    assert(size && ((size & (size - 1))) == 0);
-    size_t index = static_cast<size_t>(log2(size));
-    if (forward[index])
+    fftw_plan& plan = forward[size];
+    if (plan)
     {
-      return forward[index];
+      return plan;
     }
     else
     {
       std::lock_guard<std::mutex> guard(g_plan_mutex);
-      forward[index] = fftw_plan_dft_r2c_1d(
-        static_cast<int>(size), in, reinterpret_cast<fftw_complex*>(out), SPS_FFTW_FAST);
-      return forward[index];
+      plan = PlanForward(size, in, reinterpret_cast<fftw_complex*>(out));
+      return plan;
     }
   }
 
   fftw_plan& Backward(size_t size, std::complex<double>* in, double* out)
   {
-    // Check power of two
-    assert(size && ((size & (size - 1))) == 0);
-    size_t index = static_cast<size_t>(log2(size));
-    if (backward[index])
+    fftw_plan& plan = backward[size];
+    if (plan)
     {
-      return backward[index];
+      return plan;
     }
     else
     {
       std::lock_guard<std::mutex> guard(g_plan_mutex);
-      backward[index] = fftw_plan_dft_c2r_1d(
-        static_cast<int>(size), reinterpret_cast<fftw_complex*>(in), out, SPS_FFTW_FAST);
-      return backward[index];
+      plan = PlanBackward(size, reinterpret_cast<fftw_complex*>(in), out);
+      return plan;
     }
   }
 
-private:
-  Signal1DPlan() {}
-  ~Signal1DPlan()
+  /**
+   * Time of a forward and a backward transform. Measured once per
+   * length using the plans created at runtime, so wisdom should be
+   * imported before. Only planning holds the planner mutex, the
+   * timing uses private plans and runs concurrently with other
+   * threads. If two threads time a length, the first cost stored is
+   * kept.
+   *
+   * @param size Length of transform
+   *
+   * @return Seconds
+   */
+  double Cost(size_t size)
   {
-    for (size_t i = 0; i < nFFTLengths; i++)
     {
-      if (forward[i])
+      std::lock_guard<std::mutex> guard(g_plan_mutex);
+      auto it = m_costs.find(size);
+      if (it != m_costs.end())
       {
-        fftw_destroy_plan(forward[i]);
-        forward[i] = nullptr;
+        return it->second;
       }
-      if (backward[i])
+    }
+
+    const size_t nComplex = size / 2 + 1;
+    double* in = static_cast<double*>(_mm_malloc(2 * nComplex * sizeof(double), 16));
+    fftw_complex* out =
+      static_cast<fftw_complex*>(_mm_malloc(nComplex * sizeof(fftw_complex), 16));
+    fftw_plan r2c = nullptr;
+    fftw_plan c2r = nullptr;
+    {
+      std::lock_guard<std::mutex> guard(g_plan_mutex);
+      r2c = PlanForward(size, in, out);
+      c2r = PlanBackward(size, out, in);
+    }
+    memset(in, 0, 2 * nComplex * sizeof(double));
+
+    // Executing distinct plans is thread-safe
+    const double cost = TransformTime(size,
+      [&]()
+      {
+        fftw_execute(r2c);
+        fftw_execute(c2r);
+      });
+
+    _mm_free(in);
+    _mm_free(out);
+    std::lock_guard<std::mutex> guard(g_plan_mutex);
+    fftw_destroy_plan(r2c);
+    fftw_destroy_plan(c2r);
+    return m_costs.emplace(size, cost).first->second;
+  }
+
+  /**
+   * Plan forward and backward transforms, such that they are
+   * remembered as wisdom. Arrays allocated for transforms are aligned
+   * to 16 bytes, but may be aligned to 32 bytes, so both are planned.
+   *
+   * @param size Length of transform
+   * @param flags Planner flags, e.g. FFTW_PATIENT
+   * @param seconds Time limit per plan, negative for no limit
+   *
+   * @return False if not planned
+   */
+  bool Plan(size_t size, unsigned flags, double seconds)
+  {
+    const size_t nComplex = size / 2 + 1;
+    double* pReal = static_cast<double*>(_mm_malloc(2 * nComplex * sizeof(double) + 32, 32));
+    fftw_complex* pComplex =
+      static_cast<fftw_complex*>(_mm_malloc(nComplex * sizeof(fftw_complex) + 32, 32));
+    bool retval = true;
+    {
+      std::lock_guard<std::mutex> guard(g_plan_mutex);
+      fftw_set_timelimit(seconds < 0.0 ? FFTW_NO_TIMELIMIT : seconds);
+      for (size_t offset = 0; offset < 32; offset += 16)
       {
-        fftw_destroy_plan(backward[i]);
-        backward[i] = nullptr;
+        double* in = pReal + offset / sizeof(double);
+        fftw_complex* out = pComplex + offset / sizeof(fftw_complex);
+        fftw_plan r2c = fftw_plan_dft_r2c_1d(static_cast<int>(size), in, out, flags);
+        fftw_plan c2r = fftw_plan_dft_c2r_1d(static_cast<int>(size), out, in, flags);
+        retval = retval && r2c && c2r;
+        if (r2c)
+        {
+          fftw_destroy_plan(r2c);
+        }
+        if (c2r)
+        {
+          fftw_destroy_plan(c2r);
+        }
       }
+      fftw_set_timelimit(FFTW_NO_TIMELIMIT);
     }
+    _mm_free(pReal);
+    _mm_free(pComplex);
+    return retval;
+  }
+
+  static bool WisdomExport(const char* filename)
+  {
+    std::lock_guard<std::mutex> guard(g_plan_mutex);
+    return fftw_export_wisdom_to_filename(filename) != 0;
+  }
+
+  static bool WisdomImport(const char* filename)
+  {
+    std::lock_guard<std::mutex> guard(g_plan_mutex);
+    return fftw_import_wisdom_from_filename(filename) != 0;
+  }
+
+private:
+  /**
+   * Plan from wisdom if available, otherwise estimate. The planner
+   * mutex must be held.
+   *
+   */
+  static fftw_plan PlanForward(size_t size, double* in, fftw_complex* out)
+  {
+    fftw_plan plan = fftw_plan_dft_r2c_1d(static_cast<int>(size), in, out, SPS_FFTW_WISDOM);
+    return plan ? plan : fftw_plan_dft_r2c_1d(static_cast<int>(size), in, out, SPS_FFTW_FAST);
+  }
+
+  static fftw_plan PlanBackward(size_t size, fftw_complex* in, double* out)
+  {
+    fftw_plan plan = fftw_plan_dft_c2r_1d(static_cast<int>(size), in, out, SPS_FFTW_WISDOM);
+    return plan ? plan : fftw_plan_dft_c2r_1d(static_cast<int>(size), in, out, SPS_FFTW_FAST);
   }
+
+  Signal1DPlan() {}
+  ~Signal1DPlan() {}
   Signal1DPlan(Signal1DPlan const&) = default;
   Signal1DPlan& operator=(Signal1DPlan const&) = default;
+
+  std::unordered_map<size_t, double> m_costs; ///< Cost of lengths, guarded by g_plan_mutex
 };
 
-__THREAD fftw_plan Signal1DPlan<double>::forward[Signal1DPlan<double>::nFFTLengths] = { nullptr };
-__THREAD fftw_plan Signal1DPlan<double>::backward[Signal1DPlan<double>::nFFTLengths] = { nullptr };
+thread_local PlanCache<fftw_plan, fftw_destroy_plan> Signal1DPlan<double>::forward;
+thread_local PlanCache<fftw_plan, fftw_destroy_plan> Signal1DPlan<double>::backward;
+
+/**
+ * Operation count of a smooth length, the length times the sum of its
+ * prime factors
+ *
+ * @param size 7-smooth length
+ *
+ * @return
+ */
+static double SmoothLengthOperations(size_t size)
+{
+  const size_t primes[] = { 2, 3, 5, 7 };
+  size_t sum = 0;
+  size_t remainder = size;
+  for (const size_t prime : primes)
+  {
+    while (remainder % prime == 0)
+    {
+      remainder /= prime;
+      sum += prime;
+    }
+  }
+  return double(size) * double(sum);
+}
+
+/**
+ * Complex samples of a real transform of length n, n/2+1, rounded up
+ * to an even number, since the SSE multiply takes two at a time
+ *
+ * @param n Length of transform
+ *
+ * @return
+ */
+static size_t ComplexLengthEven(const size_t n)
+{
+  return 2 * ((n / 2 + 2) / 2);
+}
+
+/**
+ * Transform length for a linear convolution. The 7-smooth lengths
+ * (2^a 3^b 5^c 7^d) between the required length and the next power of
+ * two with the lowest operation count are timed and the fastest is
+ * chosen. The choice is made once per required length, the timing
+ * is done without holding a lock, see @ref fft_convolution_lengths
+ * for choosing ahead of time.
+ *
+ * @param nMinimum Required length, n_a + n_b - 1
+ *
+ * @return
+ */
+template <typename T>
+size_t ConvolutionLength(const size_t nMinimum)
+{
+  const size_t nPowerTwo = next_power_two<size_t>(nMinimum);
+  if (nMinimum < nSmoothLengthMinimum)
+  {
+    return nPowerTwo;
+  }
+
+  static std::mutex mutex;
+  static std::unordered_map<size_t, size_t> lengths;
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    auto it = lengths.find(nMinimum);
+    if (it != lengths.end())
+    {
+      return it->second;
+    }
+  }
+
+  // Shortest length for every odd part 3^b 5^c 7^d
+  std::vector<std::pair<double, size_t>> candidates;
+  for (size_t n7 = 1; n7 <= nPowerTwo; n7 *= 7)
+  {
+    for (size_t n5 = n7; n5 <= nPowerTwo; n5 *= 5)
+    {
+      for (size_t n3 = n5; n3 <= nPowerTwo; n3 *= 3)
+      {
+        size_t n = n3;
+        while (n < nMinimum)
+        {
+          n *= 2;
+        }
+        if (n <= nPowerTwo)
+        {
+          candidates.emplace_back(SmoothLengthOperations(n), n);
+        }
+      }
+    }
+  }
+  const size_t nCandidates = std::min(nSmoothLengthCandidates, candidates.size());
+  std::partial_sort(candidates.begin(), candidates.begin() + nCandidates, candidates.end());
+
+  Signal1DPlan<T>& p = Signal1DPlan<T>::Instance();
+  size_t length = nPowerTwo;
+  double cost = p.Cost(nPowerTwo);
+  for (size_t i = 0; i < nCandidates; i++)
+  {
+    const size_t n = candidates[i].second;
+    const double candidateCost = n == nPowerTwo ? cost : p.Cost(n);
+    if (candidateCost < cost)
+    {
+      cost = candidateCost;
+      length = n;
+    }
+  }
+  std::lock_guard<std::mutex> guard(mutex);
+  return lengths.emplace(nMinimum, length).first->second;
+}
 
 // These are explicit specializations (not instantiations), so no need to instantiate
 // template class Signal1DPlan<float>;
@@ -777,7 +1154,7 @@ bool conv_fft<float>(
 
   size_t n_a = a.ndata;
   size_t n_b = b.ndata;
-  size_t n = next_power_two<size_t>(n_a + n_b - 1);
+  size_t n = ConvolutionLength<float>(n_a + n_b - 1);
 
   debug_print("na: %zu, nb: %zu, n: %zu\n", n_a, n_b, n);
 
@@ -801,15 +1178,15 @@ bool conv_fft<float>(
     _b = pad_b ? _mm_padarray<float>(b.data, n_b, n) : b.data;
     assert((reinterpret_cast<uintptr_t>(_b) & 0x0F) == 0 && "Data must be aligned");
 
-    // One extra complex point added to use fast complex multiply (we multiply two at a time)
-    fft_a =
-      static_cast<fftwf_complex*>(SPS_MM_MALLOC(sizeof(fftwf_complex) * ((n / 2 + 1) + 1), 16));
-    fft_b =
-      static_cast<fftwf_complex*>(SPS_MM_MALLOC(sizeof(fftwf_complex) * ((n / 2 + 1) + 1), 16));
+    // Rounded up to an even number of points to use fast complex multiply (we multiply two at a
+    // time)
+    const size_t nComplex = ComplexLengthEven(n);
+    fft_a = static_cast<fftwf_complex*>(SPS_MM_MALLOC(sizeof(fftwf_complex) * nComplex, 16));
+    fft_b = static_cast<fftwf_complex*>(SPS_MM_MALLOC(sizeof(fftwf_complex) * nComplex, 16));
 
     // TEST TO ZERO ARRAYS
-    // memset(fft_a, 0, sizeof(fftwf_complex) * ((n/2+1) + 1));
-    // memset(fft_b, 0, sizeof(fftwf_complex) * ((n/2+1) + 1));
+    // memset(fft_a, 0, sizeof(fftwf_complex) * nComplex);
+    // memset(fft_b, 0, sizeof(fftwf_complex) * nComplex);
 
     // No need to zero output array
     c.ndata = n_a + n_b - 1;
@@ -873,7 +1250,7 @@ bool conv_fft<float>(
 #else
     __m128 divisor = _mm_set1_ps(1.0f / static_cast<float>(n));
 
-    for (size_t i = 0; i < (n / 2 + 1) + 1; i += 2)
+    for (size_t i = 0; i < nComplex; i += 2)
     {
       __m128 vec_a = _mm_load_ps(reinterpret_cast<float*>(&fft_a[i]));
       __m128 vec_b = _mm_load_ps(reinterpret_cast<float*>(&fft_b[i]));
@@ -917,7 +1294,7 @@ bool conv_fft<double>(
 
   size_t n_a = a.ndata;
   size_t n_b = b.ndata;
-  size_t n = next_power_two<size_t>(n_a + n_b - 1);
+  size_t n = ConvolutionLength<double>(n_a + n_b - 1);
 
   bool retval = true;
 
@@ -975,8 +1352,8 @@ bool conv_fft<double>(
 
     fftw_execute_dft_c2r(backward, fft_a, c.data);
 
-    // Why n-1
-    DivideArray<double>(c.data, n - 1, double(n));
+    // All n samples, the last is part of the result when n equals n_a + n_b - 1
+    DivideArray<double>(c.data, n, double(n));
     break;
   }
   if (pad_a)
@@ -1210,15 +1587,16 @@ bool conv_fft_out_in(const signal1D<float>& a, signal1D<float>& b)
 
   size_t n_a = a.ndata;
   size_t n_b = b.ndata;
-  size_t n = next_power_two<size_t>(n_a + n_b - 1);
+  size_t n = ConvolutionLength<float>(n_a + n_b - 1);
 
   bool retval = true;
 
   if (!a.data || !b.data)
     retval = false;
 
-  // Internal samples needed = n/2+1 complex samples + one extra to make an even number, we use SIMD
-  size_t nInternal = 2 * (n / 2 + 2);
+  // Internal samples needed = n/2+1 complex samples rounded up to an even number, we use SIMD
+  const size_t nComplex = ComplexLengthEven(n);
+  size_t nInternal = 2 * nComplex;
 
   while (retval)
   {
@@ -1238,9 +1616,8 @@ bool conv_fft_out_in(const signal1D<float>& a, signal1D<float>& b)
     }
     _b = b.data;
 
-    // One extra point added to use fast complex multiply (we multiply two at a time)
-    fft_a =
-      static_cast<fftwf_complex*>(SPS_MM_MALLOC(sizeof(fftwf_complex) * ((n / 2 + 1) + 1), 16));
+    // Rounded up to an even number of points to use fast complex multiply
+    fft_a = static_cast<fftwf_complex*>(SPS_MM_MALLOC(sizeof(fftwf_complex) * nComplex, 16));
 
     b.ndata = n_a + n_b - 1;
     b.offset = a.offset + b.offset;
@@ -1255,7 +1632,7 @@ bool conv_fft_out_in(const signal1D<float>& a, signal1D<float>& b)
 
     __m128 divisor = _mm_set1_ps(1.0f / static_cast<float>(n));
 
-    for (size_t i = 0; i < (n / 2 + 1) + 1; i += 2)
+    for (size_t i = 0; i < nComplex; i += 2)
     {
       __m128 vec_a = _mm_load_ps(reinterpret_cast<float*>(&fft_a[i]));
       __m128 vec_b = _mm_load_ps(reinterpret_cast<float*>(&_b[2 * i]));
@@ -1522,7 +1899,7 @@ bool mconv_fft(const msignal1D<T>& a, const msignal1D<T>& b, msignal1D<T>& c)
 #if 1
   // [1] * [] = []
 
-  size_t n = next_power_two<size_t>(na + nb - 1);
+  size_t n = ConvolutionLength<T>(na + nb - 1);
 
   size_t nbytes = 16 * (n * sizeof(T) + 15) / 16;
 
@@ -1753,6 +2130,50 @@ bool mifft(const msignal1D<std::complex<T>>& a, const size_t& n, msignal1D<T>& c
   return retval;
 }
 
+template <typename T>
+bool fft_plan(
+  const size_t* lengths, const size_t nLengths, const FFTPlanRigor rigor, const double seconds)
+{
+  unsigned flags = FFTW_MEASURE;
+  if (rigor == FFTPlanRigor::Patient)
+  {
+    flags = FFTW_PATIENT;
+  }
+  else if (rigor == FFTPlanRigor::Exhaustive)
+  {
+    flags = FFTW_EXHAUSTIVE;
+  }
+
+  Signal1DPlan<T>& p = Signal1DPlan<T>::Instance();
+  bool retval = true;
+  for (size_t i = 0; i < nLengths; i++)
+  {
+    retval = p.Plan(lengths[i], flags, seconds) && retval;
+  }
+  return retval;
+}
+
+template <typename T>
+void fft_convolution_lengths(const size_t* minimums, const size_t nMinimums, size_t* lengths)
+{
+  for (size_t i = 0; i < nMinimums; i++)
+  {
+    lengths[i] = ConvolutionLength<T>(minimums[i]);
+  }
+}
+
+template <typename T>
+bool fft_wisdom_export(const char* filename)
+{
+  return Signal1DPlan<T>::WisdomExport(filename);
+}
+
+template <typename T>
+bool fft_wisdom_import(const char* filename)
+{
+  return Signal1DPlan<T>::WisdomImport(filename);
+}
+
 // These are explicit specializations (not primary templates), instantiation has no effect
 // template void SPS_EXPORT DivideArray<float>(float *Data, size_t NumEl, float Divisor);
 // template void SPS_EXPORT DivideArray<double>(double *Data, size_t NumEl, double Divisor);
@@ -1852,6 +2273,19 @@ template bool SPS_EXPORT mifft<float>(
 template bool SPS_EXPORT mifft<double>(
   const msignal1D<std::complex<double>>& a, const size_t& n, msignal1D<double>& c);
 
+template bool SPS_EXPORT fft_plan<float>(
+  const size_t* lengths, size_t nLengths, FFTPlanRigor rigor, double seconds);
+template bool SPS_EXPORT fft_plan<double>(
+  const size_t* lengths, size_t nLengths, FFTPlanRigor rigor, double seconds);
+template void SPS_EXPORT fft_convolution_lengths<float>(
+  const size_t* minimums, size_t nMinimums, size_t* lengths);
+template void SPS_EXPORT fft_convolution_lengths<double>(
+  const size_t* minimums, size_t nMinimums, size_t* lengths);
+template bool SPS_EXPORT fft_wisdom_export<float>(const char* filename);
+template bool SPS_EXPORT fft_wisdom_export<double>(const char* filename);
+template bool SPS_EXPORT fft_wisdom_import<float>(const char* filename);
+template bool SPS_EXPORT fft_wisdom_import<double>(const char* filename);
+
 }
 
 // std::complex<float> and std::complex<double> are already explicit specializations
@@ -241,6 +241,69 @@ bool SPS_EXPORT fft(const sps::signal1D<T>& a, const size_t& n, sps::signal1D<st
 template <typename T>
 bool SPS_EXPORT ifft(const sps::signal1D<std::complex<T>>& a, const size_t& n, sps::signal1D<T>& c);
 
+/// Rigor of planning ahead of time, see FFTW_MEASURE, FFTW_PATIENT and FFTW_EXHAUSTIVE
+enum class FFTPlanRigor
+{
+  Measure,
+  Patient,
+  Exhaustive,
+};
+
+/**
+ * Plan forward and backward transforms of the given lengths ahead of
+ * time. The plans are remembered as FFTW wisdom, which transforms and
+ * convolutions use instead of estimated plans. Planning may take long,
+ * call it when building a wisdom file, see @ref fft_wisdom_export.
+ *
+ * @param lengths Transform lengths, for convolutions the lengths
+ *                chosen by @ref fft_convolution_lengths
+ * @param nLengths Number of lengths
+ * @param rigor
+ * @param seconds Time limit per plan, negative for no limit
+ *
+ * @return False if a length could not be planned
+ */
+template <typename T>
+bool SPS_EXPORT fft_plan(
+  const size_t* lengths, size_t nLengths, FFTPlanRigor rigor, double seconds = -1.0);
+
+/**
+ * Choose the transform lengths of convolutions ahead of time. The
+ * smooth lengths considered are timed once per required length, on
+ * the first convolution unless chosen here. Import wisdom or call
+ * @ref fft_plan before, since the timing uses the plans available.
+ *
+ * @param minimums Required lengths, n_a + n_b - 1
+ * @param nMinimums Number of required lengths
+ * @param lengths Output, transform lengths chosen, which may be
+ *                passed to @ref fft_plan
+ */
+template <typename T>
+void SPS_EXPORT fft_convolution_lengths(const size_t* minimums, size_t nMinimums, size_t* lengths);
+
+/**
+ * Write the wisdom of this process to a file. Float and double
+ * precision have separate wisdom.
+ *
+ * @param filename
+ *
+ * @return False if the file could not be written
+ */
+template <typename T>
+bool SPS_EXPORT fft_wisdom_export(const char* filename);
+
+/**
+ * Read wisdom from a file written by @ref fft_wisdom_export. Import
+ * at startup, before the first transform, since plans are created
+ * once and kept.
+ *
+ * @param filename
+ *
+ * @return False if the file could not be read
+ */
+template <typename T>
+bool SPS_EXPORT fft_wisdom_import(const char* filename);
+
 #if defined(__GNUG__) || (defined(_MSC_VER) && (_MSC_VER >= 1800))
 
 template <typename T>
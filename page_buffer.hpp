@@ -0,0 +1,218 @@
+/**
+ * @file   page_buffer.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sat Oct 17 23:31:12 2026
+ *
+ * @brief  Page-aligned memory, optionally backed by huge pages
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#pragma once
+
+#include <sps/cenv.h>
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace sps
+{
+
+//! Huge page backing of a @ref PageBuffer
+enum class HugePages
+{
+  None,        ///< Regular pages
+  Transparent, ///< Advise transparent huge pages (Linux madvise)
+  Explicit,    ///< Reserved huge pages (Linux MAP_HUGETLB), falls back to Transparent
+};
+
+//! Page buffer
+/*!
+  Move-only owner of page-aligned memory mapped directly from the
+  operating system. Large buffers, e.g. capture rings, backed by huge
+  pages need fewer TLB entries. The size is rounded up to a multiple
+  of the page size (or huge page size). Memory is zero-initialized.
+*/
+class PageBuffer
+{
+public:
+  /// Size of a huge page assumed for rounding
+  static constexpr std::size_t HugePageSize = std::size_t(2) << 20;
+
+  PageBuffer() = default;
+
+  /**
+   * Map memory
+   *
+   * @param nBytes Minimum size
+   * @param huge Huge page backing
+   *
+   * @throws std::bad_alloc if the memory cannot be mapped
+   */
+  explicit PageBuffer(const std::size_t nBytes, const HugePages huge = HugePages::None)
+  {
+    allocate(nBytes, huge);
+  }
+
+  PageBuffer(PageBuffer&& other) noexcept
+    : m_pData{ std::exchange(other.m_pData, nullptr) }
+    , m_nBytes{ std::exchange(other.m_nBytes, 0) }
+    , m_huge{ std::exchange(other.m_huge, HugePages::None) }
+  {
+  }
+
+  PageBuffer& operator=(PageBuffer&& other) noexcept
+  {
+    if (this != &other)
+    {
+      release();
+      m_pData = std::exchange(other.m_pData, nullptr);
+      m_nBytes = std::exchange(other.m_nBytes, 0);
+      m_huge = std::exchange(other.m_huge, HugePages::None);
+    }
+    return *this;
+  }
+
+  ~PageBuffer() { release(); }
+
+  void* data() const { return m_pData; }
+
+  /**
+   * Size mapped, at least the size requested
+   *
+   * @return
+   */
+  std::size_t size() const { return m_nBytes; }
+
+  /**
+   * Huge page backing obtained, which may be less than requested
+   *
+   * @return
+   */
+  HugePages hugePages() const { return m_huge; }
+
+  /**
+   * Size of a regular page
+   *
+   * @return
+   */
+  static std::size_t PageSize()
+  {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return static_cast<std::size_t>(info.dwPageSize);
+#elif defined(__unix__) || defined(__APPLE__)
+    return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 4096;
+#endif
+  }
+
+private:
+  PageBuffer(const PageBuffer& rhs) = delete;
+  PageBuffer& operator=(const PageBuffer& rhs) = delete;
+
+  static std::size_t RoundUp(const std::size_t n, const std::size_t multiple)
+  {
+    return (n + multiple - 1) / multiple * multiple;
+  }
+
+  void allocate(const std::size_t nBytes, const HugePages huge)
+  {
+    if (nBytes == 0)
+    {
+      return;
+    }
+#if defined(_WIN32)
+    // Large pages require SeLockMemoryPrivilege, regular pages are used
+    m_nBytes = RoundUp(nBytes, PageSize());
+    m_pData = VirtualAlloc(nullptr, m_nBytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!m_pData)
+    {
+      m_nBytes = 0;
+      throw std::bad_alloc();
+    }
+#elif defined(__unix__) || defined(__APPLE__)
+#if defined(MAP_HUGETLB)
+    if (huge == HugePages::Explicit)
+    {
+      m_nBytes = RoundUp(nBytes, HugePageSize);
+      void* pData = mmap(nullptr, m_nBytes, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (pData != MAP_FAILED)
+      {
+        m_pData = pData;
+        m_huge = HugePages::Explicit;
+        return;
+      }
+    }
+#endif
+    const bool advise = huge != HugePages::None;
+    m_nBytes = RoundUp(nBytes, advise ? HugePageSize : PageSize());
+    void* pData =
+      mmap(nullptr, m_nBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pData == MAP_FAILED)
+    {
+      m_nBytes = 0;
+      throw std::bad_alloc();
+    }
+    m_pData = pData;
+#if defined(MADV_HUGEPAGE)
+    if (advise && madvise(m_pData, m_nBytes, MADV_HUGEPAGE) == 0)
+    {
+      m_huge = HugePages::Transparent;
+    }
+#endif
+#else
+    SPS_UNREFERENCED_PARAMETER(huge);
+    m_nBytes = RoundUp(nBytes, PageSize());
+    m_pData = ::operator new(m_nBytes, std::align_val_t(PageSize()));
+    std::memset(m_pData, 0, m_nBytes);
+#endif
+  }
+
+  void release()
+  {
+    if (!m_pData)
+    {
+      return;
+    }
+#if defined(_WIN32)
+    VirtualFree(m_pData, 0, MEM_RELEASE);
+#elif defined(__unix__) || defined(__APPLE__)
+    munmap(m_pData, m_nBytes);
+#else
+    ::operator delete(m_pData, std::align_val_t(PageSize()));
+#endif
+    m_pData = nullptr;
+    m_nBytes = 0;
+  }
+
+  void* m_pData{ nullptr };            ///< Memory mapped
+  std::size_t m_nBytes{ 0 };           ///< Size mapped
+  HugePages m_huge{ HugePages::None }; ///< Huge page backing obtained
+};
+
+} // namespace sps
+
+/* Local variables: */
+/* indent-tabs-mode: nil */
+/* tab-width: 2 */
+/* c-basic-offset: 2 */
+/* End: */
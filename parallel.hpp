@@ -0,0 +1,380 @@
+/**
+ * @file   parallel.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sat Oct 17 16:12:40 2026
+ *
+ * @brief  Range-based parallel algorithms on top of sps::ThreadPool
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#pragma once
+
+#include <sps/cenv.h>
+#include <sps/threadpool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sps
+{
+namespace detail
+{
+
+//! Shared state of a parallel loop
+/*!
+  The range [begin, end) is consumed by the calling thread and a
+  number of helper tasks using guided self-scheduling. Every claim
+  takes max(grain, remaining / (2 * participants)) elements, such that
+  chunks shrink as the range drains and participants arriving late
+  still balance the load.
+
+  The calling thread always takes part, so a loop completes even if
+  all workers are busy (or if called from a worker of a one-thread
+  pool). Helpers starting after the range is exhausted return
+  immediately, so the caller only waits for chunks being processed.
+*/
+template <typename Index>
+class ParallelRange
+{
+public:
+  ParallelRange(Index begin, Index end, Index grain, std::size_t nParticipants)
+    : m_next{ begin }
+    , m_end{ end }
+    , m_grain{ std::max<Index>(grain, Index(1)) }
+    , m_nParticipants{ static_cast<Index>(nParticipants) }
+    , m_nTotal{ end - begin }
+    , m_nDone{ 0 }
+    , m_stop{ false }
+  {
+  }
+
+  /**
+   * Claim the next chunk of the range
+   *
+   * @param first
+   * @param last
+   *
+   * @return False if range is exhausted
+   */
+  bool claim(Index& first, Index& last)
+  {
+    Index current = m_next.load(std::memory_order_relaxed);
+    while (current < m_end)
+    {
+      const Index remaining = m_end - current;
+      const Index size =
+        std::min(remaining, std::max(m_grain, Index(remaining / (2 * m_nParticipants))));
+      if (m_next.compare_exchange_weak(current, current + size, std::memory_order_relaxed))
+      {
+        first = current;
+        last = current + size;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Record the first exception. Remaining chunks are claimed but not
+   * processed.
+   *
+   * @param exception
+   */
+  void fail(std::exception_ptr exception)
+  {
+    std::lock_guard<std::mutex> guard{ m_mutex };
+    if (!m_exception)
+    {
+      m_exception = exception;
+    }
+    m_stop = true;
+  }
+
+  bool stopped() const { return m_stop.load(std::memory_order_relaxed); }
+
+  /**
+   * Report elements processed by a participant. The range must not
+   * be touched afterwards by the participant, unless more chunks were
+   * claimed.
+   *
+   * @param count Number of elements
+   * @param merge Called under lock before counting, e.g. to merge
+   *        partial results
+   */
+  template <typename Merge>
+  void done(Index count, Merge&& merge)
+  {
+    std::lock_guard<std::mutex> guard{ m_mutex };
+    merge();
+    m_nDone += count;
+    if (m_nDone == m_nTotal)
+    {
+      m_condition.notify_all();
+    }
+  }
+
+  /**
+   * Wait until all elements are processed. The first exception
+   * thrown by a participant is rethrown.
+   *
+   */
+  void wait()
+  {
+    std::unique_lock<std::mutex> lock{ m_mutex };
+    m_condition.wait(lock, [this]() { return m_nDone == m_nTotal; });
+    if (m_exception)
+    {
+      std::rethrow_exception(m_exception);
+    }
+  }
+
+private:
+  std::atomic<Index> m_next;           ///< First unclaimed element
+  const Index m_end;                   ///< End of range
+  const Index m_grain;                 ///< Minimum chunk size
+  const Index m_nParticipants;         ///< Participants (helpers and caller)
+  const Index m_nTotal;                ///< Number of elements
+  Index m_nDone;                       ///< Number of elements processed
+  std::atomic<bool> m_stop;            ///< Exception thrown, skip remaining
+  std::exception_ptr m_exception;      ///< First exception thrown
+  std::mutex m_mutex;                  ///< Mutex for locking
+  std::condition_variable m_condition; ///< Condition for signal done
+};
+
+/**
+ * Run a participant on the calling thread and on helper tasks of the
+ * pool and wait for the range to complete.
+ *
+ * A participant is called as participant(range) and must claim
+ * chunks until exhausted and then report using range.done(). The
+ * participant is copied to the helpers, so it should only refer to
+ * state on the stack of the caller, which it may touch only after a
+ * successful claim.
+ *
+ * @param pool
+ * @param begin
+ * @param end
+ * @param grain Minimum number of elements per chunk
+ * @param participant
+ */
+template <typename Index, typename Participant>
+void ParallelRun(ThreadPool& pool, Index begin, Index end, Index grain, Participant participant)
+{
+  static_assert(std::is_integral<Index>::value, "Index must be an integral type");
+  if (!(begin < end))
+  {
+    return;
+  }
+  grain = std::max<Index>(grain, Index(1));
+  const std::size_t nChunks = static_cast<std::size_t>((end - begin + grain - 1) / grain);
+  const std::size_t nParticipants = std::min<std::size_t>(pool.size() + 1, nChunks);
+
+  auto pRange = std::make_shared<ParallelRange<Index>>(begin, end, grain, nParticipants);
+  for (std::size_t i = 1; i < nParticipants; ++i)
+  {
+    pool.post([pRange, participant]() -> void { participant(*pRange); });
+  }
+  participant(*pRange);
+  pRange->wait();
+}
+
+} // namespace detail
+
+/**
+ * Call func(i) for every i in [begin, end) using the pool and the
+ * calling thread.
+ *
+ * @param pool
+ * @param begin
+ * @param end
+ * @param grain Minimum number of indices processed per task
+ * @param func
+ */
+template <typename Index, typename Func>
+void parallel_for(ThreadPool& pool, Index begin, Index end, Index grain, Func&& func)
+{
+  auto* pFunc = &func;
+  detail::ParallelRun(pool, begin, end, grain,
+    [pFunc](detail::ParallelRange<Index>& range) -> void
+    {
+      Index first = 0;
+      Index last = 0;
+      if (!range.claim(first, last))
+      {
+        return;
+      }
+      // The caller waits for the claimed chunk, so its stack is valid
+      Index count = 0;
+      do
+      {
+        count += last - first;
+        if (range.stopped())
+        {
+          continue;
+        }
+        try
+        {
+          for (Index i = first; i < last; ++i)
+          {
+            (*pFunc)(i);
+          }
+        }
+        catch (...)
+        {
+          range.fail(std::current_exception());
+        }
+      } while (range.claim(first, last));
+      range.done(count, []() -> void {});
+    });
+}
+
+/**
+ * Reduce the range [begin, end) using the pool and the calling thread.
+ *
+ * Every participant accumulates a partial result, starting from
+ * identity, by calling partial = func(first, last, partial) for the
+ * chunks it claims. Partial results are combined using
+ * reduce(result, partial), so reduce must be associative and
+ * commutative. Floating-point results may vary between calls.
+ *
+ * @param pool
+ * @param begin
+ * @param end
+ * @param grain Minimum number of indices processed per chunk
+ * @param identity Identity of reduce
+ * @param func Chunk accumulation, T func(Index first, Index last, T init)
+ * @param reduce Reduction, T reduce(T a, T b)
+ *
+ * @return
+ */
+template <typename Index, typename T, typename Func, typename Reduce>
+T parallel_reduce(
+  ThreadPool& pool, Index begin, Index end, Index grain, T identity, Func&& func, Reduce&& reduce)
+{
+  struct Partials
+  {
+    const T& identity;
+    Func& func;
+    Reduce& reduce;
+    T result;
+  } partials{ identity, func, reduce, identity };
+
+  auto* pPartials = &partials;
+  detail::ParallelRun(pool, begin, end, grain,
+    [pPartials](detail::ParallelRange<Index>& range) -> void
+    {
+      Index first = 0;
+      Index last = 0;
+      if (!range.claim(first, last))
+      {
+        return;
+      }
+      // The caller waits for the claimed chunk, so its stack is valid
+      Index count = 0;
+      T partial = pPartials->identity;
+      do
+      {
+        count += last - first;
+        if (range.stopped())
+        {
+          continue;
+        }
+        try
+        {
+          partial = pPartials->func(first, last, std::move(partial));
+        }
+        catch (...)
+        {
+          range.fail(std::current_exception());
+        }
+      } while (range.claim(first, last));
+      range.done(count,
+        [pPartials, &partial]() -> void
+        {
+          pPartials->result = pPartials->reduce(std::move(pPartials->result), std::move(partial));
+        });
+    });
+  return partials.result;
+}
+
+/**
+ * Inclusive prefix scan of [first, last) into dFirst using the pool
+ * and the calling thread, i.e. dFirst[i] = op(dFirst[i - 1],
+ * first[i]). The range is split into blocks, which are reduced in
+ * parallel, the block sums are scanned serially and finally the
+ * blocks are scanned in parallel. Requires random-access iterators
+ * and an associative op.
+ *
+ * @param pool
+ * @param first
+ * @param last
+ * @param dFirst Output, may be equal to first
+ * @param grain Minimum number of elements per block
+ * @param identity Identity of op
+ * @param op Binary operation, T op(T a, T b)
+ */
+template <typename InputIt, typename OutputIt, typename T, typename BinaryOp>
+void parallel_scan(ThreadPool& pool, InputIt first, InputIt last, OutputIt dFirst,
+  std::size_t grain, T identity, BinaryOp op)
+{
+  const std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+  if (n == 0)
+  {
+    return;
+  }
+  grain = std::max<std::size_t>(grain, 1);
+  const std::size_t nBlocks = std::max<std::size_t>(
+    1, std::min<std::size_t>(n / grain, 4 * (pool.size() + 1)));
+  const std::size_t blockSize = (n + nBlocks - 1) / nBlocks;
+
+  // Offset of every block, the last block sum is not needed
+  std::vector<T> offsets(nBlocks, identity);
+  parallel_for(pool, std::size_t(0), nBlocks - 1, std::size_t(1),
+    [&](std::size_t iBlock) -> void
+    {
+      const std::size_t iFirst = iBlock * blockSize;
+      const std::size_t iLast = std::min(n, iFirst + blockSize);
+      T sum = identity;
+      for (std::size_t i = iFirst; i < iLast; ++i)
+      {
+        sum = op(sum, first[i]);
+      }
+      offsets[iBlock + 1] = sum;
+    });
+
+  for (std::size_t iBlock = 1; iBlock < nBlocks; ++iBlock)
+  {
+    offsets[iBlock] = op(offsets[iBlock - 1], offsets[iBlock]);
+  }
+
+  parallel_for(pool, std::size_t(0), nBlocks, std::size_t(1),
+    [&](std::size_t iBlock) -> void
+    {
+      const std::size_t iFirst = iBlock * blockSize;
+      const std::size_t iLast = std::min(n, iFirst + blockSize);
+      T sum = offsets[iBlock];
+      for (std::size_t i = iFirst; i < iLast; ++i)
+      {
+        sum = op(sum, first[i]);
+        dFirst[i] = sum;
+      }
+    });
+}
+
+} // namespace sps
+
+/* Local variables: */
+/* indent-tabs-mode: nil */
+/* tab-width: 2 */
+/* c-basic-offset: 2 */
+/* End: */
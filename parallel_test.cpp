@@ -0,0 +1,118 @@
+/**
+ * @file   parallel_test.cpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sat Oct 17 17:05:31 2026
+ *
+ * @brief  Tests of parallel_for, parallel_reduce and parallel_scan
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#include <gtest/gtest.h>
+#include <sps/cenv.h>
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <sps/parallel.hpp>
+#include <sps/threadpool.hpp>
+
+TEST(parallel_test, parallel_for)
+{
+  sps::ThreadPool pool(4);
+  std::vector<int> values(10000, 0);
+  sps::parallel_for(pool, size_t(0), values.size(), size_t(16),
+    [&](size_t i) -> void { values[i] = static_cast<int>(2 * i); });
+
+  for (size_t i = 0; i < values.size(); i++)
+  {
+    EXPECT_EQ(values[i], static_cast<int>(2 * i));
+  }
+
+  // Empty and signed ranges
+  std::atomic<int> nCalls{ 0 };
+  sps::parallel_for(pool, 5, 5, 1, [&](int) -> void { nCalls++; });
+  EXPECT_EQ(nCalls.load(), 0);
+  sps::parallel_for(pool, -50, 50, 0, [&](int) -> void { nCalls++; });
+  EXPECT_EQ(nCalls.load(), 100);
+}
+
+/**
+ * Test that nested loops complete on a one-thread pool. The calling
+ * worker processes the inner loop itself.
+ *
+ */
+TEST(parallel_test, parallel_for_nested)
+{
+  sps::ThreadPool pool(1);
+  std::atomic<int> nCalls{ 0 };
+
+  auto future = pool.submit(
+    [&]() -> void
+    {
+      sps::parallel_for(pool, 0, 100, 1,
+        [&](int) -> void { sps::parallel_for(pool, 0, 10, 1, [&](int) -> void { nCalls++; }); });
+    });
+  future.Get();
+  EXPECT_EQ(nCalls.load(), 1000);
+}
+
+TEST(parallel_test, parallel_for_exception)
+{
+  sps::ThreadPool pool(2);
+  EXPECT_THROW(sps::parallel_for(pool, 0, 1000, 10,
+                 [](int i) -> void
+                 {
+                   if (i == 500)
+                   {
+                     throw std::runtime_error("failure");
+                   }
+                 }),
+    std::runtime_error);
+}
+
+TEST(parallel_test, parallel_reduce)
+{
+  sps::ThreadPool pool(3);
+  const long n = 100000;
+  const long sum = sps::parallel_reduce(
+    pool, 0L, n, 64L, 0L,
+    [](long first, long last, long init) -> long
+    {
+      for (long i = first; i < last; i++)
+      {
+        init += i;
+      }
+      return init;
+    },
+    [](long a, long b) -> long { return a + b; });
+  EXPECT_EQ(sum, n * (n - 1) / 2);
+}
+
+TEST(parallel_test, parallel_scan)
+{
+  sps::ThreadPool pool(3);
+  std::vector<int> input(12345);
+  std::iota(input.begin(), input.end(), 1);
+
+  std::vector<int> expected(input.size());
+  std::partial_sum(input.begin(), input.end(), expected.begin());
+
+  std::vector<int> output(input.size(), 0);
+  sps::parallel_scan(pool, input.begin(), input.end(), output.begin(), 100, 0,
+    [](int a, int b) -> int { return a + b; });
+  EXPECT_EQ(output, expected);
+
+  // In-place
+  sps::parallel_scan(pool, input.begin(), input.end(), input.begin(), 1, 0,
+    [](int a, int b) -> int { return a + b; });
+  EXPECT_EQ(input, expected);
+}
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
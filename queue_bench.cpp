@@ -0,0 +1,646 @@
+/**
+ * @file   queue_bench.cpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sun Oct 18 03:41:09 2026
+ *
+ * @brief  Throughput and latency of the queues and ring buffers
+ *
+ * Sweeps producer and consumer counts, element sizes, batch sizes and
+ * pinning for each primitive and reports one row per run as CSV
+ * (default) or JSON.
+ *
+ * Usage: queue_bench [--json] [--messages=N] [--filter=NAME] [--no-pin]
+ *
+ * Latencies are measured under saturation, from the time a batch is
+ * offered by a producer until a consumer has popped it, so they
+ * include queueing delay.
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#include <sps/bip_buffer.hpp>
+#include <sps/mimo.hpp>
+#include <sps/queue.hpp>
+#include <sps/siso.hpp>
+#include <sps/sps_threads.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Kaspar Daugaard's ring buffer, a header without include guard
+#include <sps/RingBuffer_v1.hpp>
+
+#if defined(SPS_BENCH_MRBUFFER)
+extern "C"
+{
+#include <sps/mrbuffer.h>
+}
+#endif
+
+namespace
+{
+
+/// Capacity in elements used by all primitives
+constexpr size_t Capacity = 1024;
+
+/// Value marking the end of a run for queues, which only pop blocking
+constexpr std::int64_t Sentinel = -1;
+
+//! Element of Bytes bytes, the first word holds the time it was offered
+template <size_t Bytes>
+struct Message
+{
+  static_assert(Bytes >= sizeof(std::int64_t) && Bytes % sizeof(std::int64_t) == 0,
+    "Size must be a multiple of 8 bytes");
+  std::int64_t words[Bytes / sizeof(std::int64_t)];
+};
+
+std::int64_t NowGet()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+/*
+  Adapters give all primitives the same non-blocking interface:
+
+  size_t push(const T* items, size_t n) // Elements pushed
+  size_t pop(T* items, size_t max)      // Elements popped
+  void release(size_t nConsumers)       // Wake consumers blocked in pop
+
+  MultiProducer / MultiConsumer tell whether more threads may use a
+  side. RingBuffer_v1 requires pop to be called with the batch size
+  pushed, which the harness does.
+*/
+
+template <typename T>
+struct SRSWRingBufferAdapter
+{
+  static constexpr const char* Name = "SRSWRingBuffer";
+  static constexpr bool MultiProducer = false;
+  static constexpr bool MultiConsumer = false;
+
+  size_t push(T* items, size_t n) { return m_ring.try_push_n(items, n); }
+  size_t pop(T* items, size_t max) { return m_ring.try_pop_n(items, max); }
+  void release(size_t) {}
+
+  sps::SRSWRingBuffer<T, Capacity> m_ring;
+};
+
+template <typename T>
+struct MRMWQueueAdapter
+{
+  static constexpr const char* Name = "MRMWQueue";
+  static constexpr bool MultiProducer = true;
+  static constexpr bool MultiConsumer = true;
+
+  size_t push(T* items, size_t n)
+  {
+    m_queue.push_bulk(items, items + n);
+    return n;
+  }
+  size_t pop(T* items, size_t max) { return m_queue.try_pop_bulk(items, max); }
+  void release(size_t) {}
+
+  sps::MRMWQueue<T> m_queue;
+};
+
+template <typename T>
+struct MRMWCircularBufferAdapter
+{
+  static constexpr const char* Name = "MRMWCircularBuffer";
+  static constexpr bool MultiProducer = true;
+  static constexpr bool MultiConsumer = true;
+
+  size_t push(T* items, size_t n)
+  {
+    // Blocks while full
+    m_buffer.push_bulk(items, items + n);
+    return n;
+  }
+  size_t pop(T* items, size_t max) { return m_buffer.try_pop_bulk(items, max); }
+  void release(size_t) {}
+
+  sps::MRMWCircularBuffer<T, Capacity> m_buffer;
+};
+
+template <typename T>
+struct QueueAdapter
+{
+  static constexpr const char* Name = "queue";
+  static constexpr bool MultiProducer = true;
+  static constexpr bool MultiConsumer = true;
+
+  size_t push(T* items, size_t n)
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      m_queue.push(items[i]);
+    }
+    return n;
+  }
+
+  // Only blocking pop is available, the run ends with a sentinel
+  size_t pop(T* items, size_t)
+  {
+    m_queue.pop(items[0]);
+    return items[0].words[0] == Sentinel ? 0 : 1;
+  }
+
+  void release(size_t nConsumers)
+  {
+    T sentinel{};
+    sentinel.words[0] = Sentinel;
+    for (size_t i = 0; i < nConsumers; i++)
+    {
+      m_queue.push(sentinel);
+    }
+  }
+
+  sps::queue<T> m_queue;
+};
+
+template <typename T>
+struct BipBufferAdapter
+{
+  static constexpr const char* Name = "BipBuffer";
+  static constexpr bool MultiProducer = false;
+  static constexpr bool MultiConsumer = false;
+
+  size_t push(T* items, size_t n)
+  {
+    T* pRecord = m_buffer.reserve(n);
+    if (!pRecord)
+    {
+      return 0;
+    }
+    std::copy(items, items + n, pRecord);
+    m_buffer.commit(n);
+    return n;
+  }
+
+  size_t pop(T* items, size_t max)
+  {
+    const auto block = m_buffer.peek();
+    const size_t n = std::min(block.size, max);
+    std::copy(block.data, block.data + n, items);
+    m_buffer.consume(n);
+    return n;
+  }
+
+  void release(size_t) {}
+
+  sps::BipBuffer<T> m_buffer{ Capacity };
+};
+
+template <typename T>
+struct RingBufferV1Adapter
+{
+  static constexpr const char* Name = "RingBuffer_v1";
+  static constexpr bool MultiProducer = false;
+  static constexpr bool MultiConsumer = false;
+
+  RingBufferV1Adapter()
+    : m_nBytes{ 1 }
+  {
+    while (m_nBytes < Capacity * sizeof(T))
+    {
+      m_nBytes <<= 1;
+    }
+    m_pStorage = static_cast<char*>(::operator new(m_nBytes, std::align_val_t(64)));
+    m_ring.Initialize(m_pStorage, m_nBytes);
+  }
+
+  ~RingBufferV1Adapter() { ::operator delete(m_pStorage, std::align_val_t(64)); }
+
+  // Spins until there is room
+  size_t push(T* items, size_t n)
+  {
+    m_ring.WriteArray(items, n);
+    m_ring.FinishWrite();
+    return n;
+  }
+
+  // Spins until max elements are available, as written
+  size_t pop(T* items, size_t max)
+  {
+    const T* pElements = m_ring.ReadArray<T>(max);
+    std::copy(pElements, pElements + max, items);
+    m_ring.FinishRead();
+    return max;
+  }
+
+  void release(size_t) {}
+
+  size_t m_nBytes;
+  char* m_pStorage;
+  RingBuffer m_ring;
+};
+
+//! Parameters of a run
+struct Config
+{
+  size_t nProducers;
+  size_t nConsumers;
+  size_t nBytes;
+  size_t nBatch;
+  bool pinned;
+  size_t nMessages;
+};
+
+//! Measurements of a run
+struct Row
+{
+  const char* name;
+  Config config;
+  double seconds;
+  double percentiles[4]; ///< p50, p90, p99, p99.9 in ns
+  double maximum;        ///< Maximum latency in ns
+};
+
+const double Quantiles[4] = { 0.5, 0.9, 0.99, 0.999 };
+
+void Pin(const std::vector<int>& cpus, const size_t iThread)
+{
+  if (!cpus.empty())
+  {
+    setcpuid(cpus[iThread % cpus.size()]);
+  }
+}
+
+/**
+ * Stream config.nMessages elements from the producers to the consumers
+ *
+ * @param config
+ * @param cpus CPUs threads are pinned to, empty if not pinned
+ *
+ * @return
+ */
+template <template <typename> class Adapter, size_t Bytes>
+Row Run(const Config& config, const std::vector<int>& cpus)
+{
+  using T = Message<Bytes>;
+  auto pQueue = std::make_unique<Adapter<T>>();
+  const size_t nPerProducer = config.nMessages / config.nProducers;
+  const size_t nTotal = nPerProducer * config.nProducers;
+
+  std::atomic<bool> started{ false };
+  std::atomic<size_t> nConsumed{ 0 };
+  std::atomic<std::int64_t> end{ 0 };
+  std::vector<std::vector<std::int64_t>> latencies(config.nConsumers);
+  std::vector<std::thread> threads;
+
+  for (size_t p = 0; p < config.nProducers; p++)
+  {
+    threads.emplace_back(
+      [&, p]()
+      {
+        Pin(cpus, p);
+        std::vector<T> batch(config.nBatch);
+        while (!started.load(std::memory_order_acquire))
+        {
+          std::this_thread::yield();
+        }
+        for (size_t nSent = 0; nSent < nPerProducer;)
+        {
+          const size_t n = std::min(config.nBatch, nPerProducer - nSent);
+          const std::int64_t now = NowGet();
+          for (size_t i = 0; i < n; i++)
+          {
+            batch[i].words[0] = now;
+          }
+          for (size_t nPushed = 0; nPushed < n;)
+          {
+            const size_t nPart = pQueue->push(batch.data() + nPushed, n - nPushed);
+            if (nPart == 0)
+            {
+              std::this_thread::yield();
+            }
+            nPushed += nPart;
+          }
+          nSent += n;
+        }
+      });
+  }
+  for (size_t c = 0; c < config.nConsumers; c++)
+  {
+    threads.emplace_back(
+      [&, c]()
+      {
+        Pin(cpus, config.nProducers + c);
+        std::vector<T> batch(config.nBatch);
+        std::vector<std::int64_t>& samples = latencies[c];
+        samples.reserve(nTotal / config.nConsumers + config.nBatch);
+        while (nConsumed.load(std::memory_order_relaxed) < nTotal)
+        {
+          const size_t n = pQueue->pop(batch.data(), config.nBatch);
+          if (n == 0)
+          {
+            std::this_thread::yield();
+            continue;
+          }
+          const std::int64_t now = NowGet();
+          for (size_t i = 0; i < n; i++)
+          {
+            samples.push_back(now - batch[i].words[0]);
+          }
+          if (nConsumed.fetch_add(n) + n == nTotal)
+          {
+            end.store(now);
+          }
+        }
+      });
+  }
+
+  const std::int64_t start = NowGet();
+  started.store(true, std::memory_order_release);
+  while (nConsumed.load() < nTotal)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  pQueue->release(config.nConsumers);
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  std::vector<std::int64_t> all;
+  all.reserve(nTotal);
+  for (const auto& samples : latencies)
+  {
+    all.insert(all.end(), samples.begin(), samples.end());
+  }
+  std::sort(all.begin(), all.end());
+
+  Row row{ Adapter<T>::Name, config, 1e-9 * static_cast<double>(end.load() - start), {}, 0.0 };
+  row.config.nMessages = nTotal;
+  for (size_t i = 0; i < 4; i++)
+  {
+    const size_t index = std::min(all.size() - 1, static_cast<size_t>(Quantiles[i] * all.size()));
+    row.percentiles[i] = static_cast<double>(all[index]);
+  }
+  row.maximum = static_cast<double>(all.back());
+  return row;
+}
+
+#if defined(SPS_BENCH_MRBUFFER)
+/**
+ * The mrbuffer C ring is not thread-safe. Elements are written and
+ * read in batches by the calling thread, which measures the cost of
+ * the copies through the double mapping.
+ *
+ * @param config
+ * @param pRow Result
+ *
+ * @return False if the ring cannot be allocated
+ */
+template <size_t Bytes>
+bool RunMrbuffer(const Config& config, Row* pRow)
+{
+  using T = Message<Bytes>;
+  size_t order = 0;
+  while ((size_t(4096) << order) < Capacity * sizeof(T))
+  {
+    order++;
+  }
+  struct mrbuffer* pBuffer = mrbuffer_alloc(MRBUF_FLAG_SHMAT, static_cast<unsigned int>(order));
+  if (!pBuffer)
+  {
+    pBuffer = mrbuffer_alloc(MRBUF_FLAG_MMAP, static_cast<unsigned int>(order));
+  }
+  if (!pBuffer)
+  {
+    return false;
+  }
+
+  std::vector<T> in(config.nBatch);
+  std::vector<T> out(config.nBatch);
+  std::vector<std::int64_t> samples;
+  samples.reserve(config.nMessages);
+  const std::int64_t start = NowGet();
+  for (size_t nSent = 0; nSent < config.nMessages; nSent += config.nBatch)
+  {
+    const std::int64_t now = NowGet();
+    for (auto& message : in)
+    {
+      message.words[0] = now;
+    }
+    mrbuffer_write(pBuffer, in.size() * sizeof(T), in.data());
+    mrbuffer_read(pBuffer, out.size() * sizeof(T), out.data());
+    const std::int64_t done = NowGet();
+    for (const auto& message : out)
+    {
+      samples.push_back(done - message.words[0]);
+    }
+  }
+  const std::int64_t end = NowGet();
+  mrbuffer_free(pBuffer);
+
+  std::sort(samples.begin(), samples.end());
+  *pRow = Row{ "mrbuffer", config, 1e-9 * static_cast<double>(end - start), {}, 0.0 };
+  pRow->config.nMessages = samples.size();
+  for (size_t i = 0; i < 4; i++)
+  {
+    const size_t index =
+      std::min(samples.size() - 1, static_cast<size_t>(Quantiles[i] * samples.size()));
+    pRow->percentiles[i] = static_cast<double>(samples[index]);
+  }
+  pRow->maximum = static_cast<double>(samples.back());
+  return true;
+}
+#endif
+
+//! Rows printed as CSV or JSON
+class Report
+{
+public:
+  explicit Report(const bool json)
+    : m_json{ json }
+  {
+    if (m_json)
+    {
+      printf("[\n");
+    }
+    else
+    {
+      printf("primitive,producers,consumers,element_bytes,batch,pinned,messages,seconds,"
+             "msgs_per_s,mb_per_s,p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n");
+    }
+  }
+
+  ~Report()
+  {
+    if (m_json)
+    {
+      printf("\n]\n");
+    }
+  }
+
+  void add(const Row& row)
+  {
+    const Config& c = row.config;
+    const double rate = static_cast<double>(c.nMessages) / row.seconds;
+    const double bandwidth = rate * static_cast<double>(c.nBytes) * 1e-6;
+    if (m_json)
+    {
+      printf("%s  {\"primitive\": \"%s\", \"producers\": %zu, \"consumers\": %zu, "
+             "\"element_bytes\": %zu, \"batch\": %zu, \"pinned\": %s, \"messages\": %zu, "
+             "\"seconds\": %.6f, \"msgs_per_s\": %.0f, \"mb_per_s\": %.1f, \"p50_ns\": %.0f, "
+             "\"p90_ns\": %.0f, \"p99_ns\": %.0f, \"p999_ns\": %.0f, \"max_ns\": %.0f}",
+        m_nRows > 0 ? ",\n" : "", row.name, c.nProducers, c.nConsumers, c.nBytes, c.nBatch,
+        c.pinned ? "true" : "false", c.nMessages, row.seconds, rate, bandwidth,
+        row.percentiles[0], row.percentiles[1], row.percentiles[2], row.percentiles[3],
+        row.maximum);
+    }
+    else
+    {
+      printf("%s,%zu,%zu,%zu,%zu,%d,%zu,%.6f,%.0f,%.1f,%.0f,%.0f,%.0f,%.0f,%.0f\n", row.name,
+        c.nProducers, c.nConsumers, c.nBytes, c.nBatch, c.pinned ? 1 : 0, c.nMessages,
+        row.seconds, rate, bandwidth, row.percentiles[0], row.percentiles[1], row.percentiles[2],
+        row.percentiles[3], row.maximum);
+    }
+    fflush(stdout);
+    m_nRows++;
+  }
+
+private:
+  bool m_json;
+  size_t m_nRows{ 0 };
+};
+
+//! Sweep of a benchmark
+struct Sweep
+{
+  size_t nMessages;
+  std::string filter;
+  std::vector<bool> pinning;
+};
+
+bool Selected(const Sweep& sweep, const char* name)
+{
+  return sweep.filter.empty() || sweep.filter == name;
+}
+
+template <template <typename> class Adapter, size_t Bytes>
+void SweepThreads(Report& report, const Sweep& sweep, const std::vector<int>& cpus)
+{
+  using A = Adapter<Message<Bytes>>;
+  if (!Selected(sweep, A::Name))
+  {
+    return;
+  }
+  // Producers and consumers
+  const size_t threadCounts[][2] = { { 1, 1 }, { 2, 2 }, { 4, 1 }, { 1, 4 } };
+  const size_t batches[] = { 1, 16 };
+  for (const bool pinned : sweep.pinning)
+  {
+    for (const auto& counts : threadCounts)
+    {
+      if ((counts[0] > 1 && !A::MultiProducer) || (counts[1] > 1 && !A::MultiConsumer))
+      {
+        continue;
+      }
+      for (const size_t nBatch : batches)
+      {
+        // Whole batches per producer
+        const size_t nUnit = counts[0] * nBatch;
+        const Config config{ counts[0], counts[1], Bytes, nBatch, pinned,
+          std::max(sweep.nMessages / nUnit, size_t(1)) * nUnit };
+        report.add(Run<Adapter, Bytes>(config, pinned ? cpus : std::vector<int>()));
+      }
+    }
+  }
+}
+
+template <size_t Bytes>
+void SweepElementSize(Report& report, const Sweep& sweep, const std::vector<int>& cpus)
+{
+  SweepThreads<SRSWRingBufferAdapter, Bytes>(report, sweep, cpus);
+  SweepThreads<BipBufferAdapter, Bytes>(report, sweep, cpus);
+  SweepThreads<RingBufferV1Adapter, Bytes>(report, sweep, cpus);
+  SweepThreads<MRMWQueueAdapter, Bytes>(report, sweep, cpus);
+  SweepThreads<MRMWCircularBufferAdapter, Bytes>(report, sweep, cpus);
+  SweepThreads<QueueAdapter, Bytes>(report, sweep, cpus);
+#if defined(SPS_BENCH_MRBUFFER)
+  if (Selected(sweep, "mrbuffer"))
+  {
+    for (const size_t nBatch : { size_t(1), size_t(16) })
+    {
+      Row row;
+      const Config config{ 1, 1, Bytes, nBatch, false,
+        std::max(sweep.nMessages / nBatch, size_t(1)) * nBatch };
+      if (RunMrbuffer<Bytes>(config, &row))
+      {
+        report.add(row);
+      }
+      else
+      {
+        fprintf(stderr, "mrbuffer: allocation failed\n");
+      }
+    }
+  }
+#endif
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  bool json = false;
+  Sweep sweep{ 200000, std::string(), { false, true } };
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--json") == 0)
+    {
+      json = true;
+    }
+    else if (strncmp(argv[i], "--messages=", 11) == 0)
+    {
+      sweep.nMessages = static_cast<size_t>(std::max(atol(argv[i] + 11), 1L));
+    }
+    else if (strncmp(argv[i], "--filter=", 9) == 0)
+    {
+      sweep.filter = argv[i] + 9;
+    }
+    else if (strcmp(argv[i], "--no-pin") == 0)
+    {
+      sweep.pinning = { false };
+    }
+    else
+    {
+      fprintf(stderr, "Usage: %s [--json] [--messages=N] [--filter=NAME] [--no-pin]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Producers and consumers on separate physical cores first
+  const std::vector<int> cpus = sps::AffinityCpusGet(sps::AffinityPolicy::Compact);
+  if (cpus.size() < 2)
+  {
+    sweep.pinning = { false };
+  }
+
+  Report report(json);
+  SweepElementSize<8>(report, sweep, cpus);
+  SweepElementSize<64>(report, sweep, cpus);
+  SweepElementSize<256>(report, sweep, cpus);
+  return EXIT_SUCCESS;
+}
+
+/* Local variables: */
+/* indent-tabs-mode: nil */
+/* tab-width: 2 */
+/* c-basic-offset: 2 */
+/* End: */
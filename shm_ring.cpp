@@ -0,0 +1,311 @@
+/**
+ * @file   shm_ring.cpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sun Oct 18 02:40:15 2026
+ *
+ * @brief  Named shared-memory ring (Linux)
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#include <sps/shm_ring.hpp>
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace sps
+{
+
+namespace
+{
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+  "Atomics in shared memory must be lock-free");
+static_assert(sizeof(detail::ShmRingHeader) <= 4096, "Header must fit in a page");
+
+/// Identifies an initialized ring
+const std::uint64_t Magic = 0x53505352494e4731ULL;
+
+/// Time given a creating process to initialize the ring
+const std::chrono::milliseconds InitTimeout(1000);
+
+[[noreturn]] void ThrowErrno(const char* what)
+{
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+bool ProcessAlive(const std::int32_t pid)
+{
+  return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+long Futex(std::atomic<std::uint32_t>& word, const int op, const std::uint32_t value,
+  const timespec* pTimeout)
+{
+  // Not FUTEX_PRIVATE_FLAG, the word is shared between processes
+  return syscall(
+    SYS_futex, reinterpret_cast<std::uint32_t*>(&word), op, value, pTimeout, nullptr, 0);
+}
+
+/**
+ * Wait until a condition holds, sleeping on the futex of an event
+ *
+ * @param event Event signalled by the other side
+ * @param condition Callable returning true when done
+ * @param timeout
+ *
+ * @return False on timeout
+ */
+template <typename Condition>
+bool Await(detail::ShmEvent& event, Condition&& condition, const std::chrono::milliseconds timeout)
+{
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!condition())
+  {
+    event.nWaiters.fetch_add(1);
+    const std::uint32_t key = event.epoch.load(std::memory_order_acquire);
+    if (condition())
+    {
+      event.nWaiters.fetch_sub(1);
+      return true;
+    }
+    const auto remaining = deadline - std::chrono::steady_clock::now();
+    if (remaining <= std::chrono::steady_clock::duration::zero())
+    {
+      event.nWaiters.fetch_sub(1);
+      return false;
+    }
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+    timespec relative;
+    relative.tv_sec = static_cast<time_t>(seconds.count());
+    relative.tv_nsec =
+      static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - seconds)
+                          .count());
+    Futex(event.epoch, FUTEX_WAIT, key, &relative);
+    event.nWaiters.fetch_sub(1);
+  }
+  return true;
+}
+} // namespace
+
+ShmRing::ShmRing(const std::string& name, const Role role, const size_t size)
+  : m_role{ role }
+  , m_nSize{ 0 }
+  , m_nPageSize{ static_cast<size_t>(sysconf(_SC_PAGESIZE)) }
+  , m_pHeader{ nullptr }
+  , m_pData{ nullptr }
+{
+  const size_t nRounded = (size + m_nPageSize - 1) / m_nPageSize * m_nPageSize;
+  bool created = false;
+  int fd = -1;
+  if (size > 0)
+  {
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    created = fd >= 0;
+    if (!created && errno != EEXIST)
+    {
+      ThrowErrno("shm_open");
+    }
+  }
+  if (!created && (fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0)) < 0)
+  {
+    ThrowErrno("shm_open");
+  }
+
+  try
+  {
+    if (created)
+    {
+      m_nSize = nRounded;
+      if (ftruncate(fd, static_cast<off_t>(m_nPageSize + m_nSize)) != 0)
+      {
+        ThrowErrno("ftruncate");
+      }
+    }
+    else
+    {
+      // The creating process may not have sized the object yet
+      const auto deadline = std::chrono::steady_clock::now() + InitTimeout;
+      struct stat status;
+      while (fstat(fd, &status) == 0 && static_cast<size_t>(status.st_size) <= m_nPageSize &&
+        std::chrono::steady_clock::now() < deadline)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      if (fstat(fd, &status) != 0)
+      {
+        ThrowErrno("fstat");
+      }
+      if (static_cast<size_t>(status.st_size) <= m_nPageSize)
+      {
+        throw std::runtime_error("Shared memory is not a ring");
+      }
+      m_nSize = static_cast<size_t>(status.st_size) - m_nPageSize;
+      if (size > 0 && nRounded != m_nSize)
+      {
+        throw std::invalid_argument("Existing ring has a different size");
+      }
+    }
+    map(fd, m_nSize);
+  }
+  catch (...)
+  {
+    close(fd);
+    if (created)
+    {
+      shm_unlink(name.c_str());
+    }
+    throw;
+  }
+  // The mappings keep the object alive
+  close(fd);
+
+  try
+  {
+    if (created)
+    {
+      ::new (static_cast<void*>(m_pHeader)) detail::ShmRingHeader();
+      m_pHeader->magic = Magic;
+      m_pHeader->size = m_nSize;
+      m_pHeader->ready.store(1, std::memory_order_release);
+    }
+    else
+    {
+      const auto deadline = std::chrono::steady_clock::now() + InitTimeout;
+      while (m_pHeader->ready.load(std::memory_order_acquire) == 0 &&
+        std::chrono::steady_clock::now() < deadline)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      if (m_pHeader->ready.load(std::memory_order_acquire) == 0 || m_pHeader->magic != Magic ||
+        m_pHeader->size != m_nSize)
+      {
+        throw std::runtime_error("Shared memory is not a ring");
+      }
+    }
+    attach();
+  }
+  catch (...)
+  {
+    munmap(m_pHeader, m_nPageSize + 2 * m_nSize);
+    throw;
+  }
+}
+
+ShmRing::~ShmRing()
+{
+  std::atomic<std::int32_t>& owner =
+    m_role == Role::Writer ? m_pHeader->writer : m_pHeader->reader;
+  std::int32_t self = static_cast<std::int32_t>(getpid());
+  owner.compare_exchange_strong(self, 0);
+  munmap(m_pHeader, m_nPageSize + 2 * m_nSize);
+}
+
+bool ShmRing::Unlink(const std::string& name)
+{
+  return shm_unlink(name.c_str()) == 0;
+}
+
+void ShmRing::map(const int fd, const size_t size)
+{
+  // Reserve address space for the header and both views of the data,
+  // then map the object on top of the reservation
+  void* pReserved =
+    mmap(nullptr, m_nPageSize + 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (pReserved == MAP_FAILED)
+  {
+    ThrowErrno("mmap");
+  }
+  unsigned char* pBase = static_cast<unsigned char*>(pReserved);
+  const int flags = MAP_SHARED | MAP_FIXED;
+  bool mapped =
+    mmap(pBase, m_nPageSize, PROT_READ | PROT_WRITE, flags, fd, 0) != MAP_FAILED;
+  for (size_t iView = 0; mapped && iView < 2; iView++)
+  {
+    mapped = mmap(pBase + m_nPageSize + iView * size, size, PROT_READ | PROT_WRITE, flags, fd,
+               static_cast<off_t>(m_nPageSize)) != MAP_FAILED;
+  }
+  if (!mapped)
+  {
+    const int error = errno;
+    munmap(pReserved, m_nPageSize + 2 * size);
+    throw std::system_error(error, std::generic_category(), "mmap");
+  }
+  m_pHeader = reinterpret_cast<detail::ShmRingHeader*>(pBase);
+  m_pData = pBase + m_nPageSize;
+}
+
+void ShmRing::attach()
+{
+  std::atomic<std::int32_t>& owner =
+    m_role == Role::Writer ? m_pHeader->writer : m_pHeader->reader;
+  const std::int32_t self = static_cast<std::int32_t>(getpid());
+  std::int32_t current = 0;
+  while (!owner.compare_exchange_strong(current, self))
+  {
+    if (current == self || ProcessAlive(current))
+    {
+      throw std::runtime_error(
+        m_role == Role::Writer ? "Writer already attached" : "Reader already attached");
+    }
+    // Held by a process, which crashed. Take over
+  }
+  if (current != 0)
+  {
+    // The crashed process may have died waiting. Its registration
+    // would make every notification of the peer a system call
+    detail::ShmEvent& event = m_role == Role::Writer ? m_pHeader->notFull : m_pHeader->notEmpty;
+    event.nWaiters.store(0);
+  }
+}
+
+bool ShmRing::waitReadable(const size_t len, const std::chrono::milliseconds timeout)
+{
+  return Await(m_pHeader->notEmpty, [&]() { return readable() >= len; }, timeout);
+}
+
+bool ShmRing::waitWritable(const size_t len, const std::chrono::milliseconds timeout)
+{
+  if (len > m_nSize)
+  {
+    return false;
+  }
+  return Await(m_pHeader->notFull, [&]() { return writable() >= len; }, timeout);
+}
+
+bool ShmRing::peerAttached() const
+{
+  const std::int32_t pid = (m_role == Role::Writer ? m_pHeader->reader : m_pHeader->writer)
+                             .load(std::memory_order_acquire);
+  return pid != 0 && ProcessAlive(pid);
+}
+
+void ShmRing::Wake(detail::ShmEvent& event)
+{
+  event.epoch.fetch_add(1, std::memory_order_release);
+  Futex(event.epoch, FUTEX_WAKE, INT_MAX, nullptr);
+}
+
+} // namespace sps
+
+#endif
+
+/* Local variables: */
+/* indent-tabs-mode: nil */
+/* tab-width: 2 */
+/* c-basic-offset: 2 */
+/* End: */
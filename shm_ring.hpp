@@ -0,0 +1,281 @@
+/**
+ * @file   shm_ring.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sun Oct 18 02:21:47 2026
+ *
+ * @brief  Named shared-memory ring for exchanging records between processes (Linux)
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#pragma once
+
+#include <sps/cenv.h>
+#include <sps/sps_export.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__linux__)
+
+namespace sps
+{
+
+namespace detail
+{
+//! Futex word and number of waiters, shared between processes
+struct ShmEvent
+{
+  std::atomic<std::uint32_t> epoch;    ///< Incremented by notification
+  std::atomic<std::uint32_t> nWaiters; ///< Waiters registered
+};
+
+//! Header of the shared memory, followed by the data
+struct ShmRingHeader
+{
+  std::uint64_t magic;              ///< Identifies an initialized ring
+  std::uint64_t size;               ///< Capacity in bytes
+  std::atomic<std::uint32_t> ready; ///< Non-zero once initialized
+
+  SPS_ALIGNAS(64) std::atomic<std::uint64_t> head; ///< Bytes written, owned by writer
+  std::atomic<std::int32_t> writer;                ///< Process of writer, zero if detached
+  ShmEvent notEmpty;                               ///< Signalled by writer
+
+  SPS_ALIGNAS(64) std::atomic<std::uint64_t> tail; ///< Bytes read, owned by reader
+  std::atomic<std::int32_t> reader;                ///< Process of reader, zero if detached
+  ShmEvent notFull;                                ///< Signalled by reader
+};
+} // namespace detail
+
+//! Shared-memory ring
+/*!
+  Byte ring buffer shared by a writer and a reader process, which
+  exchange records in place, without copying them through the kernel
+  like POSIX message queues (@ref mq_clear). The ring is a named
+  shared memory object (shm_open) holding a header page followed by
+  the data, which is mapped twice at adjacent addresses like @ref
+  MagicRingBuffer, such that every record is contiguous.
+
+  The writer uses @ref reserve / @ref commit and the reader @ref peek
+  / @ref consume. Blocking is optional: @ref waitReadable and @ref
+  waitWritable sleep on a process-shared futex, which is only woken,
+  when the other side waits.
+
+  Attaching is crash-safe. Each role records its process in the
+  header. A role held by a process, which no longer exists, is taken
+  over, and since positions are only advanced after records are
+  complete, a record reserved by a crashed writer is simply never
+  seen. Waits take a timeout, such that a peer, which died, can be
+  detected using @ref peerAttached.
+
+  \code
+  // Acquisition process
+  sps::ShmRing ring("/frames", sps::ShmRing::Role::Writer, 64 << 20);
+  if (ring.waitWritable(sizeof(Frame), std::chrono::milliseconds(100)))
+  {
+    Acquire(static_cast<Frame*>(ring.reserve(sizeof(Frame))));
+    ring.commit(sizeof(Frame));
+  }
+  // Processing process
+  sps::ShmRing ring("/frames", sps::ShmRing::Role::Reader, 64 << 20);
+  if (ring.waitReadable(sizeof(Frame), std::chrono::milliseconds(100)))
+  {
+    Process(static_cast<const Frame*>(ring.peek(sizeof(Frame))));
+    ring.consume(sizeof(Frame));
+  }
+  \endcode
+*/
+class SPS_EXPORT ShmRing
+{
+public:
+  /// Side of the ring attached to
+  enum class Role
+  {
+    Writer, ///< Uses reserve / commit
+    Reader, ///< Uses peek / consume
+  };
+
+  /**
+   * Ctor. Attaches to the ring with the given name, creating it if it
+   * does not exist and a size is given.
+   *
+   * @param name Name of the shared memory object, e.g. "/frames"
+   * @param role Side to attach to
+   * @param size Minimum capacity in bytes, rounded up to a multiple of
+   *             the page size. Zero requires the ring to exist
+   *
+   * @throws std::invalid_argument if an existing ring has a different size
+   * @throws std::runtime_error if the role is held by a running process
+   * @throws std::system_error if the memory cannot be opened or mapped
+   */
+  ShmRing(const std::string& name, Role role, size_t size = 0);
+
+  /**
+   * Dtor. Detaches, the shared memory object persists until @ref Unlink
+   *
+   */
+  ~ShmRing();
+
+  /**
+   * Remove the name of a ring. Processes attached keep the memory
+   *
+   * @param name
+   *
+   * @return True if the name was removed
+   */
+  static bool Unlink(const std::string& name);
+
+  /**
+   * Reserve contiguous space for writing in place
+   *
+   * @param len Number of bytes
+   *
+   * @return Pointer to len writable bytes or nullptr if not available
+   */
+  void* reserve(size_t len)
+  {
+    const std::uint64_t head = m_pHeader->head.load(std::memory_order_relaxed);
+    if (m_nSize - (head - m_pHeader->tail.load(std::memory_order_acquire)) < len)
+    {
+      return nullptr;
+    }
+    return m_pData + head % m_nSize;
+  }
+
+  /**
+   * Publish bytes written to the space reserved
+   *
+   * @param len Number of bytes, at most the length reserved
+   */
+  void commit(size_t len)
+  {
+    m_pHeader->head.store(
+      m_pHeader->head.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    Notify(m_pHeader->notEmpty);
+  }
+
+  /**
+   * Access contiguous bytes for reading in place
+   *
+   * @param len Number of bytes
+   *
+   * @return Pointer to len readable bytes or nullptr if not available
+   */
+  const void* peek(size_t len) const
+  {
+    const std::uint64_t tail = m_pHeader->tail.load(std::memory_order_relaxed);
+    if (m_pHeader->head.load(std::memory_order_acquire) - tail < len)
+    {
+      return nullptr;
+    }
+    return m_pData + tail % m_nSize;
+  }
+
+  /**
+   * Release bytes read
+   *
+   * @param len Number of bytes, at most the length peeked
+   */
+  void consume(size_t len)
+  {
+    m_pHeader->tail.store(
+      m_pHeader->tail.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    Notify(m_pHeader->notFull);
+  }
+
+  /**
+   * Number of bytes, which may be read
+   *
+   * @return
+   */
+  size_t readable() const
+  {
+    return static_cast<size_t>(m_pHeader->head.load(std::memory_order_acquire) -
+      m_pHeader->tail.load(std::memory_order_acquire));
+  }
+
+  /**
+   * Number of bytes, which may be written
+   *
+   * @return
+   */
+  size_t writable() const { return m_nSize - readable(); }
+
+  /**
+   * Wait until len bytes may be read
+   *
+   * @param len Number of bytes
+   * @param timeout
+   *
+   * @return False on timeout
+   */
+  bool waitReadable(size_t len, std::chrono::milliseconds timeout);
+
+  /**
+   * Wait until len bytes may be written
+   *
+   * @param len Number of bytes, at most @ref size
+   * @param timeout
+   *
+   * @return False on timeout
+   */
+  bool waitWritable(size_t len, std::chrono::milliseconds timeout);
+
+  /**
+   * Is a running process attached to the other side
+   *
+   * @return
+   */
+  bool peerAttached() const;
+
+  /**
+   * Capacity in bytes
+   *
+   * @return
+   */
+  size_t size() const { return m_nSize; }
+
+  Role role() const { return m_role; }
+
+private:
+  ShmRing(const ShmRing&) = delete;
+  ShmRing& operator=(const ShmRing&) = delete;
+
+  /**
+   * Wake the other side, if it waits. The read-modify-write is
+   * ordered with the registration of a waiter, like @ref EventCount
+   *
+   * @param event
+   */
+  static void Notify(detail::ShmEvent& event)
+  {
+    if (event.nWaiters.fetch_add(0) != 0)
+    {
+      Wake(event);
+    }
+  }
+
+  static void Wake(detail::ShmEvent& event);
+
+  void map(int fd, size_t size);
+  void attach();
+
+  Role m_role;                      ///< Side attached to
+  size_t m_nSize;                   ///< Capacity, multiple of page size
+  size_t m_nPageSize;               ///< Size of header page
+  detail::ShmRingHeader* m_pHeader; ///< Shared header
+  unsigned char* m_pData;           ///< First of two adjacent views
+};
+
+} // namespace sps
+
+#endif
+
+/* Local variables: */
+/* indent-tabs-mode: nil */
+/* tab-width: 2 */
+/* c-basic-offset: 2 */
+/* End: */
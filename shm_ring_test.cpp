@@ -0,0 +1,237 @@
+/**
+ * @file   shm_ring_test.cpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sun Oct 18 03:02:33 2026
+ *
+ * @brief  Tests of sps::ShmRing
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#include <gtest/gtest.h>
+#include <sps/cenv.h>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <sps/shm_ring.hpp>
+
+namespace
+{
+std::string UniqueName(const char* test)
+{
+  return std::string("/sps_shm_ring_") + test + "_" + std::to_string(getpid());
+}
+
+int WaitExit(const pid_t pid)
+{
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+} // namespace
+
+TEST(shm_ring_test, attach)
+{
+  const std::string name = UniqueName("attach");
+  sps::ShmRing::Unlink(name);
+  EXPECT_THROW(sps::ShmRing(name, sps::ShmRing::Role::Reader), std::system_error);
+
+  sps::ShmRing writer(name, sps::ShmRing::Role::Writer, 1000);
+  const size_t size = writer.size();
+  EXPECT_GE(size, 1000u);
+  EXPECT_FALSE(writer.peerAttached());
+  EXPECT_THROW(sps::ShmRing(name, sps::ShmRing::Role::Writer), std::runtime_error);
+  EXPECT_THROW(sps::ShmRing(name, sps::ShmRing::Role::Reader, 2 * size), std::invalid_argument);
+
+  {
+    sps::ShmRing reader(name, sps::ShmRing::Role::Reader);
+    EXPECT_EQ(reader.size(), size);
+    EXPECT_TRUE(writer.peerAttached());
+    EXPECT_TRUE(reader.peerAttached());
+
+    // Advance close to the end
+    ASSERT_NE(writer.reserve(size - 10), nullptr);
+    writer.commit(size - 10);
+    ASSERT_TRUE(reader.waitReadable(size - 10, std::chrono::milliseconds(0)));
+    reader.consume(size - 10);
+
+    // A record across the end is contiguous
+    unsigned char* pRecord = static_cast<unsigned char*>(writer.reserve(100));
+    ASSERT_NE(pRecord, nullptr);
+    for (size_t i = 0; i < 100; i++)
+    {
+      pRecord[i] = static_cast<unsigned char>(i);
+    }
+    writer.commit(100);
+    const unsigned char* pRead = static_cast<const unsigned char*>(reader.peek(100));
+    ASSERT_NE(pRead, nullptr);
+    EXPECT_EQ(pRead[99], 99);
+    EXPECT_EQ(reader.peek(101), nullptr);
+    EXPECT_FALSE(reader.waitReadable(101, std::chrono::milliseconds(10)));
+    reader.consume(100);
+    EXPECT_EQ(writer.writable(), size);
+  }
+  EXPECT_FALSE(writer.peerAttached());
+  EXPECT_TRUE(sps::ShmRing::Unlink(name));
+}
+
+/**
+ * Test that a role held by a process, which exited without detaching,
+ * is taken over.
+ *
+ */
+TEST(shm_ring_test, crashed_writer)
+{
+  const std::string name = UniqueName("crashed");
+  sps::ShmRing::Unlink(name);
+  sps::ShmRing reader(name, sps::ShmRing::Role::Reader, 4096);
+
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0)
+  {
+    // Reserve a record, but exit without committing or detaching
+    sps::ShmRing* pWriter = new sps::ShmRing(name, sps::ShmRing::Role::Writer);
+    std::memset(pWriter->reserve(16), 0xFF, 16);
+    _exit(0);
+  }
+  ASSERT_EQ(WaitExit(pid), 0);
+  EXPECT_FALSE(reader.peerAttached());
+  EXPECT_EQ(reader.readable(), 0u);
+
+  sps::ShmRing writer(name, sps::ShmRing::Role::Writer);
+  EXPECT_TRUE(reader.peerAttached());
+  sps::ShmRing::Unlink(name);
+}
+
+/**
+ * Test that the waiter registration of a writer killed while waiting
+ * for space is reset, when the role is taken over.
+ *
+ */
+TEST(shm_ring_test, crashed_waiting_writer)
+{
+  const std::string name = UniqueName("crashed_waiting");
+  sps::ShmRing::Unlink(name);
+  sps::ShmRing reader(name, sps::ShmRing::Role::Reader, 4096);
+
+  const int fd = shm_open(name.c_str(), O_RDWR, 0);
+  ASSERT_GE(fd, 0);
+  void* pMapped = mmap(nullptr, sizeof(sps::detail::ShmRingHeader), PROT_READ | PROT_WRITE,
+    MAP_SHARED, fd, 0);
+  close(fd);
+  ASSERT_NE(pMapped, MAP_FAILED);
+  const sps::detail::ShmRingHeader* pHeader =
+    static_cast<const sps::detail::ShmRingHeader*>(pMapped);
+
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0)
+  {
+    // Fill the ring and wait for space, until killed
+    sps::ShmRing writer(name, sps::ShmRing::Role::Writer);
+    writer.reserve(writer.size());
+    writer.commit(writer.size());
+    writer.waitWritable(1, std::chrono::milliseconds(10000));
+    _exit(1);
+  }
+  while (pHeader->notFull.nWaiters.load() == 0)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  kill(pid, SIGKILL);
+  EXPECT_EQ(WaitExit(pid), -1);
+  EXPECT_EQ(pHeader->notFull.nWaiters.load(), 1u);
+
+  sps::ShmRing writer(name, sps::ShmRing::Role::Writer);
+  EXPECT_EQ(pHeader->notFull.nWaiters.load(), 0u);
+  munmap(pMapped, sizeof(sps::detail::ShmRingHeader));
+  sps::ShmRing::Unlink(name);
+}
+
+/**
+ * Test streaming variable-length records from a writer process to a
+ * reader process, blocking on both sides.
+ *
+ */
+TEST(shm_ring_test, processes)
+{
+  const std::string name = UniqueName("processes");
+  sps::ShmRing::Unlink(name);
+  const uint32_t nRecords = 20000;
+  const std::chrono::milliseconds timeout(5000);
+
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0)
+  {
+    int result = 0;
+    try
+    {
+      sps::ShmRing writer(name, sps::ShmRing::Role::Writer, 4096);
+      for (uint32_t i = 0; i < nRecords && result == 0; i++)
+      {
+        const uint32_t length = 1 + i % 300;
+        if (!writer.waitWritable(sizeof(length) + length, timeout))
+        {
+          result = 2;
+          break;
+        }
+        unsigned char* pRecord =
+          static_cast<unsigned char*>(writer.reserve(sizeof(length) + length));
+        std::memcpy(pRecord, &length, sizeof(length));
+        std::memset(pRecord + sizeof(length), static_cast<int>(i & 0xFF), length);
+        writer.commit(sizeof(length) + length);
+      }
+    }
+    catch (...)
+    {
+      result = 1;
+    }
+    _exit(result);
+  }
+
+  bool valid = true;
+  {
+    sps::ShmRing reader(name, sps::ShmRing::Role::Reader, 4096);
+    for (uint32_t i = 0; i < nRecords && valid; i++)
+    {
+      uint32_t length = 0;
+      valid = reader.waitReadable(sizeof(length), timeout);
+      if (valid)
+      {
+        std::memcpy(&length, reader.peek(sizeof(length)), sizeof(length));
+        valid = length == 1 + i % 300 && reader.waitReadable(sizeof(length) + length, timeout);
+      }
+      if (valid)
+      {
+        const unsigned char* pRecord =
+          static_cast<const unsigned char*>(reader.peek(sizeof(length) + length));
+        valid = pRecord[sizeof(length)] == (i & 0xFF) &&
+          pRecord[sizeof(length) + length - 1] == (i & 0xFF);
+        reader.consume(sizeof(length) + length);
+      }
+    }
+  }
+  EXPECT_EQ(WaitExit(pid), 0);
+  EXPECT_TRUE(valid);
+  sps::ShmRing::Unlink(name);
+}
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
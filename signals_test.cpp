@@ -24,11 +24,15 @@
 #include <float.h>
 
 #include <cassert>
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
+#include <string>
 
 #include <stdint.h>
 
+#include <fftw3.h>
+
 #include <gtest/gtest.h>
 
 using namespace sps;
@@ -396,6 +400,119 @@ TEST(signals_test, test_mconv_float1)
   ASSERT_LT((fmax_diff / (2 * next_power_two<size_t>(nc))), 1.1 * FLT_EPSILON);
 }
 
+/**
+ * Test convolutions of lengths, which are not powers of two. Lengths
+ * of at least 64 are transformed using smooth lengths (2^a 3^b 5^c 7^d)
+ *
+ */
+TEST(signals_test, test_conv_smooth_lengths)
+{
+  // Required lengths 100, 166 and 300, and 75, 90 and 150, for which
+  // the number of complex samples n/2+1 of the smooth length is even
+  const size_t lengths[][2] = { { 61, 40 }, { 97, 70 }, { 200, 101 }, { 40, 36 }, { 50, 41 },
+    { 100, 50 } };
+  for (const auto& length : lengths)
+  {
+    const size_t na = length[0];
+    const size_t nb = length[1];
+    // Values are up to na * nb * nb
+    const double scale = double(na) * double(nb) * double(nb);
+
+    ASSERT_LT(test_conv<double>(na, nb) / scale, 100 * DBL_EPSILON);
+    ASSERT_LT(test_mconv<double>(na, nb) / scale, 100 * DBL_EPSILON);
+    ASSERT_LT(test_conv<float>(na, nb) / scale, 100 * FLT_EPSILON);
+    ASSERT_LT(test_mconv<float>(na, nb) / scale, 100 * FLT_EPSILON);
+  }
+}
+
+/**
+ * Plan a forward transform only from wisdom, like transforms do
+ * before estimating a plan
+ *
+ * @param n Length of transform
+ *
+ * @return True if wisdom for the length is available
+ */
+static bool test_fft_wisdom_only(const size_t n)
+{
+  float* in = static_cast<float*>(fftwf_malloc(2 * (n / 2 + 1) * sizeof(float)));
+  fftwf_complex* out =
+    static_cast<fftwf_complex*>(fftwf_malloc((n / 2 + 1) * sizeof(fftwf_complex)));
+  fftwf_plan plan =
+    fftwf_plan_dft_r2c_1d(static_cast<int>(n), in, out, FFTW_MEASURE | FFTW_WISDOM_ONLY);
+  const bool retval = plan != nullptr;
+  if (plan)
+  {
+    fftwf_destroy_plan(plan);
+  }
+  fftwf_free(in);
+  fftwf_free(out);
+  return retval;
+}
+
+/**
+ * Test planning ahead of time and transforms using the wisdom
+ * imported. The wisdom is forgotten before the import, so plans made
+ * from wisdom afterwards come from the file.
+ *
+ */
+TEST(signals_test, test_fft_wisdom)
+{
+  const size_t lengths[] = { 16, 30, 100 };
+  const std::string filename = ::testing::TempDir() + "sps_fftwf_wisdom";
+
+  ASSERT_TRUE(fft_plan<float>(lengths, 3, FFTPlanRigor::Measure));
+  ASSERT_TRUE(fft_wisdom_export<float>(filename.c_str()));
+  fftwf_forget_wisdom();
+  ASSERT_FALSE(test_fft_wisdom_only(100));
+
+  ASSERT_TRUE(fft_wisdom_import<float>(filename.c_str()));
+  EXPECT_FALSE(fft_wisdom_import<float>((filename + ".missing").c_str()));
+  std::remove(filename.c_str());
+  EXPECT_TRUE(test_fft_wisdom_only(100));
+
+  // Transforms of length 30
+  const size_t n = 15;
+  float fmax_diff = test_fft<float>(n);
+  ASSERT_LT((fmax_diff / (2.0 * next_power_two<size_t>(n))), 1.1 * FLT_EPSILON);
+}
+
+/**
+ * Test choosing convolution lengths ahead of time. The lengths chosen
+ * are smooth, at least the required lengths and are kept.
+ *
+ */
+TEST(signals_test, test_fft_convolution_lengths)
+{
+  const size_t minimums[] = { 40, 100, 166, 300 };
+  size_t lengths[4] = {};
+  size_t chosen[4] = {};
+
+  fft_convolution_lengths<double>(minimums, 4, lengths);
+  for (size_t i = 0; i < 4; i++)
+  {
+    ASSERT_GE(lengths[i], minimums[i]);
+    ASSERT_LE(lengths[i], next_power_two<size_t>(minimums[i]));
+    size_t remainder = lengths[i];
+    for (const size_t prime : { 2, 3, 5, 7 })
+    {
+      while (remainder % prime == 0)
+      {
+        remainder /= prime;
+      }
+    }
+    EXPECT_EQ(remainder, size_t(1));
+  }
+  EXPECT_EQ(lengths[0], size_t(64));
+  EXPECT_TRUE(fft_plan<double>(lengths, 4, FFTPlanRigor::Measure));
+
+  fft_convolution_lengths<double>(minimums, 4, chosen);
+  for (size_t i = 0; i < 4; i++)
+  {
+    EXPECT_EQ(chosen[i], lengths[i]);
+  }
+}
+
 TEST(signals_test, test_fft)
 {
   const size_t n = 8;
@@ -0,0 +1,504 @@
+/**
+ * @file   simo.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sun Oct 18 01:34:10 2026
+ *
+ * @brief  Single-writer-multiple-reader broadcast ring
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#pragma once
+
+#include <sps/cenv.h>
+#include <sps/eventcount.hpp>
+
+#include <atomic>      // std::atomic
+#include <cstddef>     // std::size_t
+#include <cstdint>     // std::uint64_t
+#include <stdexcept>   // std::length_error
+#include <type_traits> // std::conditional
+#include <utility>     // std::forward
+
+namespace sps
+{
+
+//! Behaviour of a broadcast ring, when a reader falls behind
+enum class BroadcastPolicy
+{
+  Block,    ///< Writer waits for the slowest reader
+  Overwrite ///< Writer never waits, slow readers lose elements
+};
+
+/*! \brief Single-Writer-Multiple-Reader broadcast ring
+ *
+ * Every element pushed is seen by every reader, such that one
+ * acquisition stream is fanned out to several consumers with a single
+ * write. The writer publishes a free-running sequence and each @ref
+ * Reader, obtained using @ref subscribe, tracks its own. Size must be a
+ * power of two.
+ *
+ * With BroadcastPolicy::Block, the writer is gated by the slowest
+ * reader. The gate is cached by the writer and the readers are only
+ * scanned, when the cached gate indicates full. With
+ * BroadcastPolicy::Overwrite, the writer never waits. Each element
+ * carries its sequence, such that a reader detects being overtaken,
+ * skips to the oldest element available and counts the elements lost.
+ * Elements are then copied optimistically, so T must be trivially
+ * copyable.
+ *
+ * A reader processes everything available in one pass using @ref
+ * Reader::poll, which publishes its sequence once per batch.
+ *
+ * \code
+ * sps::SWMRBroadcastRing<Frame, 1024> ring;
+ * auto display = ring.subscribe(); // One reader per consumer thread
+ * auto recorder = ring.subscribe();
+ * ring.push(frame);                // Producer thread
+ * recorder.poll([&](const Frame& frame) { Record(frame); });
+ * \endcode
+ */
+template <typename T, size_t Size, BroadcastPolicy Policy = BroadcastPolicy::Block,
+  size_t MaxReaders = 8>
+class SWMRBroadcastRing
+{
+  static_assert(Size > 1 && (Size & (Size - 1)) == 0, "Size must be a power of two");
+  static_assert(MaxReaders > 0, "At least one reader must be supported");
+  static_assert(Policy == BroadcastPolicy::Block || std::is_trivially_copyable<T>::value,
+    "Overwriting requires trivially copyable elements");
+
+  static constexpr std::uint64_t Mask = Size - 1;
+  /// Sequence of a free reader slot, ignored by the gate
+  static constexpr std::uint64_t Unused = ~std::uint64_t(0);
+  /// Attempts with a pause before a blocking call sleeps
+  static constexpr size_t SpinCount = 64;
+
+  struct PlainCell
+  {
+    T value;
+  };
+
+  struct SequencedCell
+  {
+    std::atomic<std::uint64_t> sequence{ Unused }; ///< Sequence of value, Unused while written
+    T value;
+  };
+
+  using Cell = typename std::conditional<Policy == BroadcastPolicy::Overwrite, SequencedCell,
+    PlainCell>::type;
+
+  struct SPS_ALIGNAS(64) ReaderSlot
+  {
+    std::atomic<std::uint64_t> sequence{ Unused }; ///< Next sequence to be read
+  };
+
+public:
+  //! Reader of a broadcast ring
+  /*!
+    Owned by a single consumer thread. Unsubscribes on destruction and
+    must not outlive the ring.
+  */
+  class Reader
+  {
+  public:
+    Reader(Reader&& other) noexcept
+      : m_pRing{ other.m_pRing }
+      , m_iSlot{ other.m_iSlot }
+      , m_iNext{ other.m_iNext }
+      , m_iCursorCached{ other.m_iCursorCached }
+      , m_nLost{ other.m_nLost }
+    {
+      other.m_pRing = nullptr;
+    }
+
+    Reader& operator=(Reader&& other) noexcept
+    {
+      if (this != &other)
+      {
+        unsubscribe();
+        m_pRing = other.m_pRing;
+        m_iSlot = other.m_iSlot;
+        m_iNext = other.m_iNext;
+        m_iCursorCached = other.m_iCursorCached;
+        m_nLost = other.m_nLost;
+        other.m_pRing = nullptr;
+      }
+      return *this;
+    }
+
+    ~Reader() { unsubscribe(); }
+
+    /**
+     * Pop next element
+     *
+     * @param destination
+     *
+     * @return True if a value is written to destination, false otherwise
+     */
+    bool try_pop(T& destination)
+    {
+      while (refresh())
+      {
+        if (read(destination))
+        {
+          publish();
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+     * Pop next element. Blocks while no element is available
+     *
+     * @return
+     */
+    T pop()
+    {
+      T ret;
+      m_pRing->m_notEmpty.await([&]() { return try_pop(ret); }, SpinCount);
+      return ret;
+    }
+
+    /**
+     * Process all elements available in one pass. With
+     * BroadcastPolicy::Block, elements are accessed in place.
+     *
+     * @param func Callable invoked with each element as const T&
+     *
+     * @return Number of elements processed
+     */
+    template <typename Func>
+    size_t poll(Func&& func)
+    {
+      const std::uint64_t iEnd = m_pRing->m_iCursor.load(std::memory_order_acquire);
+      m_iCursorCached = iEnd;
+      size_t n = 0;
+      if (Policy == BroadcastPolicy::Block)
+      {
+        for (; m_iNext != iEnd; m_iNext++, n++)
+        {
+          func(static_cast<const T&>(m_pRing->m_cells[m_iNext & Mask].value));
+        }
+      }
+      else
+      {
+        T value;
+        while (m_iNext < iEnd)
+        {
+          if (read(value))
+          {
+            func(static_cast<const T&>(value));
+            n++;
+          }
+        }
+      }
+      if (n > 0)
+      {
+        publish();
+      }
+      return n;
+    }
+
+    /**
+     * Number of elements available
+     *
+     * @return
+     */
+    size_t available() const
+    {
+      const std::uint64_t iCursor = m_pRing->m_iCursor.load(std::memory_order_acquire);
+      const std::uint64_t n = iCursor - m_iNext;
+      return static_cast<size_t>(n < Size ? n : Size);
+    }
+
+    /**
+     * Number of elements overwritten before they were read. Always
+     * zero with BroadcastPolicy::Block
+     *
+     * @return
+     */
+    std::uint64_t lost() const { return m_nLost; }
+
+    /**
+     * Sequence of the next element to be read
+     *
+     * @return
+     */
+    std::uint64_t sequence() const { return m_iNext; }
+
+  private:
+    friend class SWMRBroadcastRing;
+
+    Reader(SWMRBroadcastRing* pRing, const size_t iSlot, const std::uint64_t iNext)
+      : m_pRing{ pRing }
+      , m_iSlot{ iSlot }
+      , m_iNext{ iNext }
+      , m_iCursorCached{ iNext }
+    {
+    }
+
+    Reader(const Reader& rhs) = delete;
+    Reader& operator=(const Reader& rhs) = delete;
+
+    /**
+     * Reload the cursor, when all elements seen are read
+     *
+     * @return True if an element is available
+     */
+    bool refresh()
+    {
+      if (m_iNext == m_iCursorCached)
+      {
+        m_iCursorCached = m_pRing->m_iCursor.load(std::memory_order_acquire);
+      }
+      return m_iNext != m_iCursorCached;
+    }
+
+    /**
+     * Read the next element, which is below the cached cursor
+     *
+     * @param destination
+     *
+     * @return False if it was overwritten while reading
+     */
+    bool read(T& destination)
+    {
+      Cell& cell = m_pRing->m_cells[m_iNext & Mask];
+      if (Policy == BroadcastPolicy::Block)
+      {
+        destination = cell.value;
+        m_iNext++;
+        return true;
+      }
+      return readSequenced(cell, destination);
+    }
+
+    template <typename C>
+    bool readSequenced(C& cell, T& destination)
+    {
+      if (m_iCursorCached - m_iNext > Size)
+      {
+        // Overtaken, skip to the oldest element available
+        m_nLost += m_iCursorCached - Size - m_iNext;
+        m_iNext = m_iCursorCached - Size;
+        return false;
+      }
+      if (cell.sequence.load(std::memory_order_acquire) == m_iNext)
+      {
+        destination = cell.value;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (cell.sequence.load(std::memory_order_relaxed) == m_iNext)
+        {
+          m_iNext++;
+          return true;
+        }
+      }
+      m_iCursorCached = m_pRing->m_iCursor.load(std::memory_order_acquire);
+      return false;
+    }
+
+    bool readSequenced(PlainCell&, T&) { return false; }
+
+    void publish()
+    {
+      if (Policy == BroadcastPolicy::Block)
+      {
+        m_pRing->m_readers[m_iSlot].sequence.store(m_iNext, std::memory_order_release);
+        m_pRing->m_notFull.notify();
+      }
+    }
+
+    void unsubscribe()
+    {
+      if (m_pRing)
+      {
+        m_pRing->m_readers[m_iSlot].sequence.store(Unused, std::memory_order_release);
+        m_pRing->m_notFull.notify();
+        m_pRing = nullptr;
+      }
+    }
+
+    SWMRBroadcastRing* m_pRing;    ///< Ring read from
+    size_t m_iSlot;                ///< Slot publishing the sequence
+    std::uint64_t m_iNext;         ///< Next sequence to be read
+    std::uint64_t m_iCursorCached; ///< Cursor seen by reader
+    std::uint64_t m_nLost{ 0 };    ///< Elements overwritten before read
+  };
+
+  SWMRBroadcastRing() = default;
+
+  size_t size() const { return Size; }
+
+  /**
+   * Register a reader. It receives all elements pushed after
+   * subscribing. May be called concurrently with the writer.
+   *
+   * @return Reader
+   *
+   * @throws std::length_error if MaxReaders are subscribed
+   */
+  Reader subscribe()
+  {
+    for (size_t i = 0; i < MaxReaders; i++)
+    {
+      std::uint64_t expected = Unused;
+      std::uint64_t iCursor = m_iCursor.load();
+      if (m_readers[i].sequence.compare_exchange_strong(expected, iCursor))
+      {
+        // Republish until the cursor is stable. The writer then either
+        // sees this reader or its gate is at most the cursor seen.
+        std::uint64_t iLatest = 0;
+        while ((iLatest = m_iCursor.load()) != iCursor)
+        {
+          iCursor = iLatest;
+          m_readers[i].sequence.store(iCursor);
+        }
+        return Reader(this, i, iCursor);
+      }
+    }
+    throw std::length_error("Too many readers");
+  }
+
+  bool try_push(T&& source) { return emplace(std::move(source)); }
+
+  bool try_push(const T& source) { return emplace(source); }
+
+  /**
+   * Push element. With BroadcastPolicy::Block, blocks while the
+   * slowest reader is Size elements behind
+   *
+   * @param source
+   */
+  void push(T&& source)
+  {
+    m_notFull.await([&]() { return try_push(std::move(source)); }, SpinCount);
+  }
+
+  void push(const T& source)
+  {
+    m_notFull.await([&]() { return try_push(source); }, SpinCount);
+  }
+
+  /**
+   * Push up to n elements, which are copied, using a single cursor
+   * update
+   *
+   * @param first Iterator to first element
+   * @param n Number of elements
+   *
+   * @return Number of elements pushed
+   */
+  template <typename InputIt>
+  size_t try_push_n(InputIt first, size_t n)
+  {
+    const std::uint64_t iWrite = m_iCursor.load(std::memory_order_relaxed);
+    if (Policy == BroadcastPolicy::Block)
+    {
+      const std::uint64_t nFree = writable(iWrite, n);
+      n = static_cast<size_t>(n < nFree ? n : nFree);
+    }
+    if (n == 0)
+    {
+      return 0;
+    }
+    for (size_t i = 0; i < n; i++, ++first)
+    {
+      store(iWrite + i, *first);
+    }
+    m_iCursor.store(iWrite + n, std::memory_order_release);
+    m_notEmpty.notifyAll();
+    return n;
+  }
+
+  /**
+   * Number of elements pushed
+   *
+   * @return
+   */
+  std::uint64_t cursor() const { return m_iCursor.load(std::memory_order_acquire); }
+
+private:
+  SWMRBroadcastRing(const SWMRBroadcastRing& rhs) = delete;
+  SWMRBroadcastRing& operator=(const SWMRBroadcastRing& rhs) = delete;
+
+  /**
+   * Number of elements, which the writer may push without overtaking
+   * the slowest reader. The readers are scanned only if fewer than
+   * requested are free according to the cached gate.
+   *
+   * @param iWrite Cursor (own)
+   * @param n Number of elements requested
+   *
+   * @return
+   */
+  std::uint64_t writable(const std::uint64_t iWrite, const size_t n)
+  {
+    if (Size - (iWrite - m_iGateCached) < n)
+    {
+      // Order the scan after subscriptions republishing the cursor
+      m_iCursor.fetch_add(0);
+      std::uint64_t iGate = iWrite;
+      for (size_t i = 0; i < MaxReaders; i++)
+      {
+        const std::uint64_t iRead = m_readers[i].sequence.load();
+        iGate = iRead < iGate ? iRead : iGate;
+      }
+      m_iGateCached = iGate;
+    }
+    return Size - (iWrite - m_iGateCached);
+  }
+
+  template <typename U>
+  bool emplace(U&& source)
+  {
+    const std::uint64_t iWrite = m_iCursor.load(std::memory_order_relaxed);
+    if (Policy == BroadcastPolicy::Block && writable(iWrite, 1) == 0)
+    {
+      return false;
+    }
+    store(iWrite, std::forward<U>(source));
+    m_iCursor.store(iWrite + 1, std::memory_order_release);
+    m_notEmpty.notifyAll();
+    return true;
+  }
+
+  template <typename U>
+  void store(const std::uint64_t iWrite, U&& source)
+  {
+    Cell& cell = m_cells[iWrite & Mask];
+    Invalidate(cell);
+    cell.value = std::forward<U>(source);
+    Validate(cell, iWrite);
+  }
+
+  static void Invalidate(PlainCell&) {}
+
+  static void Invalidate(SequencedCell& cell)
+  {
+    cell.sequence.store(Unused, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  static void Validate(PlainCell&, std::uint64_t) {}
+
+  static void Validate(SequencedCell& cell, const std::uint64_t iWrite)
+  {
+    cell.sequence.store(iWrite, std::memory_order_release);
+  }
+
+  SPS_ALIGNAS(64) Cell m_cells[Size];
+  SPS_ALIGNAS(64) std::atomic<std::uint64_t> m_iCursor{ 0 }; ///< Elements pushed, owned by writer
+  std::uint64_t m_iGateCached{ 0 };                          ///< Slowest reader seen by writer
+  ReaderSlot m_readers[MaxReaders];                          ///< Sequences of readers
+  SPS_ALIGNAS(64) EventCount m_notEmpty;                     ///< Signalled by writer
+  SPS_ALIGNAS(64) EventCount m_notFull;                      ///< Signalled by readers
+};
+
+} // namespace sps
+
+/* Local variables: */
+/* indent-tabs-mode: nil */
+/* tab-width: 2 */
+/* c-basic-offset: 2 */
+/* End: */
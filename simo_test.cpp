@@ -0,0 +1,149 @@
+/**
+ * @file   simo_test.cpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sun Oct 18 01:58:21 2026
+ *
+ * @brief  Tests of sps::SWMRBroadcastRing
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#include <gtest/gtest.h>
+#include <sps/cenv.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <sps/simo.hpp>
+
+TEST(simo_test, gated_by_slowest)
+{
+  sps::SWMRBroadcastRing<int, 4, sps::BroadcastPolicy::Block, 2> ring;
+  auto fast = ring.subscribe();
+  auto slow = ring.subscribe();
+  EXPECT_THROW(ring.subscribe(), std::length_error);
+
+  const int values[] = { 0, 1, 2, 3, 4 };
+  EXPECT_EQ(ring.try_push_n(values, 5), 4u);
+  EXPECT_FALSE(ring.try_push(4));
+
+  int value = -1;
+  for (int i = 0; i < 4; i++)
+  {
+    ASSERT_TRUE(fast.try_pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(fast.try_pop(value));
+  EXPECT_FALSE(ring.try_push(4));
+
+  // Batch, elements in place
+  int sum = 0;
+  EXPECT_EQ(slow.poll([&](const int& element) { sum += element; }), 4u);
+  EXPECT_EQ(sum, 6);
+  EXPECT_EQ(slow.poll([&](const int&) {}), 0u);
+  EXPECT_TRUE(ring.try_push(4));
+
+  // Unsubscribing releases the gate and the slot
+  {
+    auto reader = std::move(slow);
+  }
+  auto late = ring.subscribe();
+  EXPECT_EQ(late.sequence(), 5u);
+  EXPECT_EQ(late.available(), 0u);
+  EXPECT_EQ(fast.available(), 1u);
+  EXPECT_EQ(ring.try_push_n(values, 5), 3u);
+  EXPECT_EQ(fast.lost(), 0u);
+}
+
+TEST(simo_test, overwrite)
+{
+  sps::SWMRBroadcastRing<std::uint64_t, 8, sps::BroadcastPolicy::Overwrite> ring;
+  auto reader = ring.subscribe();
+
+  for (std::uint64_t i = 0; i < 20; i++)
+  {
+    EXPECT_TRUE(ring.try_push(i));
+  }
+  EXPECT_EQ(reader.available(), 8u);
+
+  // Oldest elements are lost
+  std::uint64_t value = 0;
+  ASSERT_TRUE(reader.try_pop(value));
+  EXPECT_EQ(value, 12u);
+  EXPECT_EQ(reader.lost(), 12u);
+
+  std::vector<std::uint64_t> values;
+  EXPECT_EQ(reader.poll([&](const std::uint64_t& element) { values.push_back(element); }), 7u);
+  ASSERT_EQ(values.size(), 7u);
+  EXPECT_EQ(values.front(), 13u);
+  EXPECT_EQ(values.back(), 19u);
+  EXPECT_FALSE(reader.try_pop(value));
+}
+
+/**
+ * Test that every reader sees every element in order, while the
+ * writer is gated by the slowest of them.
+ *
+ */
+TEST(simo_test, broadcast_threads)
+{
+  using Ring = sps::SWMRBroadcastRing<std::uint64_t, 64>;
+  Ring ring;
+  const std::uint64_t nElements = 100000;
+  const size_t nReaders = 3;
+
+  std::vector<Ring::Reader> readers;
+  for (size_t i = 0; i < nReaders; i++)
+  {
+    readers.push_back(ring.subscribe());
+  }
+
+  std::vector<int> valid(nReaders, 0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < nReaders; i++)
+  {
+    threads.emplace_back(
+      [&, i]()
+      {
+        Ring::Reader& reader = readers[i];
+        bool ordered = true;
+        std::uint64_t expected = 0;
+        while (expected < nElements)
+        {
+          if (i == 0)
+          {
+            // Blocking, one element at a time
+            ordered = ordered && reader.pop() == expected++;
+          }
+          else if (reader.poll([&](const std::uint64_t& element)
+                     { ordered = ordered && element == expected++; }) == 0)
+          {
+            std::this_thread::yield();
+          }
+        }
+        valid[i] = ordered && reader.lost() == 0;
+      });
+  }
+
+  for (std::uint64_t i = 0; i < nElements; i++)
+  {
+    ring.push(i);
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  for (size_t i = 0; i < nReaders; i++)
+  {
+    EXPECT_TRUE(valid[i]) << "Reader " << i;
+  }
+  EXPECT_EQ(ring.cursor(), nElements);
+}
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
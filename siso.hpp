@@ -18,10 +18,17 @@
 #endif
 
 #include <sps/cenv.h>
+#include <sps/eventcount.hpp>
+#include <sps/page_buffer.hpp>
 
+#include <algorithm>   // std::min
 #include <atomic>      // std::atomic
 #include <cstddef>     // std::size_t
 #include <cstdint>     // std::int32_t
+#include <limits>      // std::numeric_limits
+#include <new>         // placement new
+#include <stdexcept>   // std::invalid_argument
+#include <thread>      // std::this_thread::yield
 #include <type_traits> // std::is_copy_constructible
 #include <utility>     // std::move
 
@@ -114,16 +121,89 @@ public:
   virtual void push(const T& souce) = 0;
 };
 
+/*! \brief Single-Reader-Single-Writer Ring Buffer
+ *
+ * Lock-free ring buffer holding at most Size - 1 elements. Each side
+ * owns one index. It reads its own index relaxed and the index of the
+ * other side using acquire, and publishes its index using release.
+ *
+ * Besides single elements, blocks are moved using @ref try_push_n
+ * and @ref try_pop_n or accessed in place using @ref write_reserve /
+ * @ref write_commit and @ref read_reserve / @ref read_commit, which
+ * publish an index once per block.
+ *
+ * Blocking @ref push and @ref pop spin briefly and then sleep on an
+ * @ref EventCount, until the other side publishes. Publishing costs a
+ * single atomic read-modify-write, unless the other side sleeps.
+ */
 template <typename T, size_t Size, bool = std::is_copy_constructible<T>::value>
 class SRSWRingBuffer : public ISRSWRingBuffer<T, Size, std::is_copy_constructible<T>::value>
 {
+public:
+  //! Contiguous range of elements inside the ring buffer
+  struct Span
+  {
+    T* data;     ///< First element
+    size_t size; ///< Number of elements
+  };
+
 protected:
+  /// Attempts with a pause before a blocking call sleeps
+  static constexpr size_t SpinCount = 64;
+
   std::atomic<std::uint32_t> m_iWrite;
   std::atomic<std::uint32_t> m_iRead;
   T m_Buffer[Size];
+  SPS_ALIGNAS(64) EventCount m_notEmpty; ///< Signalled by writer
+  SPS_ALIGNAS(64) EventCount m_notFull;  ///< Signalled by reader
+
+  /**
+   * Retry an attempt, first spinning, then sleeping on an event
+   * count until the other side publishes
+   *
+   * @param event Event signalled by the other side
+   * @param attempt Callable returning true on success
+   */
+  template <typename Attempt>
+  static void Block(EventCount& event, Attempt&& attempt)
+  {
+    event.await(std::forward<Attempt>(attempt), SpinCount);
+  }
 
   std::uint32_t increment(std::uint32_t n) { return (n + 1U) % Size; }
 
+  std::uint32_t advance(std::uint32_t n, size_t count) const
+  {
+    return static_cast<std::uint32_t>((n + count) % Size);
+  }
+
+  /**
+   * Number of slots, which the writer may fill contiguously
+   *
+   * @param iWrite Write index (own)
+   * @param iRead Read index (other side)
+   *
+   * @return
+   */
+  static size_t writable(std::uint32_t iWrite, std::uint32_t iRead)
+  {
+    // One slot is kept free to distinguish full from empty
+    return iRead > iWrite ? iRead - iWrite - 1 : Size - iWrite - (iRead == 0 ? 1 : 0);
+  }
+
+  /**
+   * Number of elements, which the reader may take contiguously
+   *
+   * @param iRead Read index (own)
+   * @param iWrite Write index (other side)
+   *
+   * @return
+   */
+  static size_t readable(std::uint32_t iRead, std::uint32_t iWrite)
+  {
+    return iWrite >= iRead ? iWrite - iRead : Size - iRead;
+  }
+
 public:
   /**
    * Ctor
@@ -148,32 +228,37 @@ public:
   bool try_push(T&& source) SPS_OVERRIDE
   {
     // Verified for non-copy-constructible object
-    const auto current_tail = m_iWrite.load();
+    const auto current_tail = m_iWrite.load(std::memory_order_relaxed);
     const auto next_tail = increment(current_tail);
-    if (next_tail != m_iRead.load())
+    if (next_tail != m_iRead.load(std::memory_order_acquire))
     {
       m_Buffer[current_tail] = std::move(source);
-      m_iWrite.store(next_tail);
+      m_iWrite.store(next_tail, std::memory_order_release);
+      m_notEmpty.notify();
       return true;
     }
     return false;
   }
 
+  /**
+   * Push element onto queue. Blocks while the queue is full
+   *
+   * @param source
+   */
   void push(T&& source) SPS_OVERRIDE
   {
-    while (!try_push(std::move(source)))
-    {
-    }
+    Block(m_notFull, [&]() { return try_push(std::move(source)); });
   }
 #else
   bool try_push(T source) SPS_OVERRIDE
   {
-    const auto current_tail = m_iWrite.load();
+    const auto current_tail = m_iWrite.load(std::memory_order_relaxed);
     const auto next_tail = increment(current_tail);
-    if (next_tail != m_iRead.load())
+    if (next_tail != m_iRead.load(std::memory_order_acquire))
     {
       m_Buffer[current_tail] = std::move(source);
-      m_iWrite.store(next_tail);
+      m_iWrite.store(next_tail, std::memory_order_release);
+      m_notEmpty.notify();
       return true;
     }
     return false;
@@ -181,31 +266,160 @@ public:
 
   void push(T source) SPS_OVERRIDE
   {
-    while (!try_push(source))
-    {
-    }
+    Block(m_notFull, [&]() { return try_push(source); });
   }
 #endif
 
   bool try_pop(T& destination) override
   {
-    auto currentHead = m_iRead.load();
-    if (currentHead == m_iWrite.load())
+    auto currentHead = m_iRead.load(std::memory_order_relaxed);
+    if (currentHead == m_iWrite.load(std::memory_order_acquire))
     {
       return false;
     }
     destination = std::move(m_Buffer[currentHead]);
-    m_iRead.store(increment(currentHead));
+    m_iRead.store(increment(currentHead), std::memory_order_release);
+    m_notFull.notify();
     return true;
   }
 
+  /**
+   * Pop element from queue. Blocks while the queue is empty
+   *
+   * @return
+   */
   T pop() override
   {
     T ret;
-    while (!try_pop(ret))
+    Block(m_notEmpty, [&]() { return try_pop(ret); });
+    return ret;
+  }
+
+  /**
+   * Push up to n elements onto queue, which are moved from. The
+   * elements are published using a single index update.
+   *
+   * @param first Iterator to first element
+   * @param n Number of elements
+   *
+   * @return Number of elements pushed
+   */
+  template <typename InputIt>
+  size_t try_push_n(InputIt first, size_t n)
+  {
+    const std::uint32_t iWrite = m_iWrite.load(std::memory_order_relaxed);
+    const std::uint32_t iRead = m_iRead.load(std::memory_order_acquire);
+    size_t nPushed = 0;
+    std::uint32_t index = iWrite;
+    // At most two contiguous parts, before and after wrapping
+    for (size_t nFree = writable(index, iRead); nPushed < n && nFree > 0;
+         nFree = writable(index, iRead))
     {
+      const size_t nPart = std::min(n - nPushed, nFree);
+      for (size_t i = 0; i < nPart; i++, ++first)
+      {
+        m_Buffer[index + i] = std::move(*first);
+      }
+      nPushed += nPart;
+      index = advance(index, nPart);
     }
-    return ret;
+    if (nPushed > 0)
+    {
+      m_iWrite.store(index, std::memory_order_release);
+      m_notEmpty.notify();
+    }
+    return nPushed;
+  }
+
+  /**
+   * Pop up to n elements from queue using a single index update
+   *
+   * @param destination Output iterator
+   * @param n Maximum number of elements
+   *
+   * @return Number of elements popped
+   */
+  template <typename OutputIt>
+  size_t try_pop_n(OutputIt destination, size_t n)
+  {
+    const std::uint32_t iRead = m_iRead.load(std::memory_order_relaxed);
+    const std::uint32_t iWrite = m_iWrite.load(std::memory_order_acquire);
+    size_t nPopped = 0;
+    std::uint32_t index = iRead;
+    for (size_t nReady = readable(index, iWrite); nPopped < n && nReady > 0;
+         nReady = readable(index, iWrite))
+    {
+      const size_t nPart = std::min(n - nPopped, nReady);
+      for (size_t i = 0; i < nPart; i++, ++destination)
+      {
+        *destination = std::move(m_Buffer[index + i]);
+      }
+      nPopped += nPart;
+      index = advance(index, nPart);
+    }
+    if (nPopped > 0)
+    {
+      m_iRead.store(index, std::memory_order_release);
+      m_notFull.notify();
+    }
+    return nPopped;
+  }
+
+  /**
+   * Reserve contiguous slots for writing in place. The span may be
+   * shorter than requested, when the buffer is almost full or the
+   * slots wrap around the end. Writes are published by @ref
+   * write_commit.
+   *
+   * @param n Number of slots wanted
+   *
+   * @return Span of at most n slots, possibly empty
+   */
+  Span write_reserve(size_t n)
+  {
+    const std::uint32_t iWrite = m_iWrite.load(std::memory_order_relaxed);
+    const size_t nFree = writable(iWrite, m_iRead.load(std::memory_order_acquire));
+    return Span{ &m_Buffer[iWrite], std::min(n, nFree) };
+  }
+
+  /**
+   * Publish n slots written, at most the size of the span reserved
+   *
+   * @param n
+   */
+  void write_commit(size_t n)
+  {
+    const std::uint32_t iWrite = m_iWrite.load(std::memory_order_relaxed);
+    m_iWrite.store(advance(iWrite, n), std::memory_order_release);
+    m_notEmpty.notify();
+  }
+
+  /**
+   * Access contiguous elements for reading in place. The span may be
+   * shorter than the number of elements available, when they wrap
+   * around the end. Slots are released by @ref read_commit.
+   *
+   * @param n Number of elements wanted
+   *
+   * @return Span of at most n elements, possibly empty
+   */
+  Span read_reserve(size_t n)
+  {
+    const std::uint32_t iRead = m_iRead.load(std::memory_order_relaxed);
+    const size_t nReady = readable(iRead, m_iWrite.load(std::memory_order_acquire));
+    return Span{ &m_Buffer[iRead], std::min(n, nReady) };
+  }
+
+  /**
+   * Release n elements read, at most the size of the span reserved
+   *
+   * @param n
+   */
+  void read_commit(size_t n)
+  {
+    const std::uint32_t iRead = m_iRead.load(std::memory_order_relaxed);
+    m_iRead.store(advance(iRead, n), std::memory_order_release);
+    m_notFull.notify();
   }
 };
 
@@ -220,12 +434,13 @@ public:
    */
   bool try_push(const T& source) override
   {
-    const auto current_tail = this->m_iWrite.load();
+    const auto current_tail = this->m_iWrite.load(std::memory_order_relaxed);
     const auto next_tail = this->increment(current_tail);
-    if (next_tail != this->m_iRead.load())
+    if (next_tail != this->m_iRead.load(std::memory_order_acquire))
     {
       this->m_Buffer[current_tail] = source;
-      this->m_iWrite.store(next_tail);
+      this->m_iWrite.store(next_tail, std::memory_order_release);
+      this->m_notEmpty.notify();
       return true;
     }
     return false;
@@ -233,11 +448,358 @@ public:
 
   void push(const T& source) override
   {
-    while (!try_push(source))
+    this->Block(this->m_notFull, [&]() { return try_push(source); });
+  }
+};
+
+namespace detail
+{
+/**
+ * Retry an attempt of a ring buffer without an event to sleep on,
+ * first spinning with a pause, then yielding to other threads
+ *
+ * @param attempt Callable returning true on success
+ */
+template <typename Attempt>
+void Backoff(Attempt&& attempt)
+{
+  const size_t nSpins = 64;
+  for (size_t i = 0; !attempt(); i++)
+  {
+    if (i < nSpins)
+    {
+      sps_cpu_relax();
+    }
+    else
+    {
+      std::this_thread::yield();
+    }
+  }
+}
+} // namespace detail
+
+/*! \brief Single-Reader-Single-Writer Ring Buffer with cached indices
+ *
+ * Variant of @ref SRSWRingBuffer tuned for throughput between two
+ * cores. Each index is on its own cache line together with the copy
+ * of the opposite index cached by its owner, such that the other
+ * index is only loaded, when the cached copy indicates full or empty.
+ * Indices are free-running and wrapped using a mask, so Size must be
+ * a power of two and all Size slots are used.
+ *
+ * Blocking @ref push and @ref pop spin with a pause and then yield,
+ * such that publishing stays free of read-modify-writes.
+ */
+template <typename T, size_t Size, bool = std::is_copy_constructible<T>::value>
+class SRSWCachedRingBuffer
+  : public ISRSWRingBuffer<T, Size, std::is_copy_constructible<T>::value>
+{
+  static_assert(Size > 1 && (Size & (Size - 1)) == 0, "Size must be a power of two");
+
+protected:
+  static constexpr size_t Mask = Size - 1;
+
+  SPS_ALIGNAS(64) T m_Buffer[Size];
+  SPS_ALIGNAS(64) std::atomic<size_t> m_iWrite{ 0 }; ///< Write index, owned by writer
+  size_t m_iReadCached{ 0 };                         ///< Read index seen by writer
+  SPS_ALIGNAS(64) std::atomic<size_t> m_iRead{ 0 };  ///< Read index, owned by reader
+  size_t m_iWriteCached{ 0 };                        ///< Write index seen by reader
+
+  /**
+   * Claim the next slot for writing
+   *
+   * @param iWrite Write index
+   *
+   * @return False if full
+   */
+  bool writable(const size_t iWrite)
+  {
+    if (iWrite - m_iReadCached == Size)
+    {
+      m_iReadCached = m_iRead.load(std::memory_order_acquire);
+      if (iWrite - m_iReadCached == Size)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+public:
+  SRSWCachedRingBuffer() = default;
+
+  size_t size() const { return Size; }
+
+  bool try_push(T&& source) SPS_OVERRIDE
+  {
+    const size_t iWrite = m_iWrite.load(std::memory_order_relaxed);
+    if (!writable(iWrite))
     {
+      return false;
     }
+    m_Buffer[iWrite & Mask] = std::move(source);
+    m_iWrite.store(iWrite + 1, std::memory_order_release);
+    return true;
+  }
+
+  void push(T&& source) SPS_OVERRIDE
+  {
+    detail::Backoff([&]() { return try_push(std::move(source)); });
+  }
+
+  bool try_pop(T& destination) SPS_OVERRIDE
+  {
+    const size_t iRead = m_iRead.load(std::memory_order_relaxed);
+    if (iRead == m_iWriteCached)
+    {
+      m_iWriteCached = m_iWrite.load(std::memory_order_acquire);
+      if (iRead == m_iWriteCached)
+      {
+        return false;
+      }
+    }
+    destination = std::move(m_Buffer[iRead & Mask]);
+    m_iRead.store(iRead + 1, std::memory_order_release);
+    return true;
+  }
+
+  T pop() SPS_OVERRIDE
+  {
+    T ret;
+    detail::Backoff([&]() { return try_pop(ret); });
+    return ret;
   }
 };
+
+template <typename T, size_t Size>
+class SRSWCachedRingBuffer<T, Size, true> : public SRSWCachedRingBuffer<T, Size, false>
+{
+public:
+  using SRSWCachedRingBuffer<T, Size, false>::push;
+  using SRSWCachedRingBuffer<T, Size, false>::try_push;
+
+  bool try_push(const T& source) SPS_OVERRIDE
+  {
+    const size_t iWrite = this->m_iWrite.load(std::memory_order_relaxed);
+    if (!this->writable(iWrite))
+    {
+      return false;
+    }
+    this->m_Buffer[iWrite & this->Mask] = source;
+    this->m_iWrite.store(iWrite + 1, std::memory_order_release);
+    return true;
+  }
+
+  void push(const T& source) SPS_OVERRIDE
+  {
+    detail::Backoff([&]() { return try_push(source); });
+  }
+};
+
+/*! \brief Single-Reader-Single-Writer Ring Buffer sized at runtime
+ *
+ * Variant of @ref SRSWCachedRingBuffer with the capacity chosen at
+ * construction, e.g. from a configuration file. The elements live in
+ * a @ref PageBuffer, which may be backed by huge pages to reduce TLB
+ * misses for large capture rings. The capacity is rounded up to a
+ * power of two. T must be default-constructible.
+ */
+template <typename T>
+class SRSWDynamicRingBuffer
+{
+  static_assert(std::is_nothrow_default_constructible<T>::value,
+    "Elements must be nothrow default-constructible");
+
+public:
+  /**
+   * Ctor
+   *
+   * @param capacity Minimum number of elements
+   * @param huge Huge page backing
+   *
+   * @throws std::invalid_argument if capacity is zero
+   * @throws std::length_error if the capacity rounded up cannot be
+   *         addressed
+   * @throws std::bad_alloc if the memory cannot be mapped
+   */
+  explicit SRSWDynamicRingBuffer(const size_t capacity, const HugePages huge = HugePages::None)
+    : m_nSize{ RoundUpPow2(capacity) }
+    , m_mask{ m_nSize - 1 }
+    , m_memory{ m_nSize * sizeof(T), huge }
+    , m_pBuffer{ static_cast<T*>(m_memory.data()) }
+  {
+    for (size_t i = 0; i < m_nSize; i++)
+    {
+      ::new (static_cast<void*>(m_pBuffer + i)) T();
+    }
+  }
+
+  ~SRSWDynamicRingBuffer()
+  {
+    for (size_t i = 0; i < m_nSize; i++)
+    {
+      m_pBuffer[i].~T();
+    }
+  }
+
+  size_t size() const { return m_nSize; }
+
+  /**
+   * Huge page backing obtained
+   *
+   * @return
+   */
+  HugePages hugePages() const { return m_memory.hugePages(); }
+
+  bool try_push(T&& source) { return emplace(std::move(source)); }
+
+  bool try_push(const T& source) { return emplace(source); }
+
+  void push(T&& source)
+  {
+    detail::Backoff([&]() { return try_push(std::move(source)); });
+  }
+
+  void push(const T& source)
+  {
+    detail::Backoff([&]() { return try_push(source); });
+  }
+
+  bool try_pop(T& destination)
+  {
+    const size_t iRead = m_iRead.load(std::memory_order_relaxed);
+    if (iRead == m_iWriteCached)
+    {
+      m_iWriteCached = m_iWrite.load(std::memory_order_acquire);
+      if (iRead == m_iWriteCached)
+      {
+        return false;
+      }
+    }
+    destination = std::move(m_pBuffer[iRead & m_mask]);
+    m_iRead.store(iRead + 1, std::memory_order_release);
+    return true;
+  }
+
+  T pop()
+  {
+    T ret;
+    detail::Backoff([&]() { return try_pop(ret); });
+    return ret;
+  }
+
+  /**
+   * Push up to n elements, which are moved from, using a single index
+   * update
+   *
+   * @param first Iterator to first element
+   * @param n Number of elements
+   *
+   * @return Number of elements pushed
+   */
+  template <typename InputIt>
+  size_t try_push_n(InputIt first, size_t n)
+  {
+    const size_t iWrite = m_iWrite.load(std::memory_order_relaxed);
+    if (m_nSize - (iWrite - m_iReadCached) < n)
+    {
+      m_iReadCached = m_iRead.load(std::memory_order_acquire);
+    }
+    n = std::min(n, m_nSize - (iWrite - m_iReadCached));
+    for (size_t i = 0; i < n; i++, ++first)
+    {
+      m_pBuffer[(iWrite + i) & m_mask] = std::move(*first);
+    }
+    if (n > 0)
+    {
+      m_iWrite.store(iWrite + n, std::memory_order_release);
+    }
+    return n;
+  }
+
+  /**
+   * Pop up to n elements using a single index update
+   *
+   * @param destination Output iterator
+   * @param n Maximum number of elements
+   *
+   * @return Number of elements popped
+   */
+  template <typename OutputIt>
+  size_t try_pop_n(OutputIt destination, size_t n)
+  {
+    const size_t iRead = m_iRead.load(std::memory_order_relaxed);
+    if (m_iWriteCached - iRead < n)
+    {
+      m_iWriteCached = m_iWrite.load(std::memory_order_acquire);
+    }
+    n = std::min(n, m_iWriteCached - iRead);
+    for (size_t i = 0; i < n; i++, ++destination)
+    {
+      *destination = std::move(m_pBuffer[(iRead + i) & m_mask]);
+    }
+    if (n > 0)
+    {
+      m_iRead.store(iRead + n, std::memory_order_release);
+    }
+    return n;
+  }
+
+private:
+  SRSWDynamicRingBuffer(const SRSWDynamicRingBuffer& rhs) = delete;
+  SRSWDynamicRingBuffer& operator=(const SRSWDynamicRingBuffer& rhs) = delete;
+
+  static size_t RoundUpPow2(const size_t n)
+  {
+    if (n == 0)
+    {
+      throw std::invalid_argument("Capacity must be positive");
+    }
+    // Largest power of two, whose size in bytes fits in a size_t
+    size_t nMaximum = size_t(1) << (std::numeric_limits<size_t>::digits - 1);
+    while (nMaximum > std::numeric_limits<size_t>::max() / sizeof(T))
+    {
+      nMaximum >>= 1;
+    }
+    if (n > nMaximum)
+    {
+      throw std::length_error("Capacity exceeds the address space");
+    }
+    size_t size = 1;
+    while (size < n)
+    {
+      size <<= 1;
+    }
+    return size;
+  }
+
+  template <typename U>
+  bool emplace(U&& source)
+  {
+    const size_t iWrite = m_iWrite.load(std::memory_order_relaxed);
+    if (iWrite - m_iReadCached == m_nSize)
+    {
+      m_iReadCached = m_iRead.load(std::memory_order_acquire);
+      if (iWrite - m_iReadCached == m_nSize)
+      {
+        return false;
+      }
+    }
+    m_pBuffer[iWrite & m_mask] = std::forward<U>(source);
+    m_iWrite.store(iWrite + 1, std::memory_order_release);
+    return true;
+  }
+
+  const size_t m_nSize;                              ///< Capacity
+  const size_t m_mask;                               ///< Capacity - 1
+  PageBuffer m_memory;                               ///< Storage
+  T* const m_pBuffer;                                ///< Elements
+  SPS_ALIGNAS(64) std::atomic<size_t> m_iWrite{ 0 }; ///< Write index, owned by writer
+  size_t m_iReadCached{ 0 };                         ///< Read index seen by writer
+  SPS_ALIGNAS(64) std::atomic<size_t> m_iRead{ 0 };  ///< Read index, owned by reader
+  size_t m_iWriteCached{ 0 };                        ///< Write index seen by reader
+};
+
 } // namespace sps
 
 #ifdef __GNUC__
@@ -0,0 +1,130 @@
+/**
+ * @file   siso_bench.cpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sat Oct 17 23:05:48 2026
+ *
+ * @brief  Throughput and round-trip latency of single-reader-single-writer rings
+ *
+ * Usage: siso_bench [nMessages] [nRoundTrips]
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#include <sps/siso.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+namespace
+{
+
+/// Ring capacity used by all benchmarks
+constexpr size_t RingSize = 1024;
+
+/**
+ * Stream nMessages from a producer thread to the calling thread
+ *
+ * @param name Name printed
+ * @param nMessages
+ */
+template <typename Ring>
+void Throughput(const char* name, const size_t nMessages)
+{
+  auto pRing = std::make_unique<Ring>();
+  const auto start = std::chrono::steady_clock::now();
+  std::thread producer(
+    [&]()
+    {
+      for (std::uint64_t i = 0; i < nMessages; i++)
+      {
+        while (!pRing->try_push(std::uint64_t(i)))
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+  std::uint64_t value = 0;
+  std::uint64_t sum = 0;
+  for (size_t i = 0; i < nMessages; i++)
+  {
+    while (!pRing->try_pop(value))
+    {
+      std::this_thread::yield();
+    }
+    sum += value;
+  }
+  producer.join();
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  printf("%-32s %14.0f msgs/s (checksum %llu)\n", name,
+    static_cast<double>(nMessages) / elapsed.count(), static_cast<unsigned long long>(sum));
+}
+
+/**
+ * Ping-pong a message between the calling thread and an echo thread
+ * through two rings
+ *
+ * @param name Name printed
+ * @param nRoundTrips
+ */
+template <typename Ring>
+void RoundTrip(const char* name, const size_t nRoundTrips)
+{
+  auto pPing = std::make_unique<Ring>();
+  auto pPong = std::make_unique<Ring>();
+  std::thread echo(
+    [&]()
+    {
+      std::uint64_t value = 0;
+      for (size_t i = 0; i < nRoundTrips; i++)
+      {
+        while (!pPing->try_pop(value))
+        {
+          std::this_thread::yield();
+        }
+        while (!pPong->try_push(std::uint64_t(value)))
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+  const auto start = std::chrono::steady_clock::now();
+  std::uint64_t value = 0;
+  for (size_t i = 0; i < nRoundTrips; i++)
+  {
+    while (!pPing->try_push(std::uint64_t(i)))
+    {
+      std::this_thread::yield();
+    }
+    while (!pPong->try_pop(value))
+    {
+      std::this_thread::yield();
+    }
+  }
+  const std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+  echo.join();
+  printf("%-32s %14.0f ns/round-trip\n", name, elapsed.count() / static_cast<double>(nRoundTrips));
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  const size_t nMessages = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 10000000;
+  const size_t nRoundTrips = argc > 2 ? static_cast<size_t>(atoi(argv[2])) : 100000;
+
+  printf("messages: %zu, round-trips: %zu, ring size: %zu\n", nMessages, nRoundTrips, RingSize);
+
+  using Plain = sps::SRSWRingBuffer<std::uint64_t, RingSize>;
+  using Cached = sps::SRSWCachedRingBuffer<std::uint64_t, RingSize>;
+
+  Throughput<Plain>("SRSWRingBuffer", nMessages);
+  Throughput<Cached>("SRSWCachedRingBuffer", nMessages);
+  RoundTrip<Plain>("SRSWRingBuffer", nRoundTrips);
+  RoundTrip<Cached>("SRSWCachedRingBuffer", nRoundTrips);
+  return 0;
+}
@@ -15,9 +15,14 @@
 
 #include <chrono>
 #include <cstdio>
+#include <limits>
 #include <mutex>
+#include <numeric>
 #include <random>
+#include <stdexcept>
 #include <thread>
+#include <time.h>
+#include <vector>
 
 #include <sps/siso.hpp>
 
@@ -74,6 +79,203 @@ TEST(siso_test, siso_circular_buffer)
   EXPECT_EQ(1, 1);
 }
 
+TEST(siso_test, bulk)
+{
+  sps::SRSWRingBuffer<int, 8> queue;
+  std::vector<int> input(10);
+  std::iota(input.begin(), input.end(), 0);
+  std::vector<int> output(10, -1);
+
+  // Capacity is Size - 1
+  EXPECT_EQ(queue.try_push_n(input.begin(), 10), 7u);
+  EXPECT_EQ(queue.try_pop_n(output.begin(), 5), 5u);
+  // Wraps around the end
+  EXPECT_EQ(queue.try_push_n(input.begin() + 7, 3), 3u);
+  EXPECT_EQ(queue.try_pop_n(output.begin() + 5, 10), 5u);
+  EXPECT_EQ(queue.try_pop_n(output.begin(), 1), 0u);
+  EXPECT_EQ(output, input);
+}
+
+TEST(siso_test, reserve_commit)
+{
+  sps::SRSWRingBuffer<int, 8> queue;
+  auto span = queue.write_reserve(5);
+  ASSERT_EQ(span.size, 5u);
+  for (size_t i = 0; i < span.size; i++)
+  {
+    span.data[i] = int(i);
+  }
+  queue.write_commit(span.size);
+
+  span = queue.read_reserve(3);
+  ASSERT_EQ(span.size, 3u);
+  EXPECT_EQ(span.data[2], 2);
+  queue.read_commit(3);
+
+  // Contiguous slots end at the end of the buffer
+  span = queue.write_reserve(8);
+  EXPECT_EQ(span.size, 3u);
+  queue.write_commit(span.size);
+  span = queue.write_reserve(8);
+  EXPECT_EQ(span.size, 2u);
+  queue.write_commit(span.size);
+  EXPECT_EQ(queue.write_reserve(8).size, 0u);
+
+  span = queue.read_reserve(8);
+  EXPECT_EQ(span.size, 5u);
+  EXPECT_EQ(span.data[0], 3);
+  queue.read_commit(span.size);
+  EXPECT_EQ(queue.read_reserve(8).size, 2u);
+}
+
+/**
+ * Test streaming blocks between two threads. Elements arrive in order.
+ *
+ */
+TEST(siso_test, bulk_threads)
+{
+  sps::SRSWRingBuffer<int, 64> queue;
+  const int nElements = 100000;
+  std::thread producer(
+    [&queue]()
+    {
+      std::vector<int> block(16);
+      int next = 0;
+      while (next < nElements)
+      {
+        const size_t nBlock = std::min<size_t>(block.size(), size_t(nElements - next));
+        std::iota(block.begin(), block.begin() + nBlock, next);
+        size_t nPushed = 0;
+        while (nPushed < nBlock)
+        {
+          const size_t n = queue.try_push_n(block.begin() + nPushed, nBlock - nPushed);
+          if (n == 0)
+          {
+            std::this_thread::yield();
+          }
+          nPushed += n;
+        }
+        next += int(nBlock);
+      }
+    });
+
+  int expected = 0;
+  bool ordered = true;
+  while (expected < nElements)
+  {
+    auto span = queue.read_reserve(32);
+    if (span.size == 0)
+    {
+      std::this_thread::yield();
+    }
+    for (size_t i = 0; i < span.size; i++)
+    {
+      ordered = ordered && (span.data[i] == expected++);
+    }
+    queue.read_commit(span.size);
+  }
+  producer.join();
+  EXPECT_TRUE(ordered);
+}
+
+TEST(siso_test, cached_ring_buffer)
+{
+  sps::SRSWCachedRingBuffer<int, 4> queue;
+  // All slots are used
+  for (int i = 0; i < 4; i++)
+  {
+    EXPECT_TRUE(queue.try_push(int(i)));
+  }
+  EXPECT_FALSE(queue.try_push(4));
+  int value = -1;
+  EXPECT_TRUE(queue.try_pop(value));
+  EXPECT_EQ(value, 0);
+  EXPECT_TRUE(queue.try_push(4));
+
+  const int nElements = 100000;
+  std::thread producer(
+    [&queue]()
+    {
+      for (int i = 5; i < nElements; i++)
+      {
+        while (!queue.try_push(int(i)))
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+  bool ordered = true;
+  for (int expected = 1; expected < nElements; expected++)
+  {
+    while (!queue.try_pop(value))
+    {
+      std::this_thread::yield();
+    }
+    ordered = ordered && value == expected;
+  }
+  producer.join();
+  EXPECT_TRUE(ordered);
+}
+
+TEST(siso_test, dynamic_ring_buffer)
+{
+  EXPECT_THROW(sps::SRSWDynamicRingBuffer<int>(0), std::invalid_argument);
+  // Rounded up, the capacity would overflow, or its size in bytes
+  const size_t nMaximum = std::numeric_limits<size_t>::max();
+  EXPECT_THROW(sps::SRSWDynamicRingBuffer<int>{ nMaximum }, std::length_error);
+  EXPECT_THROW(
+    sps::SRSWDynamicRingBuffer<int>(nMaximum / sizeof(int) / 2 + 2), std::length_error);
+
+  sps::SRSWDynamicRingBuffer<int> queue(5);
+  EXPECT_EQ(queue.size(), 8u);
+  std::vector<int> input(10);
+  std::iota(input.begin(), input.end(), 0);
+  std::vector<int> output(10, -1);
+  EXPECT_EQ(queue.try_push_n(input.begin(), 10), 8u);
+  EXPECT_FALSE(queue.try_push(8));
+  EXPECT_EQ(queue.try_pop_n(output.begin(), 6), 6u);
+  EXPECT_TRUE(queue.try_push(input[8]));
+  EXPECT_TRUE(queue.try_push(9));
+  EXPECT_EQ(queue.try_pop_n(output.begin() + 6, 10), 4u);
+  EXPECT_EQ(output, input);
+
+  // Huge pages are used, when available
+  for (const auto huge : { sps::HugePages::Transparent, sps::HugePages::Explicit })
+  {
+    sps::SRSWDynamicRingBuffer<float> large(size_t(1) << 20, huge);
+    EXPECT_EQ(large.size(), size_t(1) << 20);
+    EXPECT_TRUE(large.try_push(1.0f));
+    EXPECT_EQ(large.pop(), 1.0f);
+  }
+}
+
+/**
+ * Test that a blocked reader sleeps rather than spins. The reader
+ * consumes far less CPU time than the time it waits.
+ *
+ */
+TEST(siso_test, blocking_pop_sleeps)
+{
+  sps::SRSWRingBuffer<int, 4> queue;
+  double cpuSeconds = 0.0;
+  int value = 0;
+  std::thread reader(
+    [&]()
+    {
+      value = queue.pop();
+#if defined(__linux__)
+      timespec ts;
+      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+      cpuSeconds = double(ts.tv_sec) + 1e-9 * double(ts.tv_nsec);
+#endif
+    });
+  std::this_thread::sleep_for(std::chrono::milliseconds{ 200 });
+  queue.push(42);
+  reader.join();
+  EXPECT_EQ(value, 42);
+  EXPECT_LT(cpuSeconds, 0.1);
+}
+
 int main(int argc, char* argv[])
 {
 
@@ -54,8 +54,15 @@
 #endif
 
 #include <float.h>
+#include <stdio.h>
 
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
 #include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 STATIC_INLINE_BEGIN int setcpuid(int cpu_id)
 {
@@ -137,6 +144,22 @@ STATIC_INLINE_BEGIN uint64_t sps_rdtsc()
 #endif
 }
 
+/**
+ * Hint to the processor, that the calling thread is busy-waiting. This
+ * reduces the power used and the penalty of leaving the loop and
+ * leaves resources to a sibling hyper-thread.
+ */
+STATIC_INLINE_BEGIN void sps_cpu_relax()
+{
+#if defined(_WIN32)
+  YieldProcessor();
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_ia32_pause();
+#elif defined(__GNUC__) && (defined(__aarch64__) || defined(__arm__))
+  __asm__ __volatile__("yield");
+#endif
+}
+
 STATIC_INLINE_BEGIN int getncpus()
 {
   int nproc = 0;
@@ -157,6 +180,230 @@ STATIC_INLINE_BEGIN int getncpus()
 namespace sps
 {
 
+//! Logical CPU
+/*!
+  Location of a logical CPU within the topology of the machine.
+*/
+struct CpuInfo
+{
+  int cpu;     ///< Logical CPU index
+  int package; ///< Physical package (socket)
+  int cache;   ///< Last-level cache domain
+  int core;    ///< Core within package
+};
+
+//! CPU affinity policy
+/*!
+  Placement of threads, e.g. the workers of a thread pool, on the
+  logical CPUs available to the process.
+*/
+enum class AffinityPolicy
+{
+  None,          ///< Threads are not pinned
+  Compact,       ///< Fill one socket at a time, physical cores before SMT siblings
+  ScatterSocket, ///< Consecutive threads on different sockets
+  ScatterCache,  ///< Consecutive threads on different last-level caches
+  Explicit,      ///< Threads pinned to an explicit list of CPUs
+};
+
+namespace detail
+{
+#if defined(__linux__)
+/**
+ * Read an integer from a sysfs attribute
+ *
+ * @param path
+ * @param fallback Value returned if attribute cannot be read
+ *
+ * @return
+ */
+inline int SysfsIntGet(const char* path, const int fallback)
+{
+  int value = fallback;
+  FILE* file = fopen(path, "r");
+  if (file)
+  {
+    if (fscanf(file, "%d", &value) != 1)
+    {
+      value = fallback;
+    }
+    fclose(file);
+  }
+  return value;
+}
+#endif
+} // namespace detail
+
+/**
+ * Topology of the logical CPUs available to the process, i.e. the
+ * CPUs of its affinity mask. On Linux, sockets, cores and last-level
+ * caches are read from sysfs. Elsewhere, all CPUs are reported on a
+ * single socket sharing a single cache.
+ *
+ * @return CPUs ordered by index
+ */
+inline std::vector<CpuInfo> CpuTopologyGet()
+{
+  std::vector<CpuInfo> cpus;
+#if defined(__linux__)
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  if (sched_getaffinity(0, sizeof(cpu_set_t), &cpuset) == 0)
+  {
+    const char* root = "/sys/devices/system/cpu";
+    char path[128];
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+      if (!CPU_ISSET(cpu, &cpuset))
+      {
+        continue;
+      }
+      CpuInfo info{ cpu, 0, 0, cpu };
+      snprintf(path, sizeof(path), "%s/cpu%d/topology/physical_package_id", root, cpu);
+      info.package = detail::SysfsIntGet(path, 0);
+      snprintf(path, sizeof(path), "%s/cpu%d/topology/core_id", root, cpu);
+      info.core = detail::SysfsIntGet(path, cpu);
+
+      // The last-level cache is the cache with the highest level
+      info.cache = info.package;
+      int maxLevel = 0;
+      for (int index = 0; index < 8; ++index)
+      {
+        snprintf(path, sizeof(path), "%s/cpu%d/cache/index%d/level", root, cpu, index);
+        const int level = detail::SysfsIntGet(path, -1);
+        if (level < 0)
+        {
+          break;
+        }
+        snprintf(path, sizeof(path), "%s/cpu%d/cache/index%d/id", root, cpu, index);
+        const int id = detail::SysfsIntGet(path, -1);
+        if (level > maxLevel && id >= 0)
+        {
+          maxLevel = level;
+          info.cache = id;
+        }
+      }
+      cpus.push_back(info);
+    }
+  }
+#endif
+  if (cpus.empty())
+  {
+    const int nCpus = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    for (int cpu = 0; cpu < nCpus; ++cpu)
+    {
+      cpus.push_back(CpuInfo{ cpu, 0, 0, cpu });
+    }
+  }
+  return cpus;
+}
+
+/**
+ * CPUs in the order threads should be placed according to a
+ * policy. Thread i is pinned to element i modulo the number of
+ * elements.
+ *
+ * @param policy
+ * @param cpus CPUs used with AffinityPolicy::Explicit
+ * @param excluded CPUs never used, e.g. reserved for other threads
+ *
+ * @return CPUs, empty if threads should not be pinned
+ *
+ * @throws std::invalid_argument if the policy pins threads, but all
+ *         CPUs are excluded or no CPU is listed
+ */
+inline std::vector<int> AffinityCpusGet(const AffinityPolicy policy,
+  const std::vector<int>& cpus = std::vector<int>(),
+  const std::vector<int>& excluded = std::vector<int>())
+{
+  const auto isExcluded = [&excluded](const int cpu) -> bool
+  { return std::find(excluded.begin(), excluded.end(), cpu) != excluded.end(); };
+
+  std::vector<int> result;
+  if (policy == AffinityPolicy::None)
+  {
+    return result;
+  }
+  if (policy == AffinityPolicy::Explicit)
+  {
+    std::copy_if(cpus.begin(), cpus.end(), std::back_inserter(result),
+      [&isExcluded](const int cpu) -> bool { return !isExcluded(cpu); });
+    if (result.empty())
+    {
+      throw std::invalid_argument("No CPUs to pin threads to");
+    }
+    return result;
+  }
+
+  std::vector<CpuInfo> topology = CpuTopologyGet();
+  topology.erase(std::remove_if(topology.begin(), topology.end(),
+                   [&isExcluded](const CpuInfo& info) -> bool { return isExcluded(info.cpu); }),
+    topology.end());
+  if (topology.empty())
+  {
+    throw std::invalid_argument("No CPUs to pin threads to");
+  }
+
+  // Compact order: socket, cache, SMT sibling rank and core
+  struct Placement
+  {
+    CpuInfo info; ///< CPU
+    int sibling;  ///< Rank among SMT siblings of the core
+  };
+  std::vector<Placement> placements;
+  for (const CpuInfo& info : topology)
+  {
+    const int sibling = static_cast<int>(std::count_if(placements.begin(), placements.end(),
+      [&info](const Placement& other) -> bool
+      { return other.info.package == info.package && other.info.core == info.core; }));
+    placements.push_back(Placement{ info, sibling });
+  }
+  std::stable_sort(placements.begin(), placements.end(),
+    [](const Placement& a, const Placement& b) -> bool
+    {
+      return std::make_tuple(a.info.package, a.info.cache, a.sibling, a.info.core) <
+        std::make_tuple(b.info.package, b.info.cache, b.sibling, b.info.core);
+    });
+
+  if (policy == AffinityPolicy::Compact)
+  {
+    for (const Placement& placement : placements)
+    {
+      result.push_back(placement.info.cpu);
+    }
+    return result;
+  }
+
+  // Scatter: round-robin over domains, each in compact order
+  const bool bySocket = policy == AffinityPolicy::ScatterSocket;
+  std::vector<std::vector<int>> domains;
+  std::vector<std::pair<int, int>> keys;
+  for (const Placement& placement : placements)
+  {
+    const std::pair<int, int> key{ placement.info.package,
+      bySocket ? 0 : placement.info.cache };
+    const std::size_t iDomain =
+      static_cast<std::size_t>(std::find(keys.begin(), keys.end(), key) - keys.begin());
+    if (iDomain == keys.size())
+    {
+      keys.push_back(key);
+      domains.emplace_back();
+    }
+    domains[iDomain].push_back(placement.info.cpu);
+  }
+  for (std::size_t i = 0; result.size() < placements.size(); ++i)
+  {
+    for (const auto& domain : domains)
+    {
+      if (i < domain.size())
+      {
+        result.push_back(domain[i]);
+      }
+    }
+  }
+  return result;
+}
+
 #if defined(HAVE_PTHREAD_H)
 template <class T, void* (T::*thread_func)(void*)>
 #elif defined(_WIN32)
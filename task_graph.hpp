@@ -0,0 +1,289 @@
+/**
+ * @file   task_graph.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sat Oct 17 19:21:08 2026
+ *
+ * @brief  Directed acyclic graph of tasks executed on sps::ThreadPool
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#pragma once
+
+#include <sps/cenv.h>
+#include <sps/threadpool.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace sps
+{
+
+//! Task graph
+/*!
+  Directed acyclic graph of tasks executed on a @ref ThreadPool. A
+  task is posted to the pool as soon as all tasks it depends on have
+  completed, so no thread blocks waiting for intermediate results.
+
+  Example, a processing chain with two independent stages
+
+  \code
+  sps::TaskGraph graph(pool);
+  auto filter = graph.add([&]() { Filter(); });
+  auto fft = graph.add([&]() { FFT(); }, { filter });
+  auto envelope = graph.add([&]() { Envelope(); }, { fft });
+  auto overlay = graph.add([&]() { Overlay(); }, { filter });
+  graph.add([&]() { ScanConvert(); }, { envelope, overlay });
+  graph.run().Get();
+  \endcode
+*/
+class TaskGraph
+{
+public:
+  /// Node identifier
+  using Node = std::size_t;
+
+  /**
+   * Constructor
+   *
+   * @param pool Pool executing the tasks
+   */
+  explicit TaskGraph(ThreadPool& pool)
+    : m_pool(pool)
+    , m_nodes{}
+  {
+  }
+
+  /**
+   * Add a task
+   *
+   * @param func Task, void func()
+   * @param dependencies Tasks, which must complete before func is called
+   *
+   * @return Node of task
+   */
+  template <typename Func>
+  Node add(Func&& func, std::initializer_list<Node> dependencies = {})
+  {
+    const Node node = m_nodes.size();
+    m_nodes.push_back(NodeData{ std::function<void()>(std::forward<Func>(func)), {}, 0 });
+    for (const Node dependency : dependencies)
+    {
+      precede(dependency, node);
+    }
+    return node;
+  }
+
+  /**
+   * Add dependency, such that before completes before after is started
+   *
+   * @param before
+   * @param after
+   */
+  void precede(const Node before, const Node after)
+  {
+    if (before >= m_nodes.size() || after >= m_nodes.size() || before == after)
+    {
+      throw std::out_of_range("Invalid task graph node");
+    }
+    m_nodes[before].successors.push_back(after);
+    m_nodes[after].nDependencies++;
+  }
+
+  /**
+   * Number of tasks
+   *
+   * @return
+   */
+  std::size_t size() const { return m_nodes.size(); }
+
+  /**
+   * Execute the graph. Tasks without dependencies are posted
+   * immediately. The graph may be modified or executed again, while
+   * executing, since the execution refers to a copy. If a task
+   * throws, tasks not yet started are skipped and the first exception
+   * is rethrown by the future returned.
+   *
+   * @return Future completing when all tasks have completed
+   */
+  ThreadPool::TaskFuture<void> run() const
+  {
+    if (!acyclic())
+    {
+      throw std::logic_error("Task graph contains a cycle");
+    }
+
+    auto pOutcome = std::make_shared<Outcome>();
+    auto result = m_pool.package(
+      [pOutcome]() -> void
+      {
+        if (pOutcome->exception)
+        {
+          std::rethrow_exception(pOutcome->exception);
+        }
+      });
+
+    if (m_nodes.empty())
+    {
+      m_pool.enqueue(std::move(result.first));
+      return std::move(result.second);
+    }
+    auto pExecution = std::make_shared<Execution>(m_pool, m_nodes, pOutcome);
+    pExecution->pResult = std::move(result.first);
+    for (Node node = 0; node < m_nodes.size(); ++node)
+    {
+      if (m_nodes[node].nDependencies == 0)
+      {
+        Post(pExecution, node);
+      }
+    }
+    return std::move(result.second);
+  }
+
+private:
+  //! Node of graph
+  struct NodeData
+  {
+    std::function<void()> func;   ///< Task
+    std::vector<Node> successors; ///< Tasks depending on this
+    std::size_t nDependencies;    ///< Number of tasks this depends on
+  };
+
+  //! Outcome of execution, shared with the task completing it
+  struct Outcome
+  {
+    std::mutex mutex;             ///< Mutex for locking
+    std::exception_ptr exception; ///< First exception thrown
+  };
+
+  //! State of an execution of the graph
+  struct Execution
+  {
+    Execution(ThreadPool& executor, const std::vector<NodeData>& graph,
+      std::shared_ptr<Outcome> pShared)
+      : pool(executor)
+      , nodes(graph)
+      , nPending(new std::atomic<std::size_t>[graph.size()])
+      , nRemaining{ graph.size() }
+      , failed{ false }
+      , pOutcome(std::move(pShared))
+      , pResult{}
+    {
+      for (std::size_t i = 0; i < graph.size(); ++i)
+      {
+        nPending[i] = graph[i].nDependencies;
+      }
+    }
+
+    ThreadPool& pool;                                     ///< Pool executing tasks
+    const std::vector<NodeData> nodes;                    ///< Copy of graph
+    std::unique_ptr<std::atomic<std::size_t>[]> nPending; ///< Dependencies not completed
+    std::atomic<std::size_t> nRemaining;                  ///< Tasks not completed
+    std::atomic<bool> failed;                             ///< A task has thrown
+    std::shared_ptr<Outcome> pOutcome;                    ///< Outcome
+    ThreadPool::TaskPtr pResult;                          ///< Task completing the future
+  };
+
+  /**
+   * Post a task, which is ready, to the pool
+   *
+   * @param pExecution
+   * @param node
+   */
+  static void Post(const std::shared_ptr<Execution>& pExecution, const Node node)
+  {
+    pExecution->pool.post([pExecution, node]() -> void { Execute(pExecution, node); });
+  }
+
+  /**
+   * Execute a task and post its successors, which become ready
+   *
+   * @param pExecution
+   * @param node
+   */
+  static void Execute(const std::shared_ptr<Execution>& pExecution, const Node node)
+  {
+    Execution& execution = *pExecution;
+    const NodeData& data = execution.nodes[node];
+    if (!execution.failed.load(std::memory_order_relaxed))
+    {
+      try
+      {
+        data.func();
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> guard{ execution.pOutcome->mutex };
+        if (!execution.pOutcome->exception)
+        {
+          execution.pOutcome->exception = std::current_exception();
+        }
+        execution.failed = true;
+      }
+    }
+    for (const Node successor : data.successors)
+    {
+      if (execution.nPending[successor].fetch_sub(1) == 1)
+      {
+        Post(pExecution, successor);
+      }
+    }
+    if (execution.nRemaining.fetch_sub(1) == 1)
+    {
+      execution.pool.enqueue(std::move(execution.pResult));
+    }
+  }
+
+  /**
+   * Check that the graph has no cycles (Kahn's algorithm)
+   *
+   * @return
+   */
+  bool acyclic() const
+  {
+    std::vector<std::size_t> nPending(m_nodes.size());
+    std::vector<Node> ready;
+    for (Node node = 0; node < m_nodes.size(); ++node)
+    {
+      nPending[node] = m_nodes[node].nDependencies;
+      if (nPending[node] == 0)
+      {
+        ready.push_back(node);
+      }
+    }
+    std::size_t nVisited = 0;
+    while (!ready.empty())
+    {
+      const Node node = ready.back();
+      ready.pop_back();
+      nVisited++;
+      for (const Node successor : m_nodes[node].successors)
+      {
+        if (--nPending[successor] == 0)
+        {
+          ready.push_back(successor);
+        }
+      }
+    }
+    return nVisited == m_nodes.size();
+  }
+
+  ThreadPool& m_pool;            ///< Pool executing tasks
+  std::vector<NodeData> m_nodes; ///< Nodes of graph
+};
+
+} // namespace sps
+
+/* Local variables: */
+/* indent-tabs-mode: nil */
+/* tab-width: 2 */
+/* c-basic-offset: 2 */
+/* End: */
@@ -0,0 +1,108 @@
+/**
+ * @file   task_graph_test.cpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sat Oct 17 19:58:44 2026
+ *
+ * @brief  Tests of sps::TaskGraph
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#include <gtest/gtest.h>
+#include <sps/cenv.h>
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <sps/task_graph.hpp>
+#include <sps/threadpool.hpp>
+
+TEST(task_graph_test, diamond)
+{
+  sps::ThreadPool pool(3);
+  sps::TaskGraph graph(pool);
+  std::mutex mutex;
+  std::vector<int> order;
+
+  const auto record = [&](int value)
+  {
+    return [&, value]() -> void
+    {
+      std::lock_guard<std::mutex> guard{ mutex };
+      order.push_back(value);
+    };
+  };
+
+  const auto first = graph.add(record(0));
+  const auto left = graph.add(record(1), { first });
+  const auto right = graph.add(record(1), { first });
+  graph.add(record(2), { left, right });
+  EXPECT_EQ(graph.size(), 4u);
+
+  for (int i = 0; i < 10; i++)
+  {
+    order.clear();
+    graph.run().Get();
+    EXPECT_EQ(order, std::vector<int>({ 0, 1, 1, 2 }));
+  }
+}
+
+TEST(task_graph_test, exception)
+{
+  sps::ThreadPool pool(2);
+  sps::TaskGraph graph(pool);
+  std::atomic<int> nExecuted{ 0 };
+
+  const auto first = graph.add([]() -> void { throw std::runtime_error("failure"); });
+  graph.add([&]() -> void { nExecuted++; }, { first });
+  EXPECT_THROW(graph.run().Get(), std::runtime_error);
+  EXPECT_EQ(nExecuted.load(), 0);
+}
+
+TEST(task_graph_test, invalid)
+{
+  sps::ThreadPool pool(1);
+  sps::TaskGraph graph(pool);
+
+  // Empty graph completes
+  graph.run().Get();
+
+  const auto a = graph.add([]() -> void {});
+  const auto b = graph.add([]() -> void {}, { a });
+  EXPECT_THROW(graph.precede(a, 2), std::out_of_range);
+  graph.precede(b, a);
+  EXPECT_THROW(graph.run(), std::logic_error);
+}
+
+/**
+ * Test that a graph executed from a task of a one-thread pool
+ * completes.
+ *
+ */
+TEST(task_graph_test, nested)
+{
+  sps::ThreadPool pool(1);
+  std::atomic<int> nExecuted{ 0 };
+
+  auto future = pool.submit(
+    [&]() -> void
+    {
+      sps::TaskGraph graph(pool);
+      sps::TaskGraph::Node previous = graph.add([&]() -> void { nExecuted++; });
+      for (int i = 1; i < 10; i++)
+      {
+        previous = graph.add([&]() -> void { nExecuted++; }, { previous });
+      }
+      graph.run().Get();
+    });
+  future.Get();
+  EXPECT_EQ(nExecuted.load(), 10);
+}
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -34,6 +34,50 @@ public:
     return 0;
   }
 
+  int SubmitJobs(SimpleCallback* pCallbacks, void** ppUserData, std::size_t nJobs) override
+  {
+    if (nJobs > 0 && (!pCallbacks || !ppUserData))
+    {
+      return -1;
+    }
+    this->submitBulk(
+      nJobs, [pCallbacks, ppUserData](std::size_t i) -> void { (*pCallbacks[i])(ppUserData[i]); });
+    return 0;
+  }
+
+  int Resize(std::size_t nThreads) override
+  {
+    try
+    {
+      this->resize(nThreads);
+    }
+    catch (const std::exception&)
+    {
+      return -1;
+    }
+    return 0;
+  }
+
+  int StatisticsGet(ThreadPoolStatistics* pStatistics) override
+  {
+    if (!pStatistics)
+    {
+      return -1;
+    }
+    *pStatistics = this->statistics();
+    return 0;
+  }
+
+  int WorkerStatisticsGet(std::size_t iWorker, ThreadPoolWorkerStatistics* pStatistics) override
+  {
+    if (!pStatistics || iWorker >= this->size())
+    {
+      return -1;
+    }
+    *pStatistics = this->workerStatistics(iWorker);
+    return 0;
+  }
+
   ~ThreadPoolImpl() override
   {
     // No additional cleanup is needed
@@ -42,7 +86,13 @@ public:
 
 int ThreadPoolCreate(IThreadPool** ppObj)
 {
-  *ppObj = reinterpret_cast<IThreadPool*>(new ThreadPoolImpl(2));
+  *ppObj = static_cast<IThreadPool*>(new ThreadPoolImpl());
+  return 0;
+}
+
+int ThreadPoolCreate(IThreadPool** ppObj, std::size_t nThreads)
+{
+  *ppObj = static_cast<IThreadPool*>(new ThreadPoolImpl(nThreads));
   return 0;
 }
 int ThreadPoolDestroy(IThreadPool* pObj)
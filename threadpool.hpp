@@ -15,16 +15,33 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <exception>
 #include <functional>
 #include <future>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
 #include <thread>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#if defined(SPS_COROUTINES)
+#include <coroutine>
+#endif
+
+#include <sps/cancellation.hpp>
+#include <sps/if_threadpool.hpp>
 #include <sps/mimo.hpp>
+#include <sps/sps_threads.hpp>
 
 // TESTING
 // #include <iostream>
@@ -36,6 +53,86 @@
 namespace sps
 {
 
+//! Scheduling policy
+/*!
+  Policy used by the workers of a @ref ThreadPool for acquiring tasks.
+ */
+enum class SchedulingPolicy
+{
+  SharedQueue,  ///< All workers pop from a single shared queue
+  WorkStealing, ///< Per-worker deques, idle workers steal from others
+};
+
+//! Idle policy
+/*!
+  Policy used by a worker of a @ref ThreadPool, which finds no task.
+  Parking and waking a worker costs a system call on both sides and a
+  scheduler round-trip, which may dominate the latency of short tasks
+  arriving in bursts. Spinning trades CPU time for latency.
+ */
+enum class IdlePolicy
+{
+  Park,     ///< Park on a condition variable immediately
+  Spin,     ///< Spin, then yield, then park
+  Adaptive, ///< Like Spin, the spin budget of a worker adapts to arrivals
+};
+
+//! Task priority
+/*!
+  Priority class of a task submitted to a @ref ThreadPool. Tasks of a
+  higher class are dequeued first, but a class skipped too often is
+  served ahead of higher classes, see @ref ThreadPool::StarvationLimit.
+ */
+enum class TaskPriority
+{
+  High,   ///< Latency-critical work
+  Normal, ///< Default
+  Low,    ///< Background work
+};
+
+//! Queue statistics of a task priority class
+struct TaskClassStatistics
+{
+  std::size_t depth;       ///< Tasks queued, not yet dequeued
+  std::uint64_t nExecuted; ///< Tasks dequeued
+  double meanWait;         ///< Mean time from submission to dequeue [s], sampled
+  double maxWait;          ///< Longest time from submission to dequeue [s], sampled
+};
+
+//! Thread pool options
+/*!
+  Options used for constructing a @ref ThreadPool.
+*/
+struct ThreadPoolOptions
+{
+  /// Number of worker threads
+  std::size_t nThreads{ std::max<unsigned int>(std::thread::hardware_concurrency(), 2u) - 1u };
+  /// Scheduling policy
+  SchedulingPolicy scheduling{ SchedulingPolicy::SharedQueue };
+  /// Idle policy, spinning is disabled on a single CPU
+  IdlePolicy idle{ IdlePolicy::Park };
+  /// Spin budget in pause instructions, the maximum using IdlePolicy::Adaptive
+  std::uint32_t nSpins{ 2048 };
+  /// Number of yields after spinning, before parking
+  std::uint32_t nYields{ 8 };
+  /// Placement of workers, see @ref AffinityCpusGet
+  AffinityPolicy affinity{ AffinityPolicy::None };
+  /// CPUs used with AffinityPolicy::Explicit
+  std::vector<int> cpus{};
+  /// CPUs never used by workers, e.g. reserved for acquisition threads
+  std::vector<int> excludedCpus{};
+  /// Upper limit for @ref ThreadPool::resize, at least nThreads and
+  /// the hardware concurrency if zero
+  std::size_t maxThreads{ 0 };
+};
+
+#if defined(SPS_USE_BOUNDED_QUEUE) && !defined(SPS_BOUNDED_QUEUE_SIZE)
+/// Capacity of the work queue, when using sps::MRMWBoundedQueue
+#define SPS_BOUNDED_QUEUE_SIZE 4096
+#endif
+
+class TaskGraph;
+
 class ThreadPool
 {
 private:
@@ -43,6 +140,10 @@ private:
 #ifdef SPS_USE_INTEL_TBB_QUEUE
   // If Intel's TBB is available, we can use their queue primitive
   using QueueImpl = tbb::concurrent_queue<T>;
+#elif defined(SPS_USE_BOUNDED_QUEUE)
+  // Lock-free bounded queue. While it is full, external submitters
+  // block and workers push onto an unbounded overflow queue
+  using QueueImpl = sps::MRMWBoundedQueue<T, SPS_BOUNDED_QUEUE_SIZE>;
 #else
   using QueueImpl = sps::MRMWQueue<T>;
 #endif
@@ -54,6 +155,10 @@ private:
   class IThreadTask
   {
   public:
+    /// Scheduling state, assigned by the pool when enqueued
+    std::chrono::steady_clock::time_point m_enqueued{}; ///< Time of submission
+    TaskPriority m_priority{ TaskPriority::Normal };    ///< Priority class
+
     virtual ~IThreadTask() = default;
     IThreadTask(IThreadTask&& other) = default;
     IThreadTask& operator=(IThreadTask&& other) = default;
@@ -64,6 +169,13 @@ private:
      */
     virtual void Execute() = 0;
 
+    /**
+     * Release the task, when it is dequeued and executed or when it
+     * is discarded. Tasks not allocated using new must override this.
+     *
+     */
+    virtual void Release() { delete this; }
+
   protected:
     IThreadTask() = default;
 
@@ -115,186 +227,2493 @@ private:
     Func m_func;
   };
 
-public:
-  //! Task future
+  //! Deleter for tasks
+  struct TaskDeleter
+  {
+    void operator()(IThreadTask* pTask) const { pTask->Release(); }
+  };
+
+  /// Owning pointer to task as stored in the queues
+  using TaskPtr = std::unique_ptr<IThreadTask, TaskDeleter>;
+
+  //! Task state
   /*!
-    Simple wrapper around std::future. The behavoir of futures
-    returned from std::async is added. The object will block and wait
-    for completion unless, detach is called.
+    Completion state shared by a task created using @ref submit and
+    its @ref TaskFuture. Callbacks registered before the task
+    completes are executed by the thread completing it, callbacks
+    registered afterwards are executed immediately. Callbacks must be
+    short, e.g. enqueue a continuation. If the task is discarded
+    without being executed, callbacks are released unexecuted.
   */
-  template <typename T>
-  class TaskFuture
+  class TaskState
   {
   public:
-    explicit TaskFuture(std::future<T>&& future)
-      : m_future{ std::move(future) }
-      , m_detach(false)
-    {
-    }
-
-    TaskFuture(TaskFuture&& other) = default;
-    TaskFuture& operator=(TaskFuture&& other) = default;
+    TaskState() = default;
 
-    ~TaskFuture()
+    /**
+     * Register a callback
+     *
+     * @param pCallback
+     */
+    void callbackAdd(TaskPtr&& pCallback)
     {
-      if (m_future.valid())
       {
-        if (!m_detach)
+        std::lock_guard<std::mutex> guard{ m_mutex };
+        if (!m_done)
         {
-          // Block if not detached
-          m_future.get();
+          m_callbacks.push_back(std::move(pCallback));
+          return;
         }
       }
+      pCallback->Execute();
     }
 
     /**
-     * Get the std::future to wait for. Note, deduced return types
-     * only available using c++14
-     *
-     * @return
-     */
-    auto Get() { return m_future.get(); }
-
-    /**
-     * Detach future from from processing
+     * Mark task as completed and execute or release callbacks
      *
+     * @param executed True if the task was executed, false if discarded
      */
-    void Detach() { m_detach = true; }
+    void complete(const bool executed)
+    {
+      std::vector<TaskPtr> callbacks;
+      {
+        std::lock_guard<std::mutex> guard{ m_mutex };
+        m_done = true;
+        callbacks.swap(m_callbacks);
+      }
+      if (executed)
+      {
+        for (auto& pCallback : callbacks)
+        {
+          pCallback->Execute();
+        }
+      }
+    }
 
   private:
-    TaskFuture(const TaskFuture& rhs) = delete;
-    TaskFuture& operator=(const TaskFuture& rhs) = delete;
+    TaskState(const TaskState& rhs) = delete;
+    TaskState& operator=(const TaskState& rhs) = delete;
 
-    std::future<T> m_future; ///< Future
-    bool m_detach;           ///< Detach future
+    std::mutex m_mutex;               ///< Mutex for locking
+    bool m_done{ false };             ///< Task completed or discarded
+    std::vector<TaskPtr> m_callbacks; ///< Callbacks awaiting completion
   };
 
-public:
-  /**
-   * Constructor.
-   */
-  ThreadPool()
-    : ThreadPool{ std::max<unsigned int>(std::thread::hardware_concurrency(), 2u) - 1u }
+  //! Completion task
+  /*!
+    Task executing a packaged task followed by the callbacks of its
+    @ref TaskState.
+  */
+  template <typename R>
+  class CompletionTask : public IThreadTask
   {
-    /*
-     * Always create at least one thread.  If hardware_concurrency() returns 0,
-     * subtracting one would turn it to UINT_MAX, so get the maximum of
-     * hardware_concurrency() and 2 before subtracting 1.
-     */
-  }
+  public:
+    CompletionTask(std::packaged_task<R()>&& task, std::shared_ptr<TaskState> pState)
+      : m_task{ std::move(task) }
+      , m_pState{ std::move(pState) }
+      , m_executed{ false }
+    {
+    }
 
-  /**
-   * Constructor. No implicit conversion allowed
-   */
-  explicit ThreadPool(const std::size_t numThreads)
-    : m_nThreadsOnHold{ 0 }
-    , m_done{ false }
-    , m_workQueue{}
-    , m_threads{}
-  {
-    try
+    ~CompletionTask() SPS_OVERRIDE
     {
-      for (std::size_t i = 0u; i < numThreads; ++i)
+      if (!m_executed)
       {
-        m_threads.emplace_back(&ThreadPool::worker, this);
+        // Break the promise before releasing the callbacks, since a
+        // continuation may own a future waiting for it
+        m_task = std::packaged_task<R()>();
+        m_pState->complete(false);
       }
     }
-    catch (...)
+
+    void Execute() SPS_OVERRIDE
     {
-      // Function registered may throw
-      destroy();
-      throw;
+      m_task();
+      m_executed = true;
+      m_pState->complete(true);
     }
-  }
 
-  /**
-   * Destructor.
-   */
-  ~ThreadPool()
-  {
-    destroy();
-  }
+  private:
+    CompletionTask(const CompletionTask& rhs) = delete;
+    CompletionTask& operator=(const CompletionTask& rhs) = delete;
 
-  /**
-   * Submit a job to be run by the thread pool. The return true
-   * should never be deduced to a reference, so auto is used rather
-   * than decltype(auto)
-   */
-  template <typename Func, typename... Args>
-  auto submit(Func&& func, Args&&... args)
+    std::packaged_task<R()> m_task;      ///< Task
+    std::shared_ptr<TaskState> m_pState; ///< Completion state
+    bool m_executed;                     ///< Task has been executed
+  };
+
+  //! Cancellable task
+  /*!
+    Task submitted with a @ref CancellationToken. The worker executing
+    the task and the token cancelling it race to claim the task. If
+    the token wins, the future reports @ref TaskCancelled immediately
+    and the task is discarded, when dequeued.
+  */
+  template <typename Func>
+  class CancellableTask : public IThreadTask
   {
-    // If called with an immediate, say 42 an rvalue,
-    // Args is deduced to int and std::forward<int> is int&& (rvalue)
-    // If called with an lvalue of int, Args is deduced to int&,
-    // forward<int&> is int& &&, which collapses to int& (lvalue)
-    // Without templates - forward only works with rvalues
+  public:
+    using ResultType = std::invoke_result_t<Func&>;
 
-    // Perfect forwarding - boundTask declared as r-value reference &&
-    auto boundTask = std::bind(std::forward<Func>(func), std::forward<Args>(args)...);
+    //! Claim shared by the task and the cancellation token
+    class Claim : public detail::CancellationHook
+    {
+    public:
+      bool cancel() SPS_OVERRIDE
+      {
+        if (m_claimed.exchange(true))
+        {
+          return false;
+        }
+        m_promise.set_exception(std::make_exception_ptr(TaskCancelled()));
+        m_pState->complete(true);
+        return true;
+      }
 
-    // TODO(JEM): Change to std::invoke_result_t
-    //            std::result_of_t is deprecated as of c++17
-    using ResultType = std::result_of_t<decltype(boundTask)()>;
+      std::atomic<bool> m_claimed{ false };  ///< Task executed or cancelled
+      std::promise<ResultType> m_promise{};  ///< Result
+      std::shared_ptr<TaskState> m_pState{}; ///< Completion state
+    };
 
-    // wrapped for async invocation
-    using PackagedTask = std::packaged_task<ResultType()>;
-    // stored in a shared state, which can be accessed through std::future.
-    using TaskType = ThreadTask<PackagedTask>;
+    CancellableTask(Func&& func, std::shared_ptr<Claim> pClaim)
+      : m_func{ std::move(func) }
+      , m_pClaim{ std::move(pClaim) }
+    {
+    }
 
-    PackagedTask task{ std::move(boundTask) };
-    TaskFuture<ResultType> result{ task.get_future() };
-    m_workQueue.push(std::make_unique<TaskType>(std::move(task)));
-    return result;
-  }
+    ~CancellableTask() SPS_OVERRIDE
+    {
+      if (!m_pClaim->m_claimed.exchange(true))
+      {
+        // The claim may outlive the task, so the promise is broken
+        // explicitly, see CompletionTask
+        m_pClaim->m_promise.set_exception(
+          std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        m_pClaim->m_pState->complete(false);
+      }
+    }
 
-private:
-  /**
-   * Non-copyable.
-   */
-  ThreadPool(const ThreadPool& rhs) = delete;
+    void Execute() SPS_OVERRIDE
+    {
+      if (m_pClaim->m_claimed.exchange(true))
+      {
+        // Cancelled
+        return;
+      }
+      try
+      {
+        if constexpr (std::is_void<ResultType>::value)
+        {
+          m_func();
+          m_pClaim->m_promise.set_value();
+        }
+        else
+        {
+          m_pClaim->m_promise.set_value(m_func());
+        }
+      }
+      catch (...)
+      {
+        m_pClaim->m_promise.set_exception(std::current_exception());
+      }
+      m_pClaim->m_pState->complete(true);
+    }
 
-  /**
-   * Non-assignable.
-   */
-  ThreadPool& operator=(const ThreadPool& rhs) = delete;
+  private:
+    CancellableTask(const CancellableTask& rhs) = delete;
+    CancellableTask& operator=(const CancellableTask& rhs) = delete;
 
-  /**
-   * Constantly running function each thread uses to acquire work items from the queue.
-   */
-  void worker()
+    Func m_func;                     ///< Callable
+    std::shared_ptr<Claim> m_pClaim; ///< Claim
+  };
+
+  //! Task slot
+  /*!
+    Fixed-size task with inline storage for a small callable and its
+    result. A slot is shared between the queue and a @ref SlotFuture
+    using a reference count and is recycled through a lock-free
+    free-list of the pool, such that submitting a task does not touch
+    the global allocator.
+  */
+  class SPS_ALIGNAS(64) TaskSlot : public IThreadTask
   {
-    while (!m_done)
+  public:
+    /// Size of inline storage shared by callable and result
+    static constexpr std::size_t StorageSize = 64;
+
+    TaskSlot() = default;
+
+    ~TaskSlot() SPS_OVERRIDE { reset(); }
+
+    /**
+     * Invoke callable, store result or exception and signal completion
+     *
+     */
+    void Execute() SPS_OVERRIDE
+    {
+      m_invoke(this);
+      complete();
+    }
+
+    /**
+     * Release the queue's reference. If the task is discarded before
+     * being executed, waiters are released with a broken promise.
+     *
+     */
+    void Release() SPS_OVERRIDE
     {
-      std::unique_ptr<IThreadTask> pTask{ nullptr };
-      if (m_workQueue.pop(pTask))
+      if (!m_ready.load(std::memory_order_acquire))
       {
-        pTask->Execute();
+        clear();
+        m_exception = std::make_exception_ptr(std::future_error(std::future_errc::broken_promise));
+        complete();
       }
+      unref();
     }
-  }
 
-  /**
-   * Invalidates the queue and joins all running threads.
-   */
-  void destroy()
-  {
-    m_done = true;
-    m_workQueue.invalidate();
-    for (auto& thread : m_threads)
+    /**
+     * Move-construct callable into inline storage
+     *
+     * @param func
+     */
+    template <typename Func>
+    void emplace(Func&& func)
     {
-      if (thread.joinable())
+      using F = std::decay_t<Func>;
+      static_assert(sizeof(F) <= StorageSize && alignof(F) <= alignof(std::max_align_t),
+        "Callable too large for task slot, use submit()");
+      new (m_storage) F(std::forward<Func>(func));
+      m_destroy = &destroyAs<F>;
+      m_invoke = &invokeAs<F>;
+    }
+
+    /**
+     * Take result or rethrow exception stored by @ref Execute
+     *
+     * @return
+     */
+    template <typename R>
+    R take()
+    {
+      if (m_exception)
       {
-        thread.join();
+        std::rethrow_exception(m_exception);
+      }
+      if constexpr (!std::is_void<R>::value)
+      {
+        R result = std::move(*std::launder(reinterpret_cast<R*>(m_storage)));
+        clear();
+        return result;
       }
     }
-  }
 
-private:
-  std::atomic<int> m_nThreadsOnHold;                   ///< Threads on hold
-  std::atomic_bool m_done;                             ///< Are we done?
-  QueueImpl<std::unique_ptr<IThreadTask>> m_workQueue; ///< Work queue
-  std::vector<std::thread> m_threads;                  ///< Threads in the pool
-};
+    bool ready() const { return m_ready.load(); }
+
+    /**
+     * Drop a reference. The last reference returns the slot to the pool
+     *
+     */
+    void unref()
+    {
+      if (m_nRefs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+        m_pPool->slotRelease(this);
+      }
+    }
+
+    /**
+     * Destroy content and reset state for reuse
+     *
+     */
+    void reset()
+    {
+      clear();
+      m_exception = nullptr;
+      m_invoke = nullptr;
+      m_ready.store(false, std::memory_order_relaxed);
+    }
+
+  private:
+    friend class ThreadPool;
+
+    TaskSlot(const TaskSlot& rhs) = delete;
+    TaskSlot& operator=(const TaskSlot& rhs) = delete;
+
+    template <typename T>
+    static void destroyAs(void* pStorage)
+    {
+      std::launder(static_cast<T*>(pStorage))->~T();
+    }
+
+    template <typename F>
+    static void invokeAs(TaskSlot* pSlot)
+    {
+      using R = std::invoke_result_t<F&>;
+      F& func = *std::launder(reinterpret_cast<F*>(pSlot->m_storage));
+      try
+      {
+        if constexpr (std::is_void<R>::value)
+        {
+          func();
+          pSlot->clear();
+        }
+        else
+        {
+          // Result replaces the callable in the inline storage
+          R result = func();
+          pSlot->clear();
+          new (pSlot->m_storage) R(std::move(result));
+          pSlot->m_destroy = &destroyAs<R>;
+        }
+      }
+      catch (...)
+      {
+        pSlot->clear();
+        pSlot->m_exception = std::current_exception();
+      }
+    }
+
+    void clear()
+    {
+      if (m_destroy)
+      {
+        m_destroy(m_storage);
+        m_destroy = nullptr;
+      }
+    }
+
+    void complete()
+    {
+      m_ready.store(true);
+      m_pPool->slotNotify();
+    }
+
+    void (*m_invoke)(TaskSlot*){ nullptr };  ///< Invoke callable in storage
+    void (*m_destroy)(void*){ nullptr };     ///< Destroy content of storage
+    std::exception_ptr m_exception{};        ///< Exception thrown by callable
+    ThreadPool* m_pPool{ nullptr };          ///< Pool owning the slot
+    std::atomic<bool> m_ready{ false };      ///< Result is available
+    std::atomic<std::uint32_t> m_nRefs{ 0 }; ///< References (queue and future)
+    std::atomic<std::uint32_t> m_next{ 0 };  ///< Free-list link (index + 1)
+    bool m_bHeap{ false };                   ///< Allocated on heap, pool exhausted
+    /// Inline storage for callable or result
+    alignas(std::max_align_t) unsigned char m_storage[StorageSize];
+  };
+
+  //! Deleter for the reference held by a @ref SlotFuture
+  struct SlotDeleter
+  {
+    void operator()(TaskSlot* pSlot) const { pSlot->unref(); }
+  };
+
+  //! Worker queue
+  /*!
+    Local double-ended queue of a worker used with @ref
+    SchedulingPolicy::WorkStealing. The owner pushes and pops at the
+    back (LIFO), thieves steal from the front (FIFO). Aligned to avoid
+    false sharing between the locks of neighbouring workers.
+  */
+  struct SPS_ALIGNAS(64) WorkerQueue
+  {
+    std::mutex m_mutex;          ///< Mutex for locking
+    std::deque<TaskPtr> m_tasks; ///< Tasks
+  };
+
+  //! Priority queue
+  /*!
+    Queue of a priority class. Tasks with a deadline are kept in a
+    min-heap and dequeued earliest-deadline-first ahead of tasks
+    without deadline, which are dequeued in order of submission.
+    Normal tasks without deadline are queued on the shared queue (or
+    worker deques) instead. The counters are used for aging of the
+    class.
+  */
+  struct SPS_ALIGNAS(64) PriorityQueue
+  {
+    /// Task with deadline
+    using DeadlineTask = std::pair<std::chrono::steady_clock::time_point, TaskPtr>;
+
+    std::mutex m_mutex;                        ///< Mutex for locking
+    std::deque<TaskPtr> m_tasks;               ///< Tasks without deadline
+    std::vector<DeadlineTask> m_deadlineTasks; ///< Tasks with deadline (min-heap)
+    std::atomic<std::size_t> m_nTasks{ 0 };    ///< Tasks in this queue
+    std::atomic<std::size_t> m_nSkipped{ 0 };  ///< Higher classes served meanwhile
+  };
+
+  /// Number of priority classes
+  static constexpr std::size_t nPriorities = 3;
+
+  //! Worker counters
+  /*!
+    Instrumentation of a worker. Counters are written only by the
+    worker itself (see @ref Increment) and aggregated on read, such
+    that no cache line is shared on the hot path. Times are in
+    nanoseconds.
+  */
+  struct SPS_ALIGNAS(64) WorkerCounters
+  {
+    using Counter = std::atomic<std::uint64_t>;
+
+    Counter m_nSubmitted[nPriorities]{};                     ///< Tasks submitted per class
+    Counter m_nCompleted{ 0 };                               ///< Tasks executed
+    Counter m_busyTime{ 0 };                                 ///< Time executing tasks
+    Counter m_idleTime{ 0 };                                 ///< Time spinning or parked
+    Counter m_parkedSince{ 0 };                              ///< Start of idling, zero if running
+    Counter m_nDequeued[nPriorities]{};                      ///< Tasks dequeued per class
+    Counter m_nWaits[nPriorities]{};                         ///< Waits sampled per class
+    Counter m_waitTotal[nPriorities]{};                      ///< Accumulated wait per class
+    Counter m_waitMax[nPriorities]{};                        ///< Longest wait per class
+    Counter m_waitHistogram[ThreadPoolHistogramBins]{};      ///< Wait times
+    Counter m_executionHistogram[ThreadPoolHistogramBins]{}; ///< Execution times
+    std::chrono::steady_clock::time_point m_dequeued{};      ///< Time of last dequeue
+    std::size_t m_depth{ 0 };                                ///< Nesting of tasks executed
+    std::uint32_t m_nSpins{ 0 };                             ///< Spin budget (adaptive)
+    std::uint32_t m_nSubmits{ 0 };                           ///< Submissions, for sampling waits
+  };
+
+  /// Smallest spin budget using IdlePolicy::Adaptive
+  static constexpr std::uint32_t MinSpins = 16;
+
+  /// Submissions of a worker per sampled wait time
+  static constexpr std::uint32_t WaitSampleInterval = 16;
+
+  //! Submission counter of threads outside the pool
+  struct SPS_ALIGNAS(64) SubmitCounter
+  {
+    std::atomic<std::uint64_t> m_nSubmitted[nPriorities]{}; ///< Tasks submitted per class
+  };
+
+  /// Number of submission counters shared by threads outside the pool
+  static constexpr std::size_t nSubmitCounters = 8;
+
+  //! Worker context
+  /*!
+    Identifies the pool and the worker index of the calling
+    thread. Threads not owned by a pool have a null pool.
+  */
+  struct WorkerContext
+  {
+    const ThreadPool* pPool; ///< Pool owning the thread
+    std::size_t iWorker;     ///< Index of worker within pool
+  };
+
+  /**
+   * Context of the calling thread
+   *
+   * @return
+   */
+  static WorkerContext& CurrentWorker()
+  {
+    static thread_local WorkerContext context{ nullptr, 0 };
+    return context;
+  }
+
+public:
+  //! Task future
+  /*!
+    Simple wrapper around std::future. The behavoir of futures
+    returned from std::async is added. The object will block and wait
+    for completion unless, detach is called.
+
+    If waited for by a worker of the pool, which submitted the task,
+    the worker runs other queued tasks of the pool until the task
+    completes, such that tasks waiting for sub-tasks neither deadlock
+    nor keep a worker idle.
+
+    Continuations added using @ref then are submitted to the pool,
+    when the task completes, without blocking any thread. Using C++20,
+    a coroutine may co_await the future, see @ref operator co_await.
+  */
+  template <typename T>
+  class TaskFuture
+  {
+  public:
+    explicit TaskFuture(std::future<T>&& future, ThreadPool* pPool = nullptr,
+      std::shared_ptr<TaskState> pState = nullptr)
+      : m_future{ std::move(future) }
+      , m_pPool{ pPool }
+      , m_pState{ std::move(pState) }
+      , m_detach(false)
+    {
+    }
+
+    TaskFuture(TaskFuture&& other) = default;
+    TaskFuture& operator=(TaskFuture&& other) = default;
+
+    ~TaskFuture()
+    {
+      if (m_future.valid())
+      {
+        if (!m_detach)
+        {
+          // Block if not detached. Exceptions are not rethrown
+          wait();
+          m_future.wait();
+        }
+      }
+    }
+
+    /**
+     * Get the std::future to wait for. Note, deduced return types
+     * only available using c++14
+     *
+     * @return
+     */
+    auto Get()
+    {
+      wait();
+      return m_future.get();
+    }
+
+    /**
+     * Detach future from from processing
+     *
+     */
+    void Detach() { m_detach = true; }
+
+    /**
+     * Is the result available
+     *
+     * @return
+     */
+    bool Ready() const
+    {
+      return m_future.valid() &&
+        m_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    /**
+     * Attach a continuation, which is submitted to the pool, when
+     * this task completes. The continuation is called with this
+     * future, which is ready, such that it can retrieve the result or
+     * the exception. The future is invalid afterwards.
+     *
+     * @param func Continuation, R func(TaskFuture<T> antecedent)
+     * @param priority Priority class of continuation
+     *
+     * @return Future of the continuation
+     */
+    template <typename Func>
+    auto then(Func&& func, const TaskPriority priority = TaskPriority::Normal)
+    {
+      if (!m_pState)
+      {
+        throw std::future_error(std::future_errc::no_state);
+      }
+      ThreadPool* pPool = m_pPool;
+      std::shared_ptr<TaskState> pState = m_pState;
+      auto continuation = pPool->package(
+        [antecedent = std::move(*this), func = std::forward<Func>(func)]() mutable
+        { return func(std::move(antecedent)); });
+      pState->callbackAdd(pPool->deferred(std::move(continuation.first), priority));
+      return std::move(continuation.second);
+    }
+
+#if defined(SPS_COROUTINES)
+    //! Awaiter of a task future
+    struct Awaiter
+    {
+      TaskFuture future; ///< Future awaited
+
+      bool await_ready() const { return !future.m_pState || future.Ready(); }
+
+      void await_suspend(std::coroutine_handle<> handle)
+      {
+        // The coroutine and thereby the future may be destroyed,
+        // before callbackAdd returns
+        ThreadPool* pPool = future.m_pPool;
+        std::shared_ptr<TaskState> pState = future.m_pState;
+        // Callback and resumption are stored in task slots
+        TaskSlot* pSlot = pPool->slotAcquire();
+        pSlot->emplace([pPool, handle]() -> void { pPool->resume(handle); });
+        pSlot->m_nRefs.store(1, std::memory_order_relaxed);
+        pState->callbackAdd(TaskPtr{ pSlot });
+      }
+
+      auto await_resume() { return future.Get(); }
+    };
+
+    /**
+     * Await the task from a coroutine without blocking a thread. When
+     * the task completes, the coroutine is resumed on a worker of the
+     * pool. Exceptions thrown by the task are rethrown. If the pool is
+     * destroyed before the task completes, the task is discarded and
+     * the coroutine is never resumed, like using @ref schedule.
+     *
+     * @return
+     */
+    Awaiter operator co_await() && { return Awaiter{ std::move(*this) }; }
+#endif
+
+  private:
+    friend class ThreadPool;
+
+    TaskFuture(const TaskFuture& rhs) = delete;
+    TaskFuture& operator=(const TaskFuture& rhs) = delete;
+
+    /**
+     * Run queued tasks while waiting, if called from a worker of the
+     * pool. Other threads block in std::future::get().
+     *
+     */
+    void wait()
+    {
+      if (m_pPool && m_future.valid())
+      {
+        m_pPool->helpUntil(
+          [this]() -> bool
+          { return m_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; },
+          [this]() -> void { m_future.wait_for(HelpWaitInterval); });
+      }
+    }
+
+    std::future<T> m_future;             ///< Future
+    ThreadPool* m_pPool;                 ///< Pool executing the task
+    std::shared_ptr<TaskState> m_pState; ///< Completion state
+    bool m_detach;                       ///< Detach future
+  };
+
+  //! Result of @ref when_any
+  template <typename T>
+  struct WhenAnyResult
+  {
+    std::size_t index;                  ///< Index of first future completed
+    std::vector<TaskFuture<T>> futures; ///< Futures
+  };
+
+  //! Slot future
+  /*!
+    Lightweight future backed by the task slot used by @ref
+    submitInline. Like @ref TaskFuture, it blocks on destruction
+    unless detached. It must not outlive the pool.
+  */
+  template <typename T>
+  class SlotFuture
+  {
+  public:
+    explicit SlotFuture(TaskSlot* pSlot)
+      : m_pSlot{ pSlot }
+      , m_detach(false)
+    {
+    }
+
+    SlotFuture(SlotFuture&& other) = default;
+    SlotFuture& operator=(SlotFuture&& other) = default;
+
+    ~SlotFuture()
+    {
+      if (m_pSlot && !m_detach)
+      {
+        // Block if not detached
+        m_pSlot->m_pPool->slotWait(*m_pSlot);
+      }
+    }
+
+    /**
+     * Wait for the task and return its result. Exceptions thrown by
+     * the task are rethrown.
+     *
+     * @return
+     */
+    T Get()
+    {
+      m_pSlot->m_pPool->slotWait(*m_pSlot);
+      std::unique_ptr<TaskSlot, SlotDeleter> pSlot{ std::move(m_pSlot) };
+      return pSlot->template take<T>();
+    }
+
+    /**
+     * Is the result available
+     *
+     * @return
+     */
+    bool Ready() const { return m_pSlot && m_pSlot->ready(); }
+
+    /**
+     * Detach future from from processing
+     *
+     */
+    void Detach() { m_detach = true; }
+
+  private:
+    SlotFuture(const SlotFuture& rhs) = delete;
+    SlotFuture& operator=(const SlotFuture& rhs) = delete;
+
+    std::unique_ptr<TaskSlot, SlotDeleter> m_pSlot; ///< Slot
+    bool m_detach;                                  ///< Detach future
+  };
+
+public:
+  /// Number of pooled task slots used by @ref submitInline and @ref post
+  static constexpr std::size_t nTaskSlots = 1024;
+
+  /// Tasks of higher classes served before a waiting class is served
+  static constexpr std::size_t StarvationLimit = 16;
+
+  /// Longest wait of a helping worker before checking for queued tasks
+  static constexpr std::chrono::microseconds HelpWaitInterval{ 100 };
+
+  /**
+   * Constructor.
+   */
+  ThreadPool()
+    : ThreadPool{ std::max<unsigned int>(std::thread::hardware_concurrency(), 2u) - 1u }
+  {
+    /*
+     * Always create at least one thread.  If hardware_concurrency() returns 0,
+     * subtracting one would turn it to UINT_MAX, so get the maximum of
+     * hardware_concurrency() and 2 before subtracting 1.
+     */
+  }
+
+  /**
+   * Constructor. No implicit conversion allowed
+   */
+  explicit ThreadPool(const std::size_t numThreads)
+    : ThreadPool{ numThreads, SchedulingPolicy::SharedQueue }
+  {
+  }
+
+  /**
+   * Constructor.
+   *
+   * @param numThreads Number of worker threads
+   * @param policy Scheduling policy. Using @ref
+   *        SchedulingPolicy::WorkStealing, tasks submitted from a
+   *        worker are pushed onto the local deque of that worker and
+   *        idle workers steal from the deques of others.
+   */
+  ThreadPool(const std::size_t numThreads, const SchedulingPolicy policy)
+    : ThreadPool{ ThreadPoolOptions{ numThreads, policy } }
+  {
+  }
+
+  /**
+   * Constructor.
+   *
+   * @param options Number of threads, scheduling policy and placement
+   *        of workers. Using an affinity policy other than
+   *        AffinityPolicy::None, worker i pins itself to CPU i modulo
+   *        the number of CPUs selected.
+   *
+   * @throws std::invalid_argument if no CPU is selected by the
+   *         affinity policy, see @ref AffinityCpusGet
+   */
+  explicit ThreadPool(const ThreadPoolOptions& options)
+    : m_nThreadsOnHold{ 0 }
+    , m_done{ false }
+    , m_policy{ options.scheduling }
+    , m_idle{ std::thread::hardware_concurrency() > 1 ? options.idle : IdlePolicy::Park }
+    , m_nSpins{ options.nSpins }
+    , m_nYields{ options.nYields }
+    , m_cpus{ AffinityCpusGet(options.affinity, options.cpus, options.excludedCpus) }
+    , m_nCapacity{ Capacity(options) }
+    , m_nWorkers{ options.nThreads }
+    , m_nSignals{ 0 }
+    , m_nParked{ 0 }
+    , m_nSpinning{ 0 }
+    , m_nSlotWaiters{ 0 }
+    , m_slots{ new TaskSlot[nTaskSlots] }
+    , m_slotHead{ 0 }
+    , m_workQueue{}
+#if defined(SPS_USE_BOUNDED_QUEUE)
+    , m_overflow{}
+    , m_nOverflow{ 0 }
+#endif
+    , m_localQueues{}
+    , m_workerCounters{ new WorkerCounters[m_nCapacity] }
+    , m_threads{}
+  {
+    for (std::size_t i = 0u; i < nTaskSlots; ++i)
+    {
+      m_slots[i].m_pPool = this;
+      slotRelease(&m_slots[i]);
+    }
+    for (std::size_t i = 0u; i < m_nCapacity; ++i)
+    {
+      m_workerCounters[i].m_nSpins = m_nSpins;
+    }
+    if (m_policy == SchedulingPolicy::WorkStealing)
+    {
+      // Deques are never reallocated, since thieves access them without locking the pool
+      for (std::size_t i = 0u; i < m_nCapacity; ++i)
+      {
+        m_localQueues.emplace_back(std::make_unique<WorkerQueue>());
+      }
+    }
+    try
+    {
+      for (std::size_t i = 0u; i < options.nThreads; ++i)
+      {
+        m_threads.emplace_back(&ThreadPool::worker, this, i);
+      }
+    }
+    catch (...)
+    {
+      // Function registered may throw
+      destroy();
+      throw;
+    }
+  }
+
+  /**
+   * Destructor.
+   */
+  ~ThreadPool()
+  {
+    destroy();
+  }
+
+  /**
+   * Submit a job to be run by the thread pool. The return true
+   * should never be deduced to a reference, so auto is used rather
+   * than decltype(auto)
+   */
+  template <typename Func, typename... Args>
+  auto submit(Func&& func, Args&&... args)
+  {
+    return submitTask(
+      TaskPriority::Normal, NoDeadline(), std::forward<Func>(func), std::forward<Args>(args)...);
+  }
+
+  /**
+   * Submit a job with a priority
+   *
+   * @param priority Priority class
+   * @param func
+   * @param args
+   *
+   * @return
+   */
+  template <typename Func, typename... Args>
+  auto submit(const TaskPriority priority, Func&& func, Args&&... args)
+  {
+    return submitTask(
+      priority, NoDeadline(), std::forward<Func>(func), std::forward<Args>(args)...);
+  }
+
+  /**
+   * Submit a job with a priority and a deadline. Within its class, the
+   * job is dequeued earliest-deadline-first ahead of jobs without
+   * deadline. A missed deadline is not an error.
+   *
+   * @param priority Priority class
+   * @param deadline
+   * @param func
+   * @param args
+   *
+   * @return
+   */
+  template <typename Func, typename... Args>
+  auto submit(const TaskPriority priority, const std::chrono::steady_clock::time_point deadline,
+    Func&& func, Args&&... args)
+  {
+    return submitTask(priority, deadline, std::forward<Func>(func), std::forward<Args>(args)...);
+  }
+
+  /**
+   * Submit a job tied to a cancellation token. If cancelled before the
+   * job has started, the job is not executed and its future reports
+   * @ref TaskCancelled.
+   *
+   * @param token Token of a @ref CancellationSource
+   * @param func
+   * @param args
+   *
+   * @return
+   */
+  template <typename Func, typename... Args>
+  auto submit(CancellationToken token, Func&& func, Args&&... args)
+  {
+    return submitCancellable(
+      TaskPriority::Normal, token, std::forward<Func>(func), std::forward<Args>(args)...);
+  }
+
+  /**
+   * Submit a job with a priority tied to a cancellation token
+   *
+   * @param priority Priority class
+   * @param token Token of a @ref CancellationSource
+   * @param func
+   * @param args
+   *
+   * @return
+   */
+  template <typename Func, typename... Args>
+  auto submit(const TaskPriority priority, CancellationToken token, Func&& func, Args&&... args)
+  {
+    return submitCancellable(
+      priority, token, std::forward<Func>(func), std::forward<Args>(args)...);
+  }
+
+  /**
+   * Submit a job without allocating. The callable and its bound
+   * arguments are stored inline in a pooled task slot (at most
+   * TaskSlot::StorageSize bytes), which also holds the result.
+   *
+   * @param func
+   * @param args
+   *
+   * @return Lightweight future backed by the task slot
+   */
+  template <typename Func, typename... Args>
+  auto submitInline(Func&& func, Args&&... args)
+  {
+    auto boundTask = bindInline(std::forward<Func>(func), std::forward<Args>(args)...);
+    using ResultType = std::invoke_result_t<decltype(boundTask)&>;
+    using StoredType = std::conditional_t<std::is_void<ResultType>::value, char, ResultType>;
+    static_assert(sizeof(StoredType) <= TaskSlot::StorageSize &&
+        alignof(StoredType) <= alignof(std::max_align_t),
+      "Result too large for task slot, use submit()");
+
+    TaskSlot* pSlot = slotAcquire();
+    pSlot->emplace(std::move(boundTask));
+    // One reference for the queue and one for the future
+    pSlot->m_nRefs.store(2, std::memory_order_relaxed);
+    SlotFuture<ResultType> result{ pSlot };
+    enqueue(TaskPtr{ pSlot });
+    return result;
+  }
+
+  /**
+   * Post a fire-and-forget job without allocating. Exceptions thrown
+   * by the job are discarded.
+   *
+   * @param func
+   * @param args
+   */
+  template <typename Func, typename... Args>
+  void post(Func&& func, Args&&... args)
+  {
+    TaskSlot* pSlot = slotAcquire();
+    pSlot->emplace(bindInline(std::forward<Func>(func), std::forward<Args>(args)...));
+    pSlot->m_nRefs.store(1, std::memory_order_relaxed);
+    enqueue(TaskPtr{ pSlot });
+  }
+
+  /**
+   * Submit nJobs jobs calling func(i) for i in [0, nJobs). The jobs
+   * are stored in task slots and enqueued using a single queue
+   * operation.
+   *
+   * @param nJobs Number of jobs
+   * @param func Job, void func(std::size_t i)
+   *
+   * @return Future completing when all jobs have completed. The first
+   *         exception thrown by a job is rethrown.
+   */
+  template <typename Func>
+  TaskFuture<void> submitBulk(const std::size_t nJobs, Func&& func)
+  {
+    struct Outcome
+    {
+      std::mutex mutex;             ///< Mutex for locking
+      std::exception_ptr exception; ///< First exception thrown
+    };
+    // Only the jobs refer to the state, such that it is released
+    // (and the result is broken) if the jobs are discarded
+    struct BulkState
+    {
+      std::decay_t<Func> func;             ///< Job
+      std::atomic<std::size_t> nRemaining; ///< Jobs not completed
+      std::shared_ptr<Outcome> pOutcome;   ///< Outcome
+      TaskPtr pResult;                     ///< Task completing the future
+    };
+
+    auto pOutcome = std::make_shared<Outcome>();
+    auto result = package(
+      [pOutcome]() -> void
+      {
+        if (pOutcome->exception)
+        {
+          std::rethrow_exception(pOutcome->exception);
+        }
+      });
+    if (nJobs == 0)
+    {
+      enqueue(std::move(result.first));
+      return std::move(result.second);
+    }
+
+    std::shared_ptr<BulkState> pBulk{ new BulkState{
+      std::forward<Func>(func), { nJobs }, std::move(pOutcome), std::move(result.first) } };
+    std::vector<TaskPtr> tasks;
+    tasks.reserve(nJobs);
+    for (std::size_t i = 0; i < nJobs; ++i)
+    {
+      TaskSlot* pSlot = slotAcquire();
+      pSlot->emplace(
+        [this, pBulk, i]() -> void
+        {
+          try
+          {
+            pBulk->func(i);
+          }
+          catch (...)
+          {
+            std::lock_guard<std::mutex> guard{ pBulk->pOutcome->mutex };
+            if (!pBulk->pOutcome->exception)
+            {
+              pBulk->pOutcome->exception = std::current_exception();
+            }
+          }
+          if (pBulk->nRemaining.fetch_sub(1) == 1)
+          {
+            enqueue(std::move(pBulk->pResult));
+          }
+        });
+      pSlot->m_nRefs.store(1, std::memory_order_relaxed);
+      tasks.emplace_back(pSlot);
+    }
+    enqueueBulk(tasks);
+    return std::move(result.second);
+  }
+
+#if defined(SPS_COROUTINES)
+  //! Awaiter of @ref schedule
+  class ScheduleAwaiter
+  {
+  public:
+    ScheduleAwaiter(ThreadPool* pPool, const TaskPriority priority)
+      : m_pPool{ pPool }
+      , m_priority{ priority }
+    {
+    }
+
+    bool await_ready() const { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) { m_pPool->resume(handle, m_priority); }
+
+    void await_resume() const {}
+
+  private:
+    ThreadPool* m_pPool;     ///< Pool resuming the coroutine
+    TaskPriority m_priority; ///< Priority class
+  };
+
+  /**
+   * Awaitable, which suspends the calling coroutine and resumes it on
+   * a worker of the pool. If the pool is destroyed before the
+   * coroutine is resumed, the coroutine is never resumed.
+   *
+   * \code
+   * sps::task<int> Compute(sps::ThreadPool& pool)
+   * {
+   *   co_await pool.schedule();
+   *   // Running on a worker
+   *   co_return 42;
+   * }
+   * \endcode
+   *
+   * @param priority Priority class of the resumption
+   *
+   * @return
+   */
+  ScheduleAwaiter schedule(const TaskPriority priority = TaskPriority::Normal)
+  {
+    return ScheduleAwaiter{ this, priority };
+  }
+#endif
+
+  /**
+   * Future completing when all futures have completed. No thread is
+   * blocked meanwhile. The futures must be non-empty and created by
+   * @ref submit or @ref TaskFuture::then of the same pool.
+   *
+   * @param futures
+   *
+   * @return Future of the futures, which are all ready
+   */
+  template <typename T>
+  static TaskFuture<std::vector<TaskFuture<T>>> when_all(std::vector<TaskFuture<T>>&& futures)
+  {
+    ThreadPool* pPool = combinePool(futures);
+
+    // Only callbacks refer to the state, such that it is released
+    // (and the result is broken) if a task is discarded
+    struct CombineState
+    {
+      std::atomic<std::size_t> nRemaining; ///< Futures not completed
+      TaskPtr pResult;                     ///< Task returning futures
+    };
+    auto pFutures = std::make_shared<std::vector<TaskFuture<T>>>(std::move(futures));
+    auto result =
+      pPool->package([pFutures]() -> std::vector<TaskFuture<T>> { return std::move(*pFutures); });
+    auto pCombine = std::make_shared<CombineState>();
+    pCombine->nRemaining = pFutures->size();
+    pCombine->pResult = pPool->deferred(std::move(result.first), TaskPriority::Normal);
+
+    // The result task moves the futures, so the states are collected
+    // before the first callback may complete
+    for (const auto& pState : States(*pFutures))
+    {
+      auto callback = [pCombine]() -> void
+      {
+        if (pCombine->nRemaining.fetch_sub(1) == 1)
+        {
+          pCombine->pResult->Execute();
+          pCombine->pResult.reset();
+        }
+      };
+      pState->callbackAdd(TaskPtr{ new ThreadTask<decltype(callback)>{ std::move(callback) } });
+    }
+    return std::move(result.second);
+  }
+
+  /**
+   * Future completing when any of the futures has completed. No
+   * thread is blocked meanwhile. The futures must be non-empty and
+   * created by @ref submit or @ref TaskFuture::then of the same pool.
+   *
+   * @param futures
+   *
+   * @return Future of the index of the first future completed and the futures
+   */
+  template <typename T>
+  static TaskFuture<WhenAnyResult<T>> when_any(std::vector<TaskFuture<T>>&& futures)
+  {
+    ThreadPool* pPool = combinePool(futures);
+
+    struct CombineState
+    {
+      std::atomic<bool> fired; ///< A future has completed
+      TaskPtr pResult;         ///< Task returning futures
+    };
+    auto pFutures = std::make_shared<std::vector<TaskFuture<T>>>(std::move(futures));
+    auto pIndex = std::make_shared<std::size_t>(0);
+    auto result = pPool->package([pFutures, pIndex]() -> WhenAnyResult<T>
+      { return WhenAnyResult<T>{ *pIndex, std::move(*pFutures) }; });
+    auto pCombine = std::make_shared<CombineState>();
+    pCombine->fired = false;
+    pCombine->pResult = pPool->deferred(std::move(result.first), TaskPriority::Normal);
+
+    const std::vector<std::shared_ptr<TaskState>> states = States(*pFutures);
+    for (std::size_t i = 0; i < states.size(); ++i)
+    {
+      auto callback = [pCombine, pIndex, i]() -> void
+      {
+        if (!pCombine->fired.exchange(true))
+        {
+          *pIndex = i;
+          pCombine->pResult->Execute();
+          pCombine->pResult.reset();
+        }
+      };
+      states[i]->callbackAdd(TaskPtr{ new ThreadTask<decltype(callback)>{ std::move(callback) } });
+    }
+    return std::move(result.second);
+  }
+
+  /**
+   * Scheduling policy used by the pool
+   *
+   * @return
+   */
+  SchedulingPolicy policy() const { return m_policy; }
+
+  /**
+   * Idle policy used by the pool
+   *
+   * @return
+   */
+  IdlePolicy idlePolicy() const { return m_idle; }
+
+  /**
+   * Queue statistics of a priority class
+   *
+   * @param priority
+   *
+   * @return
+   */
+  TaskClassStatistics statistics(const TaskPriority priority) const
+  {
+    const std::size_t iClass = static_cast<std::size_t>(priority);
+    std::uint64_t nExecuted = 0;
+    std::uint64_t nWaits = 0;
+    std::uint64_t waitTotal = 0;
+    std::uint64_t waitMax = 0;
+    for (std::size_t i = 0; i < m_nCapacity; ++i)
+    {
+      const WorkerCounters& counters = m_workerCounters[i];
+      nExecuted += counters.m_nDequeued[iClass].load(std::memory_order_relaxed);
+      nWaits += counters.m_nWaits[iClass].load(std::memory_order_relaxed);
+      waitTotal += counters.m_waitTotal[iClass].load(std::memory_order_relaxed);
+      waitMax = std::max(waitMax, counters.m_waitMax[iClass].load(std::memory_order_relaxed));
+    }
+    TaskClassStatistics result;
+    result.depth = static_cast<std::size_t>(depth(iClass));
+    result.nExecuted = nExecuted;
+    result.meanWait =
+      nWaits > 0 ? 1e-9 * static_cast<double>(waitTotal) / static_cast<double>(nWaits) : 0.0;
+    result.maxWait = 1e-9 * static_cast<double>(waitMax);
+    return result;
+  }
+
+  /**
+   * Statistics aggregated over all workers. Counters are read
+   * individually, so the result is not a consistent snapshot while
+   * tasks are executed.
+   *
+   * @return
+   */
+  ThreadPoolStatistics statistics() const
+  {
+    ThreadPoolStatistics result = {};
+    for (const SubmitCounter& counter : m_submitCounters)
+    {
+      for (const auto& nSubmitted : counter.m_nSubmitted)
+      {
+        result.nSubmitted += nSubmitted.load(std::memory_order_relaxed);
+      }
+    }
+    for (std::size_t i = 0; i < m_nCapacity; ++i)
+    {
+      const WorkerCounters& counters = m_workerCounters[i];
+      for (const auto& nSubmitted : counters.m_nSubmitted)
+      {
+        result.nSubmitted += nSubmitted.load(std::memory_order_relaxed);
+      }
+      result.nCompleted += counters.m_nCompleted.load(std::memory_order_relaxed);
+      for (std::size_t iBin = 0; iBin < ThreadPoolHistogramBins; ++iBin)
+      {
+        result.waitHistogram[iBin] +=
+          counters.m_waitHistogram[iBin].load(std::memory_order_relaxed);
+        result.executionHistogram[iBin] +=
+          counters.m_executionHistogram[iBin].load(std::memory_order_relaxed);
+      }
+    }
+    for (std::size_t iClass = 0; iClass < nPriorities; ++iClass)
+    {
+      result.queueDepth += depth(iClass);
+    }
+    return result;
+  }
+
+  /**
+   * Statistics of a worker
+   *
+   * @param iWorker Index of worker, less than @ref size
+   *
+   * @return
+   */
+  ThreadPoolWorkerStatistics workerStatistics(const std::size_t iWorker) const
+  {
+    const WorkerCounters& counters = m_workerCounters[iWorker];
+    ThreadPoolWorkerStatistics result;
+    result.nCompleted = counters.m_nCompleted.load(std::memory_order_relaxed);
+    result.busyTime = counters.m_busyTime.load(std::memory_order_relaxed);
+    result.idleTime = counters.m_idleTime.load(std::memory_order_relaxed);
+    // Include the current park
+    const std::uint64_t parkedSince = counters.m_parkedSince.load(std::memory_order_relaxed);
+    if (parkedSince != 0)
+    {
+      const std::uint64_t now = Nanoseconds(std::chrono::steady_clock::now().time_since_epoch());
+      result.idleTime += now > parkedSince ? now - parkedSince : 0;
+    }
+    return result;
+  }
+
+  /**
+   * Number of worker threads
+   *
+   * @return
+   */
+  std::size_t size() const { return m_nWorkers.load(); }
+
+  /**
+   * Maximum number of worker threads, see @ref resize
+   *
+   * @return
+   */
+  std::size_t capacity() const { return m_nCapacity; }
+
+  /**
+   * Change the number of worker threads. Workers are added or removed
+   * with the highest indices first. A removed worker completes the
+   * task it is executing and hands over the tasks of its local deque
+   * before it is joined, so no queued task is lost. Statistics of
+   * removed workers are retained.
+   *
+   * @param nThreads Number of worker threads, at most @ref capacity
+   */
+  void resize(const std::size_t nThreads)
+  {
+    if (nThreads > m_nCapacity)
+    {
+      throw std::invalid_argument("Number of threads exceeds capacity of thread pool");
+    }
+    if (CurrentWorker().pPool == this)
+    {
+      // A worker cannot join itself
+      throw std::logic_error("Thread pool cannot be resized from one of its workers");
+    }
+    std::lock_guard<std::mutex> guard{ m_resizeMutex };
+    const std::size_t nCurrent = m_threads.size();
+    m_nWorkers.store(nThreads);
+    if (nThreads > nCurrent)
+    {
+      try
+      {
+        for (std::size_t i = nCurrent; i < nThreads; ++i)
+        {
+          m_threads.emplace_back(&ThreadPool::worker, this, i);
+        }
+      }
+      catch (...)
+      {
+        m_nWorkers.store(m_threads.size());
+        throw;
+      }
+    }
+    else if (nThreads < nCurrent)
+    {
+      {
+        std::lock_guard<std::mutex> parkGuard{ m_parkMutex };
+        m_parkCondition.notify_all();
+      }
+      for (std::size_t i = nThreads; i < nCurrent; ++i)
+      {
+        m_threads[i].join();
+      }
+      m_threads.resize(nThreads);
+    }
+  }
+
+  /**
+   * CPU a worker is pinned to
+   *
+   * @param iWorker Index of worker
+   *
+   * @return CPU index or -1 if workers are not pinned
+   */
+  int cpu(const std::size_t iWorker) const
+  {
+    return m_cpus.empty() ? -1 : m_cpus[iWorker % m_cpus.size()];
+  }
+
+private:
+  friend class TaskGraph;
+
+  /**
+   * Non-copyable.
+   */
+  ThreadPool(const ThreadPool& rhs) = delete;
+
+  /**
+   * Non-assignable.
+   */
+  ThreadPool& operator=(const ThreadPool& rhs) = delete;
+
+  /**
+   * Deadline value used for tasks without deadline
+   *
+   * @return
+   */
+  static constexpr std::chrono::steady_clock::time_point NoDeadline()
+  {
+    return std::chrono::steady_clock::time_point::max();
+  }
+
+  /**
+   * Number of workers, for which queues and counters are allocated
+   *
+   * @param options
+   *
+   * @return
+   */
+  static std::size_t Capacity(const ThreadPoolOptions& options)
+  {
+    const std::size_t maxThreads = options.maxThreads > 0
+      ? options.maxThreads
+      : static_cast<std::size_t>(std::thread::hardware_concurrency());
+    return std::max(options.nThreads, maxThreads);
+  }
+
+  /**
+   * Submit a job with a priority and optional deadline
+   *
+   * @param priority
+   * @param deadline Deadline or NoDeadline()
+   * @param func
+   * @param args
+   *
+   * @return
+   */
+  template <typename Func, typename... Args>
+  auto submitTask(const TaskPriority priority, const std::chrono::steady_clock::time_point deadline,
+    Func&& func, Args&&... args)
+  {
+    auto packaged = package(std::forward<Func>(func), std::forward<Args>(args)...);
+    enqueue(std::move(packaged.first), priority, deadline);
+    return std::move(packaged.second);
+  }
+
+  /**
+   * Submit a job tied to a cancellation token. A job submitted with a
+   * token already cancelled is cancelled without being enqueued.
+   *
+   * @param priority
+   * @param token
+   * @param func
+   * @param args
+   *
+   * @return
+   */
+  template <typename Func, typename... Args>
+  auto submitCancellable(
+    const TaskPriority priority, const CancellationToken& token, Func&& func, Args&&... args)
+  {
+    auto boundTask = std::bind(std::forward<Func>(func), std::forward<Args>(args)...);
+    using TaskType = CancellableTask<decltype(boundTask)>;
+    using ResultType = typename TaskType::ResultType;
+
+    auto pClaim = std::make_shared<typename TaskType::Claim>();
+    pClaim->m_pState = std::make_shared<TaskState>();
+    TaskFuture<ResultType> result{ pClaim->m_promise.get_future(), this, pClaim->m_pState };
+    TaskPtr pTask{ new TaskType{ std::move(boundTask), pClaim } };
+    if (token.attach(pClaim))
+    {
+      enqueue(std::move(pTask), priority);
+    }
+    else
+    {
+      pClaim->cancel();
+    }
+    return result;
+  }
+
+  /**
+   * Create a task and its future without enqueuing the task
+   *
+   * @param func
+   * @param args
+   *
+   * @return Pair of task and future
+   */
+  template <typename Func, typename... Args>
+  auto package(Func&& func, Args&&... args)
+  {
+    // If called with an immediate, say 42 an rvalue,
+    // Args is deduced to int and std::forward<int> is int&& (rvalue)
+    // If called with an lvalue of int, Args is deduced to int&,
+    // forward<int&> is int& &&, which collapses to int& (lvalue)
+    // Without templates - forward only works with rvalues
+
+    // Perfect forwarding - boundTask declared as r-value reference &&
+    auto boundTask = std::bind(std::forward<Func>(func), std::forward<Args>(args)...);
+
+    // TODO(JEM): Change to std::invoke_result_t
+    //            std::result_of_t is deprecated as of c++17
+    using ResultType = std::result_of_t<decltype(boundTask)()>;
+
+    // wrapped for async invocation
+    using PackagedTask = std::packaged_task<ResultType()>;
+    // stored in a shared state, which can be accessed through std::future.
+    using TaskType = CompletionTask<ResultType>;
+
+    PackagedTask task{ std::move(boundTask) };
+    auto pState = std::make_shared<TaskState>();
+    TaskFuture<ResultType> result{ task.get_future(), this, pState };
+    return std::make_pair(TaskPtr{ new TaskType{ std::move(task), std::move(pState) } },
+      std::move(result));
+  }
+
+  /**
+   * Pool of futures to be combined
+   *
+   * @param futures
+   *
+   * @return
+   */
+  template <typename T>
+  static ThreadPool* combinePool(const std::vector<TaskFuture<T>>& futures)
+  {
+    if (futures.empty())
+    {
+      throw std::invalid_argument("No futures to combine");
+    }
+    for (const auto& future : futures)
+    {
+      if (!future.m_pState || future.m_pPool != futures.front().m_pPool)
+      {
+        throw std::future_error(std::future_errc::no_state);
+      }
+    }
+    return futures.front().m_pPool;
+  }
+
+  /**
+   * Completion states of futures
+   *
+   * @param futures
+   *
+   * @return
+   */
+  template <typename T>
+  static std::vector<std::shared_ptr<TaskState>> States(const std::vector<TaskFuture<T>>& futures)
+  {
+    std::vector<std::shared_ptr<TaskState>> states;
+    states.reserve(futures.size());
+    for (const auto& future : futures)
+    {
+      states.push_back(future.m_pState);
+    }
+    return states;
+  }
+
+  /**
+   * Wrap a task in a callback enqueuing it
+   *
+   * @param pTask
+   * @param priority
+   *
+   * @return Callback for TaskState::callbackAdd
+   */
+  TaskPtr deferred(TaskPtr&& pTask, const TaskPriority priority)
+  {
+    auto callback = [this, pTask = std::move(pTask), priority]() mutable -> void
+    { enqueue(std::move(pTask), priority); };
+    return TaskPtr{ new ThreadTask<decltype(callback)>{ std::move(callback) } };
+  }
+
+#if defined(SPS_COROUTINES)
+  /**
+   * Enqueue the resumption of a coroutine without allocating
+   *
+   * @param handle
+   * @param priority
+   */
+  void resume(
+    const std::coroutine_handle<> handle, const TaskPriority priority = TaskPriority::Normal)
+  {
+    TaskSlot* pSlot = slotAcquire();
+    pSlot->emplace([handle]() -> void { handle.resume(); });
+    pSlot->m_nRefs.store(1, std::memory_order_relaxed);
+    enqueue(TaskPtr{ pSlot }, priority);
+  }
+#endif
+
+  /**
+   * Bind arguments to a callable by value, like std::bind, without
+   * any allocation.
+   *
+   * @param func
+   * @param args
+   *
+   * @return
+   */
+  template <typename Func, typename... Args>
+  static auto bindInline(Func&& func, Args&&... args)
+  {
+    return [func = std::forward<Func>(func),
+             boundArgs = std::make_tuple(std::forward<Args>(args)...)]() mutable
+    { return std::apply(func, boundArgs); };
+  }
+
+  /**
+   * Acquire a task slot from the free-list. If exhausted, a slot is
+   * allocated on the heap.
+   *
+   * The head of the free-list holds the index (plus one) of the first
+   * free slot in the lower 32 bits and a tag in the upper 32 bits,
+   * which is incremented on every update to avoid ABA.
+   *
+   * @return
+   */
+  TaskSlot* slotAcquire()
+  {
+    std::uint64_t head = m_slotHead.load(std::memory_order_acquire);
+    while ((head & 0xFFFFFFFFu) != 0)
+    {
+      TaskSlot* pSlot = &m_slots[(head & 0xFFFFFFFFu) - 1];
+      const std::uint64_t next =
+        (((head >> 32) + 1) << 32) | pSlot->m_next.load(std::memory_order_relaxed);
+      if (m_slotHead.compare_exchange_weak(
+            head, next, std::memory_order_acquire, std::memory_order_acquire))
+      {
+        return pSlot;
+      }
+    }
+    TaskSlot* pSlot = new TaskSlot();
+    pSlot->m_pPool = this;
+    pSlot->m_bHeap = true;
+    return pSlot;
+  }
+
+  /**
+   * Return a task slot to the free-list (or the heap)
+   *
+   * @param pSlot
+   */
+  void slotRelease(TaskSlot* pSlot)
+  {
+    pSlot->reset();
+    if (pSlot->m_bHeap)
+    {
+      delete pSlot;
+      return;
+    }
+    const std::uint64_t index = static_cast<std::uint64_t>(pSlot - m_slots.get()) + 1;
+    std::uint64_t head = m_slotHead.load(std::memory_order_relaxed);
+    std::uint64_t next = 0;
+    do
+    {
+      pSlot->m_next.store(
+        static_cast<std::uint32_t>(head & 0xFFFFFFFFu), std::memory_order_relaxed);
+      next = (((head >> 32) + 1) << 32) | index;
+    } while (!m_slotHead.compare_exchange_weak(
+      head, next, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  /**
+   * Block until a task slot is ready. Workers of the pool run queued
+   * tasks while waiting, other threads yield briefly before sleeping.
+   *
+   * @param slot
+   */
+  void slotWait(const TaskSlot& slot)
+  {
+    if (helpUntil([&slot]() -> bool { return slot.ready(); },
+          [this, &slot]() -> void
+          {
+            std::unique_lock<std::mutex> lock{ m_slotMutex };
+            m_nSlotWaiters.fetch_add(1);
+            m_slotCondition.wait_for(lock, HelpWaitInterval, [&slot]() { return slot.ready(); });
+            m_nSlotWaiters.fetch_sub(1);
+          }))
+    {
+      return;
+    }
+    for (int i = 0; i < 64; ++i)
+    {
+      if (slot.ready())
+      {
+        return;
+      }
+      std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock{ m_slotMutex };
+    m_nSlotWaiters.fetch_add(1);
+    m_slotCondition.wait(lock, [&slot]() { return slot.ready(); });
+    m_nSlotWaiters.fetch_sub(1);
+  }
+
+  /**
+   * Wake threads waiting for task slots (if any)
+   */
+  void slotNotify()
+  {
+    if (m_nSlotWaiters.load() > 0)
+    {
+      std::lock_guard<std::mutex> guard{ m_slotMutex };
+      m_slotCondition.notify_all();
+    }
+  }
+
+  /**
+   * Enqueue a task. Normal tasks without deadline are pushed onto the
+   * local deque of the calling worker using work-stealing or onto the
+   * shared queue otherwise. All other tasks are pushed onto the queue
+   * of their priority class.
+   *
+   * @param pTask
+   * @param priority Priority class
+   * @param deadline Deadline or NoDeadline()
+   */
+  void enqueue(TaskPtr&& pTask, const TaskPriority priority = TaskPriority::Normal,
+    const std::chrono::steady_clock::time_point deadline = NoDeadline())
+  {
+    // Count before publishing, such that a task is never dequeued
+    // before it is counted
+    const WorkerContext& context = CurrentWorker();
+    pTask->m_priority = priority;
+    pTask->m_enqueued = submitted(context, priority, 1);
+
+    PriorityQueue& queue = m_priorityQueues[static_cast<std::size_t>(priority)];
+    if (priority != TaskPriority::Normal || deadline != NoDeadline())
+    {
+      std::lock_guard<std::mutex> guard{ queue.m_mutex };
+      if (deadline == NoDeadline())
+      {
+        queue.m_tasks.push_back(std::move(pTask));
+      }
+      else
+      {
+        queue.m_deadlineTasks.emplace_back(deadline, std::move(pTask));
+        std::push_heap(queue.m_deadlineTasks.begin(), queue.m_deadlineTasks.end(), LaterDeadline);
+      }
+      queue.m_nTasks.fetch_add(1);
+    }
+    else if (m_policy == SchedulingPolicy::WorkStealing && context.pPool == this)
+    {
+      WorkerQueue& local = *m_localQueues[context.iWorker];
+      std::lock_guard<std::mutex> guard{ local.m_mutex };
+      local.m_tasks.push_back(std::move(pTask));
+    }
+    else
+    {
+      pushShared(&pTask, &pTask + 1);
+    }
+    wake();
+  }
+
+  /**
+   * Enqueue normal tasks without deadline using a single queue
+   * operation, see @ref enqueue
+   *
+   * @param tasks Tasks, which are moved from
+   */
+  void enqueueBulk(std::vector<TaskPtr>& tasks)
+  {
+    const std::size_t nTasks = tasks.size();
+    const WorkerContext& context = CurrentWorker();
+    const std::chrono::steady_clock::time_point enqueued =
+      submitted(context, TaskPriority::Normal, nTasks);
+    for (TaskPtr& pTask : tasks)
+    {
+      pTask->m_priority = TaskPriority::Normal;
+      pTask->m_enqueued = enqueued;
+    }
+
+    if (m_policy == SchedulingPolicy::WorkStealing && context.pPool == this)
+    {
+      WorkerQueue& local = *m_localQueues[context.iWorker];
+      std::lock_guard<std::mutex> guard{ local.m_mutex };
+      std::move(tasks.begin(), tasks.end(), std::back_inserter(local.m_tasks));
+    }
+    else
+    {
+      pushShared(tasks.begin(), tasks.end());
+    }
+    tasks.clear();
+    wake(nTasks);
+  }
+
+  /**
+   * Count tasks submitted by the calling thread and return the time of
+   * submission. Workers count using their own counters and read the
+   * clock only every WaitSampleInterval submissions, such that the
+   * wait times of their other tasks are not sampled.
+   *
+   * @param context Context of the calling thread
+   * @param priority Priority class
+   * @param nTasks Number of tasks
+   *
+   * @return Time of submission or a default time point, if not sampled
+   */
+  std::chrono::steady_clock::time_point submitted(
+    const WorkerContext& context, const TaskPriority priority, const std::size_t nTasks)
+  {
+    const std::size_t iClass = static_cast<std::size_t>(priority);
+    if (context.pPool != this)
+    {
+      m_submitCounters[SubmitCounterIndex()].m_nSubmitted[iClass].fetch_add(
+        nTasks, std::memory_order_relaxed);
+      return std::chrono::steady_clock::now();
+    }
+    WorkerCounters& counters = m_workerCounters[context.iWorker];
+    Increment(counters.m_nSubmitted[iClass], nTasks);
+    if (counters.m_nSubmits++ % WaitSampleInterval != 0)
+    {
+      return std::chrono::steady_clock::time_point{};
+    }
+    return std::chrono::steady_clock::now();
+  }
+
+  /**
+   * Number of tasks of a class queued, not yet dequeued. Counters are
+   * aggregated over all threads, dequeues before submissions, such
+   * that a task dequeued meanwhile is not missed.
+   *
+   * @param iClass Priority class
+   *
+   * @return
+   */
+  std::uint64_t depth(const std::size_t iClass) const
+  {
+    std::uint64_t nDequeued = 0;
+    for (std::size_t i = 0; i < m_nCapacity; ++i)
+    {
+      nDequeued += m_workerCounters[i].m_nDequeued[iClass].load(std::memory_order_relaxed);
+    }
+    std::uint64_t nSubmitted = 0;
+    for (std::size_t i = 0; i < m_nCapacity; ++i)
+    {
+      nSubmitted += m_workerCounters[i].m_nSubmitted[iClass].load(std::memory_order_relaxed);
+    }
+    for (const SubmitCounter& counter : m_submitCounters)
+    {
+      nSubmitted += counter.m_nSubmitted[iClass].load(std::memory_order_relaxed);
+    }
+    return nSubmitted > nDequeued ? nSubmitted - nDequeued : 0;
+  }
+
+  /**
+   * Are tasks of a class queued. Only normal tasks are queued outside
+   * their priority queue, for which the counters are aggregated.
+   *
+   * @param iClass Priority class
+   *
+   * @return
+   */
+  bool pending(const std::size_t iClass) const
+  {
+    if (iClass == static_cast<std::size_t>(TaskPriority::Normal))
+    {
+      return depth(iClass) > 0;
+    }
+    return m_priorityQueues[iClass].m_nTasks.load(std::memory_order_relaxed) > 0;
+  }
+
+  /**
+   * Run queued tasks on the calling thread until ready() returns
+   * true, if the calling thread is a worker of this pool. If no task
+   * is queued, waitBriefly() is called, which must block for at most
+   * a short while, since tasks submitted meanwhile are not signalled.
+   *
+   * @param ready Completion predicate
+   * @param waitBriefly Blocking wait with timeout
+   *
+   * @return False if the calling thread is not a worker of this pool
+   */
+  template <typename Ready, typename Wait>
+  bool helpUntil(Ready&& ready, Wait&& waitBriefly)
+  {
+    const WorkerContext context = CurrentWorker();
+    if (context.pPool != this)
+    {
+      return false;
+    }
+    while (!ready())
+    {
+      TaskPtr pTask{ nullptr };
+      if (acquire(pTask, context.iWorker))
+      {
+        execute(*pTask, context.iWorker);
+      }
+      else
+      {
+        waitBriefly();
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Acquire a task without blocking. Classes are tried in order of
+   * priority, unless a lower class with queued tasks has been skipped
+   * StarvationLimit times, which is then tried first.
+   *
+   * @param pTask Destination
+   * @param iWorker Index of calling worker
+   *
+   * @return True if a task is written to pTask, false otherwise
+   */
+  bool acquire(TaskPtr& pTask, const std::size_t iWorker)
+  {
+    bool found = false;
+    for (std::size_t iClass = nPriorities - 1; iClass > 0 && !found; --iClass)
+    {
+      const PriorityQueue& queue = m_priorityQueues[iClass];
+      if (queue.m_nSkipped.load(std::memory_order_relaxed) >= StarvationLimit && pending(iClass))
+      {
+        found = acquireClass(pTask, iClass, iWorker);
+      }
+    }
+    for (std::size_t iClass = 0; iClass < nPriorities && !found; ++iClass)
+    {
+      found = acquireClass(pTask, iClass, iWorker);
+    }
+    if (found)
+    {
+      account(*pTask, iWorker);
+    }
+    return found;
+  }
+
+  /**
+   * Acquire a task of a priority class. Tasks with a deadline are
+   * tried first. For the normal class, then using work-stealing, the
+   * local deque is tried first, then the shared queue and finally the
+   * deques of the other workers.
+   *
+   * @param pTask Destination
+   * @param iClass Priority class
+   * @param iWorker Index of calling worker
+   *
+   * @return True if a task is written to pTask, false otherwise
+   */
+  bool acquireClass(TaskPtr& pTask, const std::size_t iClass, const std::size_t iWorker)
+  {
+    if (popPriority(pTask, iClass))
+    {
+      return true;
+    }
+    if (iClass != static_cast<std::size_t>(TaskPriority::Normal))
+    {
+      return false;
+    }
+    if (m_policy == SchedulingPolicy::WorkStealing)
+    {
+      return popLocal(pTask, iWorker) || popShared(pTask) || steal(pTask, iWorker);
+    }
+    return popShared(pTask);
+  }
+
+  /**
+   * Push normal tasks onto the shared queue. Using a bounded queue,
+   * workers never block while it is full, since they may be its only
+   * consumers. Their remaining tasks are pushed onto the overflow
+   * queue instead, while other threads block until there is space.
+   *
+   * @param first
+   * @param last
+   */
+  template <typename InputIt>
+  void pushShared(InputIt first, InputIt last)
+  {
+#if defined(SPS_USE_BOUNDED_QUEUE)
+    if (CurrentWorker().pPool == this)
+    {
+      while (first != last && m_workQueue.try_push(std::move(*first)))
+      {
+        ++first;
+      }
+      if (first != last)
+      {
+        std::lock_guard<std::mutex> guard{ m_overflow.m_mutex };
+        const std::size_t nTasks = m_overflow.m_tasks.size();
+        std::move(first, last, std::back_inserter(m_overflow.m_tasks));
+        m_nOverflow.fetch_add(m_overflow.m_tasks.size() - nTasks);
+      }
+      return;
+    }
+#endif
+    m_workQueue.push_bulk(first, last);
+  }
+
+  /**
+   * Pop a task from the shared queue. Tasks of the overflow queue are
+   * taken first, since they were pushed while the queue was full.
+   *
+   * @param pTask Destination
+   *
+   * @return True if a task is written to pTask, false otherwise
+   */
+  bool popShared(TaskPtr& pTask)
+  {
+#if defined(SPS_USE_BOUNDED_QUEUE)
+    if (m_nOverflow.load() > 0)
+    {
+      std::lock_guard<std::mutex> guard{ m_overflow.m_mutex };
+      if (!m_overflow.m_tasks.empty())
+      {
+        pTask = std::move(m_overflow.m_tasks.front());
+        m_overflow.m_tasks.pop_front();
+        m_nOverflow.fetch_sub(1);
+        return true;
+      }
+    }
+#endif
+    return m_workQueue.try_pop(pTask);
+  }
+
+  /**
+   * Pop a task from the queue of a priority class, earliest deadline
+   * first
+   *
+   * @param pTask Destination
+   * @param iClass Priority class
+   *
+   * @return True if a task is written to pTask, false otherwise
+   */
+  bool popPriority(TaskPtr& pTask, const std::size_t iClass)
+  {
+    PriorityQueue& queue = m_priorityQueues[iClass];
+    if (queue.m_nTasks.load() == 0)
+    {
+      return false;
+    }
+    std::lock_guard<std::mutex> guard{ queue.m_mutex };
+    if (!queue.m_deadlineTasks.empty())
+    {
+      std::pop_heap(queue.m_deadlineTasks.begin(), queue.m_deadlineTasks.end(), LaterDeadline);
+      pTask = std::move(queue.m_deadlineTasks.back().second);
+      queue.m_deadlineTasks.pop_back();
+    }
+    else if (!queue.m_tasks.empty())
+    {
+      pTask = std::move(queue.m_tasks.front());
+      queue.m_tasks.pop_front();
+    }
+    else
+    {
+      return false;
+    }
+    queue.m_nTasks.fetch_sub(1);
+    return true;
+  }
+
+  /**
+   * Heap order of tasks with deadline, such that the earliest
+   * deadline is on top
+   *
+   * @param a
+   * @param b
+   *
+   * @return
+   */
+  static bool LaterDeadline(
+    const PriorityQueue::DeadlineTask& a, const PriorityQueue::DeadlineTask& b)
+  {
+    return a.first > b.first;
+  }
+
+  /**
+   * Update statistics and aging for a dequeued task. The wait time is
+   * accounted only if sampled, see @ref submitted.
+   *
+   * @param task
+   * @param iWorker Index of worker dequeuing the task
+   */
+  void account(const IThreadTask& task, const std::size_t iWorker)
+  {
+    const std::size_t iClass = static_cast<std::size_t>(task.m_priority);
+    WorkerCounters& counters = m_workerCounters[iWorker];
+    counters.m_dequeued = std::chrono::steady_clock::now();
+    Increment(counters.m_nDequeued[iClass], 1);
+    if (task.m_enqueued != std::chrono::steady_clock::time_point{})
+    {
+      const std::uint64_t wait = Nanoseconds(counters.m_dequeued - task.m_enqueued);
+      Increment(counters.m_nWaits[iClass], 1);
+      Increment(counters.m_waitTotal[iClass], wait);
+      if (wait > counters.m_waitMax[iClass].load(std::memory_order_relaxed))
+      {
+        counters.m_waitMax[iClass].store(wait, std::memory_order_relaxed);
+      }
+      Increment(counters.m_waitHistogram[HistogramBin(wait)], 1);
+    }
+
+    // Lower classes with queued tasks age, the served class is reset
+    PriorityQueue& queue = m_priorityQueues[iClass];
+    if (queue.m_nSkipped.load(std::memory_order_relaxed) != 0)
+    {
+      queue.m_nSkipped.store(0, std::memory_order_relaxed);
+    }
+    for (std::size_t iLower = iClass + 1; iLower < nPriorities; ++iLower)
+    {
+      if (pending(iLower))
+      {
+        m_priorityQueues[iLower].m_nSkipped.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Execute a task dequeued by a worker and update its counters. The
+   * busy time excludes tasks executed by a worker helping while
+   * waiting inside another task.
+   *
+   * @param task
+   * @param iWorker Index of worker
+   */
+  void execute(IThreadTask& task, const std::size_t iWorker)
+  {
+    WorkerCounters& counters = m_workerCounters[iWorker];
+    const std::chrono::steady_clock::time_point start = counters.m_dequeued;
+    counters.m_depth++;
+    task.Execute();
+    counters.m_depth--;
+    const std::uint64_t elapsed = Nanoseconds(std::chrono::steady_clock::now() - start);
+    Increment(counters.m_nCompleted, 1);
+    Increment(counters.m_executionHistogram[HistogramBin(elapsed)], 1);
+    if (counters.m_depth == 0)
+    {
+      Increment(counters.m_busyTime, elapsed);
+    }
+  }
+
+  /**
+   * Add to a counter written only by the calling thread. This avoids
+   * the locked read-modify-write of fetch_add.
+   *
+   * @param counter
+   * @param value
+   */
+  static void Increment(std::atomic<std::uint64_t>& counter, const std::uint64_t value)
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+  /**
+   * Duration in nanoseconds
+   *
+   * @param duration
+   *
+   * @return
+   */
+  static std::uint64_t Nanoseconds(const std::chrono::steady_clock::duration duration)
+  {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    return ns > 0 ? static_cast<std::uint64_t>(ns) : 0;
+  }
+
+  /**
+   * Histogram bin of a time, floor(log2(ns)) limited to the number of
+   * bins
+   *
+   * @param ns
+   *
+   * @return
+   */
+  static std::size_t HistogramBin(const std::uint64_t ns)
+  {
+    std::size_t bin = 0;
+#if defined(__GNUC__)
+    bin = ns > 1 ? static_cast<std::size_t>(63 - __builtin_clzll(ns)) : 0;
+#else
+    for (std::uint64_t value = ns; value > 1; value >>= 1)
+    {
+      ++bin;
+    }
+#endif
+    return std::min<std::size_t>(bin, ThreadPoolHistogramBins - 1);
+  }
+
+  /**
+   * Submission counter used by threads outside the pool. Threads are
+   * assigned counters round-robin.
+   *
+   * @return
+   */
+  static std::size_t SubmitCounterIndex()
+  {
+    static std::atomic<std::size_t> nThreads{ 0 };
+    static thread_local const std::size_t index = nThreads.fetch_add(1) % nSubmitCounters;
+    return index;
+  }
+
+  /**
+   * Pop most recently pushed task from the local deque of a worker
+   *
+   * @param pTask Destination
+   * @param iWorker Index of worker
+   *
+   * @return True if a task is written to pTask, false otherwise
+   */
+  bool popLocal(TaskPtr& pTask, const std::size_t iWorker)
+  {
+    WorkerQueue& local = *m_localQueues[iWorker];
+    std::lock_guard<std::mutex> guard{ local.m_mutex };
+    if (local.m_tasks.empty())
+    {
+      return false;
+    }
+    pTask = std::move(local.m_tasks.back());
+    local.m_tasks.pop_back();
+    return true;
+  }
+
+  /**
+   * Steal the oldest task from the deque of another worker. Victims
+   * are visited round-robin starting after the thief. Deques locked
+   * by others are visited again, such that a failed steal implies
+   * that the deques were empty and a worker may park.
+   *
+   * @param pTask Destination
+   * @param iWorker Index of thief
+   *
+   * @return True if a task is written to pTask, false otherwise
+   */
+  bool steal(TaskPtr& pTask, const std::size_t iWorker)
+  {
+    // Removed workers hand over their tasks, so only active deques are visited
+    const std::size_t nWorkers = std::max(m_nWorkers.load(std::memory_order_relaxed), iWorker + 1);
+    bool contended = true;
+    while (contended)
+    {
+      contended = false;
+      for (std::size_t i = 1u; i < nWorkers; ++i)
+      {
+        WorkerQueue& victim = *m_localQueues[(iWorker + i) % nWorkers];
+        std::unique_lock<std::mutex> lock{ victim.m_mutex, std::try_to_lock };
+        if (!lock.owns_lock())
+        {
+          contended = true;
+        }
+        else if (!victim.m_tasks.empty())
+        {
+          pTask = std::move(victim.m_tasks.front());
+          victim.m_tasks.pop_front();
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Park calling worker until signalled, removed or the pool is
+   * destroyed. The worker is counted as parked before it stops
+   * counting as spinning, see @ref wake.
+   *
+   * @param iWorker Index of worker
+   * @param signal Signal count seen before the last attempt to acquire a task
+   */
+  void park(const std::size_t iWorker, const std::uint64_t signal)
+  {
+    std::unique_lock<std::mutex> lock{ m_parkMutex };
+    m_nParked.fetch_add(1);
+    m_nSpinning.fetch_sub(1);
+    m_parkCondition.wait(lock,
+      [this, iWorker, signal]()
+      { return m_done || m_nSignals.load() != signal || iWorker >= m_nWorkers.load(); });
+    m_nParked.fetch_sub(1);
+  }
+
+  /**
+   * Poll for a task before parking according to the idle policy. The
+   * worker spins on the signal count, which is read without locking,
+   * then yields its time slice a number of times. Using
+   * IdlePolicy::Adaptive, the spin budget of the worker is doubled if
+   * a task arrives while spinning and halved otherwise.
+   *
+   * @param pTask Destination
+   * @param iWorker Index of worker
+   * @param signal Signal count seen, updated when signalled
+   *
+   * @return True if a task is written to pTask, false if the worker
+   *         should park
+   */
+  bool spin(TaskPtr& pTask, const std::size_t iWorker, std::uint64_t& signal)
+  {
+    if (m_idle == IdlePolicy::Park)
+    {
+      return false;
+    }
+    WorkerCounters& counters = m_workerCounters[iWorker];
+    const std::uint32_t nSpins = m_idle == IdlePolicy::Adaptive ? counters.m_nSpins : m_nSpins;
+    bool found = false;
+    for (std::uint32_t i = 0; i < nSpins + m_nYields && !found; ++i)
+    {
+      if (m_done || iWorker >= m_nWorkers.load(std::memory_order_relaxed))
+      {
+        break;
+      }
+      if (i < nSpins)
+      {
+        sps_cpu_relax();
+      }
+      else
+      {
+        std::this_thread::yield();
+      }
+      if (m_nSignals.load(std::memory_order_relaxed) != signal)
+      {
+        signal = m_nSignals.load();
+        found = acquire(pTask, iWorker);
+      }
+    }
+    if (m_idle == IdlePolicy::Adaptive)
+    {
+      counters.m_nSpins = found ? std::min(m_nSpins, std::max(MinSpins, 2 * nSpins))
+                                : std::max(MinSpins, nSpins / 2);
+    }
+    return found;
+  }
+
+  /**
+   * Wait for a task, after failing to acquire one. The worker counts
+   * as spinning, before it retries, while submitters publish a task
+   * before checking for idle workers. Both are sequentially
+   * consistent, so either the worker sees the task or the submitter
+   * sees the worker and signals it. The worker then spins and parks
+   * until signalled.
+   *
+   * @param pTask Destination
+   * @param iWorker Index of worker
+   *
+   * @return True if a task is written to pTask, false if the worker
+   *         has been parked
+   */
+  bool idle(TaskPtr& pTask, const std::size_t iWorker)
+  {
+    m_nSpinning.fetch_add(1);
+    std::uint64_t signal = m_nSignals.load();
+    if (acquire(pTask, iWorker) || spin(pTask, iWorker, signal))
+    {
+      m_nSpinning.fetch_sub(1);
+      return true;
+    }
+    park(iWorker, signal);
+    return false;
+  }
+
+  /**
+   * Signal idle workers (if any). Global state is written only if a
+   * worker is spinning or parked, such that submitting to a busy
+   * pool touches no shared cache line besides the queue.
+   *
+   * @param nTasks Number of tasks queued
+   */
+  void wake(const std::size_t nTasks = 1)
+  {
+    // Publishing the tasks precedes checking for idle workers
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_nSpinning.load() == 0 && m_nParked.load() == 0)
+    {
+      return;
+    }
+    m_nSignals.fetch_add(1);
+    // Spinning workers see the signal without being notified. A
+    // spinning worker about to park is counted as parked first.
+    if (m_nParked.load() > 0 && m_nSpinning.load() < nTasks)
+    {
+      std::lock_guard<std::mutex> guard{ m_parkMutex };
+      if (nTasks > 1)
+      {
+        m_parkCondition.notify_all();
+      }
+      else
+      {
+        m_parkCondition.notify_one();
+      }
+    }
+  }
+
+  /**
+   * Constantly running function each thread uses to acquire work items from the queue.
+   *
+   * @param iWorker Index of worker
+   */
+  void worker(const std::size_t iWorker)
+  {
+    CurrentWorker() = WorkerContext{ this, iWorker };
+    if (!m_cpus.empty())
+    {
+      // Failure is reported, the worker continues unpinned
+      setcpuid(cpu(iWorker));
+    }
+    WorkerCounters& counters = m_workerCounters[iWorker];
+    while (!m_done && iWorker < m_nWorkers.load())
+    {
+      TaskPtr pTask{ nullptr };
+      if (acquire(pTask, iWorker))
+      {
+        execute(*pTask, iWorker);
+      }
+      else
+      {
+        const std::uint64_t start =
+          Nanoseconds(std::chrono::steady_clock::now().time_since_epoch());
+        counters.m_parkedSince.store(start, std::memory_order_relaxed);
+        const bool found = idle(pTask, iWorker);
+        counters.m_parkedSince.store(0, std::memory_order_relaxed);
+        const std::uint64_t stop =
+          Nanoseconds(std::chrono::steady_clock::now().time_since_epoch());
+        Increment(counters.m_idleTime, stop - start);
+        if (found)
+        {
+          execute(*pTask, iWorker);
+        }
+      }
+    }
+    if (!m_done && m_policy == SchedulingPolicy::WorkStealing)
+    {
+      // Removed by resize, hand over tasks of the local deque
+      WorkerQueue& local = *m_localQueues[iWorker];
+      std::lock_guard<std::mutex> guard{ local.m_mutex };
+      pushShared(local.m_tasks.begin(), local.m_tasks.end());
+      local.m_tasks.clear();
+    }
+    if (!m_done)
+    {
+      // A submitter may have relied on this worker spinning
+      wake();
+    }
+    CurrentWorker() = WorkerContext{ nullptr, 0 };
+  }
+
+  /**
+   * Invalidates the queue and joins all running threads.
+   */
+  void destroy()
+  {
+    m_done = true;
+    {
+      std::lock_guard<std::mutex> guard{ m_parkMutex };
+      m_parkCondition.notify_all();
+    }
+    m_workQueue.invalidate();
+    for (auto& thread : m_threads)
+    {
+      if (thread.joinable())
+      {
+        thread.join();
+      }
+    }
+  }
+
+private:
+  std::atomic<int> m_nThreadsOnHold;                       ///< Threads on hold
+  std::atomic_bool m_done;                                 ///< Are we done?
+  const SchedulingPolicy m_policy;                         ///< Scheduling policy
+  const IdlePolicy m_idle;                                 ///< Idle policy
+  const std::uint32_t m_nSpins;                            ///< Spin budget (maximum)
+  const std::uint32_t m_nYields;                           ///< Yields before parking
+  const std::vector<int> m_cpus;                           ///< CPUs of workers (if pinned)
+  const std::size_t m_nCapacity;                           ///< Maximum number of workers
+  std::atomic<std::size_t> m_nWorkers;                     ///< Number of active workers
+  std::mutex m_resizeMutex;                                ///< Mutex for resizing
+  std::atomic<std::uint64_t> m_nSignals;                   ///< Signals sent to idle workers
+  std::atomic<std::size_t> m_nParked;                      ///< Workers parked
+  std::atomic<std::size_t> m_nSpinning;                    ///< Workers spinning
+  std::mutex m_parkMutex;                                  ///< Mutex for parking
+  std::condition_variable m_parkCondition;                 ///< Condition for signal work
+  std::atomic<std::size_t> m_nSlotWaiters;                 ///< Threads waiting for task slots
+  std::mutex m_slotMutex;                                  ///< Mutex for slot completion
+  std::condition_variable m_slotCondition;                 ///< Condition for slot completion
+  std::unique_ptr<TaskSlot[]> m_slots;                     ///< Task slots, must outlive queues
+  std::atomic<std::uint64_t> m_slotHead;                   ///< Free-list head (tag, index + 1)
+  QueueImpl<TaskPtr> m_workQueue;                          ///< Work queue
+#if defined(SPS_USE_BOUNDED_QUEUE)
+  WorkerQueue m_overflow;                                  ///< Tasks of workers, queue full
+  std::atomic<std::size_t> m_nOverflow;                    ///< Tasks of overflow queue
+#endif
+  std::vector<std::unique_ptr<WorkerQueue>> m_localQueues; ///< Worker deques (work-stealing)
+  PriorityQueue m_priorityQueues[nPriorities];             ///< Queues of priority classes
+  std::unique_ptr<WorkerCounters[]> m_workerCounters;      ///< Instrumentation of workers
+  SubmitCounter m_submitCounters[nSubmitCounters];         ///< Submissions from outside
+  std::vector<std::thread> m_threads;                      ///< Threads in the pool
+};
+
+/**
+ * Future completing when all futures have completed, see @ref
+ * ThreadPool::when_all
+ *
+ * @param futures
+ *
+ * @return
+ */
+template <typename T>
+inline auto when_all(std::vector<ThreadPool::TaskFuture<T>>&& futures)
+{
+  return ThreadPool::when_all(std::move(futures));
+}
+
+/**
+ * Future completing when any of the futures has completed, see @ref
+ * ThreadPool::when_any
+ *
+ * @param futures
+ *
+ * @return
+ */
+template <typename T>
+inline auto when_any(std::vector<ThreadPool::TaskFuture<T>>&& futures)
+{
+  return ThreadPool::when_any(std::move(futures));
+}
 
 namespace thread
 {
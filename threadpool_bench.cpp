@@ -0,0 +1,153 @@
+/**
+ * @file   threadpool_bench.cpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Sat Oct 17 14:02:11 2026
+ *
+ * @brief  Throughput of the task submission paths of sps::ThreadPool
+ *
+ * Usage: threadpool_bench [nThreads] [nTasks]
+ *
+ * Copyright 2026 Jens Munk Hansen
+ */
+
+#include <sps/threadpool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+/**
+ * Run and time a benchmark
+ *
+ * @param name Name printed
+ * @param nTasks Number of tasks submitted by bench
+ * @param bench Callable submitting and completing nTasks tasks
+ */
+template <typename Bench>
+void Run(const char* name, const size_t nTasks, Bench&& bench)
+{
+  const auto start = std::chrono::steady_clock::now();
+  bench();
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  printf("%-32s %14.0f tasks/s\n", name, static_cast<double>(nTasks) / elapsed.count());
+}
+
+void WaitFor(const std::atomic<size_t>& counter, const size_t n)
+{
+  while (counter.load() < n)
+  {
+    std::this_thread::yield();
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  const size_t nThreads = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 4;
+  const size_t nTasks = argc > 2 ? static_cast<size_t>(atoi(argv[2])) : 1000000;
+  // Tasks per batch, when waiting for results
+  const size_t nBatch = 256;
+
+  printf("threads: %zu, tasks: %zu\n", nThreads, nTasks);
+
+  for (const auto policy :
+    { sps::SchedulingPolicy::SharedQueue, sps::SchedulingPolicy::WorkStealing })
+  {
+    sps::ThreadPool pool(nThreads, policy);
+    printf("%s\n", policy == sps::SchedulingPolicy::SharedQueue ? "shared queue" : "work stealing");
+
+    std::atomic<size_t> nExecuted{ 0 };
+
+    Run("  submit + Detach", nTasks,
+      [&]()
+      {
+        nExecuted = 0;
+        for (size_t i = 0; i < nTasks; i++)
+        {
+          pool.submit([&]() -> void { nExecuted++; }).Detach();
+        }
+        WaitFor(nExecuted, nTasks);
+      });
+
+    Run("  post", nTasks,
+      [&]()
+      {
+        nExecuted = 0;
+        for (size_t i = 0; i < nTasks; i++)
+        {
+          pool.post([&]() -> void { nExecuted++; });
+        }
+        WaitFor(nExecuted, nTasks);
+      });
+
+    Run("  submit + Get (batched)", nTasks,
+      [&]()
+      {
+        std::vector<sps::ThreadPool::TaskFuture<size_t>> futures;
+        futures.reserve(nBatch);
+        for (size_t i = 0; i < nTasks; i += nBatch)
+        {
+          for (size_t j = 0; j < nBatch; j++)
+          {
+            futures.push_back(pool.submit([](size_t a) -> size_t { return a; }, j));
+          }
+          for (auto& future : futures)
+          {
+            future.Get();
+          }
+          futures.clear();
+        }
+      });
+
+    Run("  submitInline + Get (batched)", nTasks,
+      [&]()
+      {
+        std::vector<sps::ThreadPool::SlotFuture<size_t>> futures;
+        futures.reserve(nBatch);
+        for (size_t i = 0; i < nTasks; i += nBatch)
+        {
+          for (size_t j = 0; j < nBatch; j++)
+          {
+            futures.push_back(pool.submitInline([](size_t a) -> size_t { return a; }, j));
+          }
+          for (auto& future : futures)
+          {
+            future.Get();
+          }
+          futures.clear();
+        }
+      });
+  }
+
+  // Round trips of single tasks, dominated by waking idle workers
+  const size_t nRoundTrips = nTasks / 16;
+  for (const auto idle :
+    { sps::IdlePolicy::Park, sps::IdlePolicy::Spin, sps::IdlePolicy::Adaptive })
+  {
+    sps::ThreadPoolOptions options;
+    options.nThreads = nThreads;
+    options.idle = idle;
+    sps::ThreadPool pool(options);
+    const sps::IdlePolicy used = pool.idlePolicy();
+    printf("%s\n",
+      used == sps::IdlePolicy::Park ? "park"
+                                    : (used == sps::IdlePolicy::Spin ? "spin" : "adaptive"));
+
+    Run("  submitInline + Get (round trip)", nRoundTrips,
+      [&]()
+      {
+        for (size_t i = 0; i < nRoundTrips; i++)
+        {
+          pool.submitInline([](size_t a) -> size_t { return a; }, i).Get();
+        }
+      });
+  }
+  return 0;
+}
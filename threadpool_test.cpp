@@ -1,17 +1,52 @@
 #include <gtest/gtest.h>
 #include <sps/cenv.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstdlib>
 #include <iostream>
 #include <mutex>
 #include <random>
+#include <vector>
 
 #include <sps/threadpool.hpp>
 
 #include <sps/if_threadpool.hpp>
 
+// Count allocations made through the global allocator
+static std::atomic<bool> g_countAllocations{ false };
+static std::atomic<size_t> g_nAllocations{ 0 };
+
+void* operator new(std::size_t size)
+{
+  if (g_countAllocations)
+  {
+    g_nAllocations++;
+  }
+  void* p = std::malloc(size);
+  if (!p)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+// Not inlined, GCC warns about free() of memory from operator new
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  ::operator delete(p);
+}
+
 TEST(threadpool_test, test_nothing)
 {
   EXPECT_EQ(1, 1);
@@ -275,6 +310,717 @@ TEST(threadpool_test, two_threads_pushing_tasks)
 }
 //}
 
+/**
+ * Test that work-stealing executes tasks submitted from outside the
+ * pool, which are all pushed onto the shared queue.
+ *
+ */
+TEST(threadpool_test, work_stealing_external_submit)
+{
+  sps::ThreadPool pool(4, sps::SchedulingPolicy::WorkStealing);
+  EXPECT_EQ(pool.policy(), sps::SchedulingPolicy::WorkStealing);
+
+  std::vector<sps::ThreadPool::TaskFuture<int>> futures;
+  for (int i = 0; i < 1000; i++)
+  {
+    futures.push_back(pool.submit([](int a) -> int { return 2 * a; }, i));
+  }
+  int sum = 0;
+  for (auto& future : futures)
+  {
+    sum += future.Get();
+  }
+  EXPECT_EQ(sum, 999 * 1000);
+}
+
+/**
+ * Test that tasks submitted from a busy worker, which are pushed onto
+ * its local deque, are stolen and executed by the other workers.
+ *
+ */
+TEST(threadpool_test, work_stealing_steal)
+{
+  const int nSubTasks = 64;
+  std::atomic<int> nExecuted{ 0 };
+
+  sps::ThreadPool pool(4, sps::SchedulingPolicy::WorkStealing);
+
+  auto outer = pool.submit(
+    [&]() -> bool
+    {
+      for (int i = 0; i < nSubTasks; i++)
+      {
+        pool.submit([&]() -> void { nExecuted++; }).Detach();
+      }
+      // Keep the submitting worker busy. Sub-tasks must be stolen
+      const auto begin = std::chrono::steady_clock::now();
+      while (nExecuted.load() < nSubTasks &&
+        std::chrono::steady_clock::now() - begin < std::chrono::seconds(5))
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      return nExecuted.load() == nSubTasks;
+    });
+
+  EXPECT_TRUE(outer.Get());
+}
+
+/**
+ * Test submission using inline task slots
+ *
+ */
+TEST(threadpool_test, submit_inline)
+{
+  sps::ThreadPool pool(2);
+
+  auto taskFuture0 = pool.submitInline([](int a, float b) -> int
+    { return FunctionReadingAndReturningVariables(a, b); },
+    5, 10.0f);
+  EXPECT_EQ(taskFuture0.Get(), 15);
+
+  auto taskFuture1 = pool.submitInline([]() -> int { throw std::runtime_error("failure"); });
+  EXPECT_THROW(taskFuture1.Get(), std::runtime_error);
+
+  std::atomic<int> nExecuted{ 0 };
+  for (int i = 0; i < 100; i++)
+  {
+    pool.post([&]() -> void { nExecuted++; });
+  }
+  auto taskFuture2 = pool.submitInline([&]() -> void { nExecuted++; });
+  taskFuture2.Get();
+
+  const auto begin = std::chrono::steady_clock::now();
+  while (nExecuted.load() < 101 &&
+    std::chrono::steady_clock::now() - begin < std::chrono::seconds(5))
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(nExecuted.load(), 101);
+}
+
+/**
+ * Test that more tasks than pooled slots can be queued. Surplus slots
+ * are allocated on the heap.
+ *
+ */
+TEST(threadpool_test, submit_inline_exhausted)
+{
+  sps::ThreadPool pool(1);
+  std::atomic<bool> release{ false };
+  std::atomic<size_t> nExecuted{ 0 };
+
+  // Block the single worker
+  pool.post(
+    [&]() -> void
+    {
+      while (!release.load())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+
+  std::vector<sps::ThreadPool::SlotFuture<size_t>> futures;
+  for (size_t i = 0; i < 2 * sps::ThreadPool::nTaskSlots; i++)
+  {
+    futures.push_back(pool.submitInline([&, i]() -> size_t
+      {
+        nExecuted++;
+        return i;
+      }));
+  }
+  release = true;
+
+  size_t sum = 0;
+  for (auto& future : futures)
+  {
+    sum += future.Get();
+  }
+  const size_t n = 2 * sps::ThreadPool::nTaskSlots;
+  EXPECT_EQ(sum, n * (n - 1) / 2);
+  EXPECT_EQ(nExecuted.load(), n);
+}
+
+/**
+ * Test that posting and waiting for tasks using slots does not
+ * allocate per task. The work queue itself allocates a block for
+ * every 64 elements.
+ *
+ */
+TEST(threadpool_test, submit_inline_allocation_free)
+{
+  const size_t nTasks = 10000;
+  std::atomic<size_t> nExecuted{ 0 };
+  sps::ThreadPool pool(1);
+
+  // Warm up
+  pool.submitInline([]() -> int { return 0; }).Get();
+
+  g_nAllocations = 0;
+  g_countAllocations = true;
+  for (size_t i = 0; i < nTasks; i++)
+  {
+    pool.post([&]() -> void { nExecuted++; });
+    if (i % 100 == 0)
+    {
+      auto future = pool.submitInline([](size_t a) -> size_t { return a; }, i);
+      EXPECT_EQ(future.Get(), i);
+    }
+  }
+  while (nExecuted.load() < nTasks)
+  {
+    std::this_thread::yield();
+  }
+  g_countAllocations = false;
+
+  EXPECT_LT(g_nAllocations.load(), nTasks / 32);
+}
+
+/**
+ * Test that a task waiting for its sub-tasks on a one-thread pool
+ * completes. The waiting worker runs the sub-tasks itself.
+ *
+ */
+TEST(threadpool_test, help_while_waiting)
+{
+  for (const auto policy :
+    { sps::SchedulingPolicy::SharedQueue, sps::SchedulingPolicy::WorkStealing })
+  {
+    sps::ThreadPool pool(1, policy);
+
+    auto outer = pool.submit(
+      [&]() -> int
+      {
+        auto inner0 = pool.submit([](int a) -> int { return 2 * a; }, 10);
+        auto inner1 = pool.submitInline([](int a) -> int { return 3 * a; }, 10);
+        int sum = inner0.Get() + inner1.Get();
+        {
+          // Destructor waits for the task
+          auto inner2 = pool.submit([&sum]() -> void { sum += 1; });
+        }
+        return sum;
+      });
+    EXPECT_EQ(outer.Get(), 51);
+  }
+}
+
+/**
+ * Test a task posting more tasks than the capacity of a bounded work
+ * queue on a one-thread pool. The worker is the only consumer, so it
+ * must never block submitting.
+ *
+ */
+TEST(threadpool_test, fan_out)
+{
+  for (const auto policy :
+    { sps::SchedulingPolicy::SharedQueue, sps::SchedulingPolicy::WorkStealing })
+  {
+    sps::ThreadPool pool(1, policy);
+    const int nSubTasks = 5000;
+    std::atomic<int> nExecuted{ 0 };
+
+    pool
+      .submit(
+        [&]() -> void
+        {
+          for (int i = 0; i < nSubTasks; i++)
+          {
+            pool.post([&]() -> void { nExecuted++; });
+          }
+          pool.submitBulk(nSubTasks, [&](std::size_t) -> void { nExecuted++; }).Detach();
+        })
+      .Get();
+    auto last = pool.submit([]() -> void {});
+    last.Get();
+    while (nExecuted.load() < 2 * nSubTasks)
+    {
+      std::this_thread::yield();
+    }
+    EXPECT_EQ(nExecuted.load(), 2 * nSubTasks);
+  }
+}
+
+/**
+ * Test placement of workers. Excluded CPUs are never used and every
+ * policy uses each available CPU once.
+ *
+ */
+TEST(threadpool_test, affinity)
+{
+  const std::vector<sps::CpuInfo> topology = sps::CpuTopologyGet();
+  ASSERT_FALSE(topology.empty());
+  const int first = topology.front().cpu;
+
+  for (const auto policy : { sps::AffinityPolicy::Compact, sps::AffinityPolicy::ScatterSocket,
+         sps::AffinityPolicy::ScatterCache })
+  {
+    std::vector<int> cpus = sps::AffinityCpusGet(policy);
+    EXPECT_EQ(cpus.size(), topology.size());
+    std::sort(cpus.begin(), cpus.end());
+    EXPECT_TRUE(std::adjacent_find(cpus.begin(), cpus.end()) == cpus.end());
+
+    if (topology.size() > 1)
+    {
+      cpus = sps::AffinityCpusGet(policy, {}, { first });
+      EXPECT_EQ(cpus.size(), topology.size() - 1);
+      EXPECT_TRUE(std::find(cpus.begin(), cpus.end(), first) == cpus.end());
+    }
+
+    // All CPUs excluded
+    std::vector<int> excluded;
+    for (const sps::CpuInfo& info : topology)
+    {
+      excluded.push_back(info.cpu);
+    }
+    EXPECT_THROW(sps::AffinityCpusGet(policy, {}, excluded), std::invalid_argument);
+  }
+  EXPECT_TRUE(sps::AffinityCpusGet(sps::AffinityPolicy::None).empty());
+
+  sps::ThreadPoolOptions invalid;
+  invalid.affinity = sps::AffinityPolicy::Explicit;
+  EXPECT_THROW(sps::ThreadPool{ invalid }, std::invalid_argument);
+  invalid.cpus = { first };
+  invalid.excludedCpus = { first };
+  EXPECT_THROW(sps::ThreadPool{ invalid }, std::invalid_argument);
+
+  sps::ThreadPoolOptions options;
+  options.nThreads = 2;
+  options.affinity = sps::AffinityPolicy::Explicit;
+  options.cpus = { first };
+  sps::ThreadPool pool(options);
+  EXPECT_EQ(pool.cpu(0), first);
+  EXPECT_EQ(pool.cpu(1), first);
+#if defined(__linux__)
+  for (int i = 0; i < 10; i++)
+  {
+    EXPECT_EQ(pool.submit([]() -> int { return sched_getcpu(); }).Get(), first);
+  }
+#endif
+}
+
+/**
+ * Test that tasks are dequeued by priority class and by deadline
+ * within a class. The single worker is blocked while submitting.
+ *
+ */
+TEST(threadpool_test, priorities)
+{
+  sps::ThreadPool pool(1);
+  std::atomic<bool> release{ false };
+  std::mutex orderMutex;
+  std::vector<int> order;
+
+  auto block = pool.submit(
+    [&]() -> void
+    {
+      while (!release.load())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+  // Wait until the blocking task is dequeued
+  while (pool.statistics(sps::TaskPriority::Normal).depth > 0)
+  {
+    std::this_thread::yield();
+  }
+
+  const auto record = [&](int value) -> void
+  {
+    std::lock_guard<std::mutex> guard{ orderMutex };
+    order.push_back(value);
+  };
+  const auto now = std::chrono::steady_clock::now();
+  std::vector<sps::ThreadPool::TaskFuture<void>> futures;
+  futures.push_back(pool.submit(sps::TaskPriority::Low, record, 5));
+  futures.push_back(pool.submit(record, 4));
+  futures.push_back(pool.submit(sps::TaskPriority::High, record, 3));
+  futures.push_back(
+    pool.submit(sps::TaskPriority::High, now + std::chrono::seconds(2), record, 2));
+  futures.push_back(
+    pool.submit(sps::TaskPriority::High, now + std::chrono::seconds(1), record, 1));
+
+  EXPECT_EQ(pool.statistics(sps::TaskPriority::High).depth, 3u);
+  EXPECT_EQ(pool.statistics(sps::TaskPriority::Normal).depth, 1u);
+  EXPECT_EQ(pool.statistics(sps::TaskPriority::Low).depth, 1u);
+
+  release = true;
+  futures.clear();
+  EXPECT_EQ(order, std::vector<int>({ 1, 2, 3, 4, 5 }));
+
+  const sps::TaskClassStatistics statistics = pool.statistics(sps::TaskPriority::High);
+  EXPECT_EQ(statistics.depth, 0u);
+  EXPECT_EQ(statistics.nExecuted, 3u);
+  EXPECT_GT(statistics.maxWait, 0.0);
+  EXPECT_LE(statistics.meanWait, statistics.maxWait);
+}
+
+/**
+ * Test that a low-priority task is served, while high-priority tasks
+ * are queued.
+ *
+ */
+TEST(threadpool_test, priorities_no_starvation)
+{
+  sps::ThreadPool pool(1);
+  std::atomic<bool> release{ false };
+  std::atomic<size_t> nExecuted{ 0 };
+  std::atomic<size_t> lowPosition{ 0 };
+
+  pool.post(
+    [&]() -> void
+    {
+      while (!release.load())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+  while (pool.statistics(sps::TaskPriority::Normal).depth > 0)
+  {
+    std::this_thread::yield();
+  }
+
+  std::vector<sps::ThreadPool::TaskFuture<void>> futures;
+  futures.push_back(
+    pool.submit(sps::TaskPriority::Low, [&]() -> void { lowPosition = nExecuted++; }));
+  for (size_t i = 0; i < 4 * sps::ThreadPool::StarvationLimit; i++)
+  {
+    futures.push_back(pool.submit(sps::TaskPriority::High, [&]() -> void { nExecuted++; }));
+  }
+  release = true;
+  futures.clear();
+  EXPECT_LE(lowPosition.load(), sps::ThreadPool::StarvationLimit);
+}
+
+/**
+ * Test continuations. A chain of stages completes on a one-thread
+ * pool and exceptions propagate through the chain.
+ *
+ */
+TEST(threadpool_test, continuations)
+{
+  sps::ThreadPool pool(1);
+
+  auto future = pool.submit([]() -> int { return 2; })
+                  .then([](sps::ThreadPool::TaskFuture<int> a) -> int { return 3 * a.Get(); })
+                  .then([](sps::ThreadPool::TaskFuture<int> a) -> int { return a.Get() + 1; });
+  EXPECT_EQ(future.Get(), 7);
+
+  auto failed =
+    pool.submit([]() -> int { throw std::runtime_error("failure"); })
+      .then([](sps::ThreadPool::TaskFuture<int> a) -> int { return a.Get() + 1; })
+      .then([](sps::ThreadPool::TaskFuture<int> a) -> bool
+        {
+          try
+          {
+            a.Get();
+          }
+          catch (const std::runtime_error&)
+          {
+            return true;
+          }
+          return false;
+        });
+  EXPECT_TRUE(failed.Get());
+
+  // Continuation attached after completion
+  auto ready = pool.submit([]() -> int { return 1; });
+  while (!ready.Ready())
+  {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(ready.then([](sps::ThreadPool::TaskFuture<int> a) -> int { return a.Get(); }).Get(), 1);
+}
+
+/**
+ * Test tearing down a pool with continuations of pending tasks. The
+ * tasks are discarded, which must neither execute nor block on the
+ * continuations owning their futures.
+ *
+ */
+TEST(threadpool_test, teardown_pending_continuations)
+{
+  std::atomic<int> nExecuted{ 0 };
+  {
+    sps::ThreadPool pool(1);
+    sps::CancellationSource source;
+
+    pool.submit([]() -> void { std::this_thread::sleep_for(std::chrono::milliseconds(50)); })
+      .Detach();
+    pool.submit([]() -> int { return 1; })
+      .then([&](sps::ThreadPool::TaskFuture<int> a) -> int { return nExecuted += a.Get(); })
+      .Detach();
+    pool.submit(source.token(), []() -> int { return 1; })
+      .then([&](sps::ThreadPool::TaskFuture<int> a) -> int { return nExecuted += a.Get(); })
+      .Detach();
+
+    std::vector<sps::ThreadPool::TaskFuture<int>> futures;
+    futures.push_back(pool.submit([]() -> int { return 1; }));
+    futures.push_back(pool.submit([]() -> int { return 1; }));
+    sps::when_all(std::move(futures)).Detach();
+    futures.clear();
+    futures.push_back(pool.submit([]() -> int { return 1; }));
+    sps::when_any(std::move(futures)).Detach();
+  }
+  EXPECT_EQ(nExecuted.load(), 0);
+}
+
+TEST(threadpool_test, when_all_when_any)
+{
+  sps::ThreadPool pool(2);
+
+  std::vector<sps::ThreadPool::TaskFuture<int>> futures;
+  for (int i = 0; i < 10; i++)
+  {
+    futures.push_back(pool.submit([](int a) -> int { return a; }, i));
+  }
+  auto sum = sps::when_all(std::move(futures))
+               .then(
+                 [](sps::ThreadPool::TaskFuture<std::vector<sps::ThreadPool::TaskFuture<int>>> all)
+                   -> int
+                 {
+                   int result = 0;
+                   for (auto& future : all.Get())
+                   {
+                     result += future.Get();
+                   }
+                   return result;
+                 });
+  EXPECT_EQ(sum.Get(), 45);
+
+  std::atomic<bool> release{ false };
+  futures.clear();
+  futures.push_back(pool.submit(
+    [&]() -> int
+    {
+      while (!release.load())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      return 0;
+    }));
+  futures.push_back(pool.submit([]() -> int { return 1; }));
+  auto any = sps::when_any(std::move(futures)).Get();
+  EXPECT_EQ(any.index, 1u);
+  EXPECT_EQ(any.futures[1].Get(), 1);
+  release = true;
+  EXPECT_EQ(any.futures[0].Get(), 0);
+}
+
+/**
+ * Test cancellation tokens. Tasks queued behind a blocking task are
+ * cancelled, their futures and continuations report the cancellation
+ * before the worker is released, and the tasks are never executed.
+ *
+ */
+TEST(threadpool_test, cancellation)
+{
+  sps::ThreadPool pool(1);
+  std::atomic<bool> release{ false };
+  std::atomic<int> nExecuted{ 0 };
+
+  auto block = pool.submit(
+    [&]() -> void
+    {
+      while (!release.load())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+
+  sps::CancellationSource stale;
+  sps::CancellationSource current;
+  std::vector<sps::ThreadPool::TaskFuture<int>> futures;
+  for (int i = 0; i < 10; i++)
+  {
+    futures.push_back(pool.submit(stale.token(), [&](int a) -> int { return nExecuted += a; }, 1));
+  }
+  auto kept = pool.submit(sps::TaskPriority::High, current.token(), [&]() -> int { return 1; });
+  auto chained = pool.submit(stale.token(), []() -> int { return 1; })
+                   .then(
+                     [](sps::ThreadPool::TaskFuture<int> a) -> bool
+                     {
+                       try
+                       {
+                         a.Get();
+                       }
+                       catch (const sps::TaskCancelled&)
+                       {
+                         return true;
+                       }
+                       return false;
+                     });
+
+  EXPECT_EQ(stale.cancel(), 11u);
+  EXPECT_TRUE(stale.cancelled());
+  EXPECT_FALSE(current.cancelled());
+  for (auto& future : futures)
+  {
+    EXPECT_TRUE(future.Ready());
+    EXPECT_THROW(future.Get(), sps::TaskCancelled);
+  }
+
+  // Submitted after cancellation
+  auto late = pool.submit(stale.token(), [&]() -> void { nExecuted++; });
+  EXPECT_THROW(late.Get(), sps::TaskCancelled);
+
+  release = true;
+  EXPECT_TRUE(chained.Get());
+  EXPECT_EQ(kept.Get(), 1);
+  EXPECT_EQ(current.cancel(), 0u);
+  EXPECT_EQ(nExecuted.load(), 0);
+
+  // Default token is never cancelled
+  EXPECT_EQ(pool.submit(sps::CancellationToken{}, []() -> int { return 2; }).Get(), 2);
+}
+
+/**
+ * Test instrumentation counters through the C++ and the C interface
+ *
+ */
+TEST(threadpool_test, statistics)
+{
+  const uint64_t nTasks = 100;
+  sps::ThreadPool pool(2);
+
+  std::vector<sps::ThreadPool::TaskFuture<void>> futures;
+  for (uint64_t i = 0; i < nTasks; i++)
+  {
+    futures.push_back(
+      pool.submit([]() -> void { std::this_thread::sleep_for(std::chrono::microseconds(100)); }));
+  }
+  futures.clear();
+  // Let the workers park
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  const sps::ThreadPoolStatistics statistics = pool.statistics();
+  EXPECT_EQ(statistics.nSubmitted, nTasks);
+  EXPECT_EQ(statistics.nCompleted, nTasks);
+  EXPECT_EQ(statistics.queueDepth, 0u);
+  uint64_t nWaits = 0;
+  uint64_t nExecutions = 0;
+  uint64_t nLong = 0;
+  for (size_t iBin = 0; iBin < sps::ThreadPoolHistogramBins; iBin++)
+  {
+    nWaits += statistics.waitHistogram[iBin];
+    nExecutions += statistics.executionHistogram[iBin];
+    // At least 2^16 ns
+    nLong += iBin >= 16 ? statistics.executionHistogram[iBin] : 0;
+  }
+  EXPECT_EQ(nWaits, nTasks);
+  EXPECT_EQ(nExecutions, nTasks);
+  EXPECT_EQ(nLong, nTasks);
+
+  uint64_t nCompleted = 0;
+  for (size_t iWorker = 0; iWorker < pool.size(); iWorker++)
+  {
+    const sps::ThreadPoolWorkerStatistics worker = pool.workerStatistics(iWorker);
+    nCompleted += worker.nCompleted;
+    if (worker.nCompleted > 0)
+    {
+      EXPECT_GE(worker.busyTime, worker.nCompleted * 100000u);
+    }
+    EXPECT_GT(worker.idleTime, 0u);
+  }
+  EXPECT_EQ(nCompleted, nTasks);
+
+  sps::IThreadPool* pThreadPool = nullptr;
+  sps::ThreadPoolCreate(&pThreadPool);
+  sps::ThreadPoolStatistics interfaceStatistics;
+  EXPECT_EQ(pThreadPool->StatisticsGet(&interfaceStatistics), 0);
+  EXPECT_EQ(interfaceStatistics.nSubmitted, 0u);
+  sps::ThreadPoolWorkerStatistics workerStatistics;
+  EXPECT_EQ(pThreadPool->WorkerStatisticsGet(0, &workerStatistics), 0);
+  EXPECT_LT(pThreadPool->WorkerStatisticsGet(100, &workerStatistics), 0);
+  sps::ThreadPoolDestroy(pThreadPool);
+}
+
+/**
+ * Test growing and shrinking a pool. Tasks queued on the deques of
+ * removed workers are handed over and still executed.
+ *
+ */
+TEST(threadpool_test, resize)
+{
+  for (const auto policy :
+    { sps::SchedulingPolicy::SharedQueue, sps::SchedulingPolicy::WorkStealing })
+  {
+    sps::ThreadPoolOptions options;
+    options.nThreads = 1;
+    options.scheduling = policy;
+    options.maxThreads = 4;
+    sps::ThreadPool pool(options);
+    EXPECT_EQ(pool.capacity(), 4u);
+    EXPECT_THROW(pool.resize(5), std::invalid_argument);
+
+    pool.resize(4);
+    EXPECT_EQ(pool.size(), 4u);
+
+    std::atomic<int> nCalls{ 0 };
+    std::vector<sps::ThreadPool::TaskFuture<void>> futures;
+    for (int i = 0; i < 8; i++)
+    {
+      futures.push_back(pool.submit(
+        [&]() -> void
+        {
+          for (int j = 0; j < 16; j++)
+          {
+            pool.post([&]() -> void { nCalls++; });
+          }
+        }));
+    }
+    for (auto& future : futures)
+    {
+      future.Get();
+    }
+    pool.resize(1);
+    EXPECT_EQ(pool.size(), 1u);
+    pool.submit([]() -> void {}).Get();
+    while (nCalls.load() < 8 * 16)
+    {
+      std::this_thread::yield();
+    }
+
+    // Resizing from a worker would join itself
+    EXPECT_THROW(pool.submit([&]() -> void { pool.resize(2); }).Get(), std::logic_error);
+
+    // Joining the last worker makes its counters final
+    pool.resize(0);
+    EXPECT_EQ(pool.size(), 0u);
+    EXPECT_EQ(pool.statistics().nCompleted, 8u + 8u * 16u + 2u);
+  }
+}
+
+/**
+ * Test that spinning workers execute tasks submitted in bursts and
+ * still park, when idle, and that the pool can be destroyed while
+ * workers spin.
+ *
+ */
+TEST(threadpool_test, idle_policies)
+{
+  for (const auto idle : { sps::IdlePolicy::Spin, sps::IdlePolicy::Adaptive })
+  {
+    sps::ThreadPoolOptions options;
+    options.nThreads = 2;
+    options.scheduling = sps::SchedulingPolicy::WorkStealing;
+    options.idle = idle;
+    options.nSpins = 256;
+    sps::ThreadPool pool(options);
+    EXPECT_TRUE(pool.idlePolicy() == idle || std::thread::hardware_concurrency() == 1);
+
+    int sum = 0;
+    for (int burst = 0; burst < 4; burst++)
+    {
+      for (int i = 0; i < 100; i++)
+      {
+        sum += pool.submitInline([](int a) -> int { return a; }, i).Get();
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(sum, 4 * 4950);
+    EXPECT_EQ(pool.submit([]() -> int { return 1; }).Get(), 1);
+  }
+}
+
 TEST(threadpool_test, interface_test)
 {
   MyUserData myData;
@@ -284,6 +1030,26 @@ TEST(threadpool_test, interface_test)
   sps::ThreadPoolCreate(&pThreadPool);
   pThreadPool->SubmitJob(&MyCallbackFunction, &myData);
   sps::ThreadPoolDestroy(pThreadPool);
+
+  // Batch of jobs on a resized pool
+  sps::ThreadPoolCreate(&pThreadPool, 2);
+  EXPECT_EQ(pThreadPool->Resize(1), 0);
+  EXPECT_EQ(pThreadPool->Resize(2), 0);
+  EXPECT_LT(pThreadPool->Resize(100000), 0);
+
+  const size_t nJobs = 100;
+  std::vector<int> values(nJobs, 0);
+  std::vector<sps::SimpleCallback> callbacks(
+    nJobs, [](void* pUserData) -> void { *static_cast<int*>(pUserData) += 1; });
+  std::vector<void*> userData(nJobs);
+  for (size_t i = 0; i < nJobs; i++)
+  {
+    userData[i] = &values[i];
+  }
+  EXPECT_EQ(pThreadPool->SubmitJobs(callbacks.data(), userData.data(), nJobs), 0);
+  EXPECT_EQ(std::count(values.begin(), values.end(), 1), static_cast<long>(nJobs));
+  EXPECT_EQ(pThreadPool->SubmitJobs(nullptr, nullptr, 0), 0);
+  sps::ThreadPoolDestroy(pThreadPool);
 }
 
 int main(int argc, char* argv[])